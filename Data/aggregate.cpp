@@ -0,0 +1,153 @@
+//
+//  aggregate.cpp
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#include <map>
+#include <cmath>
+#include <algorithm>
+#include "aggregate.h"
+#include "thread_pool.h"
+
+namespace ws::data::aggregate
+{
+	namespace
+	{
+		// result of a single chunk
+		struct partial
+		{
+			group total;
+			std::vector<group> rhumbs;
+			std::map<int32_t, group> bands;
+			std::array<std::array<std::size_t, bins>, 3> histogram;
+		};
+
+		void add(group & group, const sample & sample)
+		{
+			++group.count;
+			bool passed {true};
+			for (std::size_t i {}; i < 3; ++i)
+			{
+				group.failed[i] += sample.failed[i] ? 1 : 0;
+				passed = passed && !sample.failed[i];
+				group.errors[i].push(sample.errors[i]);
+				group.deviation[i].push(sample.deviation[i]);
+			}
+			group.passed += passed ? 1 : 0;
+		}
+
+		void merge(group & into, const group & from)
+		{
+			into.count += from.count;
+			into.passed += from.passed;
+			for (std::size_t i {}; i < 3; ++i)
+			{
+				into.failed[i] += from.failed[i];
+				into.errors[i].merge(from.errors[i]);
+				into.deviation[i].merge(from.deviation[i]);
+			}
+		}
+	}
+
+	report summarize(std::span<const sample> samples, uint32_t threads)
+	{
+		const std::size_t chunks {(samples.size() + chunk - 1) / chunk};
+		task_group tasks {threads, chunks};
+		auto part {[&samples](std::size_t i) { return samples.subspan(i * chunk, std::min(chunk, samples.size() - i * chunk)); }};
+
+		std::vector<partial> partials(chunks);
+		for (std::size_t i {}; i < chunks; ++i)
+		{
+			tasks.submit([&partials, &part, i]
+			{
+				partial & partial {partials[i]};
+				partial.rhumbs.resize(rhumbs);
+				for (const sample & sample : part(i))
+				{
+					add(partial.total, sample);
+					add(partial.rhumbs[rhumb(sample.heading)], sample);
+					add(partial.bands[band(sample.temperature)], sample);
+				}
+			});
+		}
+		tasks.wait();
+		// always in the order of chunks, so floating point sums are the same with any number of threads
+		report result {};
+		std::vector<group> by_rhumb(rhumbs);
+		std::map<int32_t, group> by_band;
+		for (const partial & partial : partials)
+		{
+			merge(result.total, partial.total);
+			for (uint32_t i {}; i < rhumbs; ++i)
+			{
+				merge(by_rhumb[i], partial.rhumbs[i]);
+			}
+			for (const auto & [band, group] : partial.bands)
+			{
+				merge(by_band[band], group);
+			}
+		}
+		for (uint32_t i {}; i < rhumbs; ++i)
+		{
+			if (by_rhumb[i].count) { result.rhumbs.emplace_back(i, by_rhumb[i]); }
+		}
+		result.bands.assign(by_band.begin(), by_band.end());
+
+		// histograms of deviations, bins are known only now
+		std::array<double, 3> low {};
+		std::array<double, 3> width {};
+		for (std::size_t axis {}; axis < 3; ++axis)
+		{
+			result.deviation[axis].summary = result.total.deviation[axis].get();
+			low[axis] = result.deviation[axis].summary.min;
+			width[axis] = (result.deviation[axis].summary.max - low[axis]) / static_cast<double>(bins);
+		}
+		for (std::size_t i {}; i < chunks; ++i)
+		{
+			tasks.submit([&partials, &part, &low, &width, i]
+			{
+				auto & histogram {partials[i].histogram};
+				for (const sample & sample : part(i))
+				{
+					for (std::size_t axis {}; axis < 3; ++axis)
+					{
+						// the maximum falls into the last bin, all values into the first one if they are equal
+						const double position {width[axis] > 0.0 ? (sample.deviation[axis] - low[axis]) / width[axis] : 0.0};
+						++histogram[axis][std::min(static_cast<std::size_t>(std::max(position, 0.0)), bins - 1)];
+					}
+				}
+			});
+		}
+		tasks.wait();
+		for (const partial & partial : partials)
+		{
+			for (std::size_t axis {}; axis < 3; ++axis)
+			{
+				for (std::size_t bin {}; bin < bins; ++bin)
+				{
+					result.deviation[axis].histogram[bin] += partial.histogram[axis][bin];
+				}
+			}
+		}
+		return result;
+	}
+
+	uint32_t rhumb(uint32_t heading)
+	{
+		// a rhumb spans half of its width either side of its bearing, so 355° is north: (heading + 5.625) / 11.25
+		return (heading % 360 * 8 + 45) / 90 % rhumbs;
+	}
+
+	double bearing(uint32_t rhumb)
+	{
+		return 360.0 * rhumb / rhumbs;
+	}
+
+	int32_t band(int32_t temperature)
+	{
+		// rounded down, so -5 is in the band from -10 to 0
+		return static_cast<int32_t>(std::floor(static_cast<double>(temperature) / band_width)) * band_width;
+	}
+}
@@ -0,0 +1,93 @@
+//
+//  aggregate.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <span>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include "statistics.h"
+
+// Statistics of a whole collection of files (see 'collection.h'), for acceptance reports over many units.
+// Every file is given as a 'sample': its heading, errors of angles in arc seconds, standard deviations of
+// the gyroscopes, mean temperature and which limits it exceeds. Samples are grouped by rhumb, one of 'rhumbs'
+// equal sectors of the compass centred on north and the points between, and by temperature band, every group keeps the number of files, how many passed and failed on each limit, and
+// running statistics of errors and deviations (see 'statistics.h'). Distributions of the deviations of every
+// axis get a histogram of equal bins between their minimum and maximum.
+//
+// Samples are cut into chunks of a fixed size and reduced in parallel (see 'thread_pool.h'), a chunk to its own
+// partial result; partial results are merged in the order of chunks on the calling thread. Chunks do not depend on
+// the number of threads, so the result is the same to the last bit however many threads computed it. Histograms
+// take a second pass, once the range of every axis is known.
+//
+// Group properties:
+// - count    : number of files;
+// - passed   : files within all limits;
+// - failed   : files over the limit of heading, roll and pitch error, in this order;
+// - errors   : running statistics of heading, roll and pitch errors in arc seconds, in this order;
+// - deviation: running statistics of deviations of gyroscopes X, Y and Z.
+//
+// Distribution properties:
+// - summary  : statistics of all deviations of the axis;
+// - histogram: number of deviations in each of 'bins' equal bins from the minimum to the maximum.
+//
+// Namespace behaviors:
+// - summarize(): group given samples with given number of threads, zero means one per hardware thread;
+// - rhumb()    : return the number of the rhumb of given heading in degrees, clockwise from 0 for north;
+// - bearing()  : return the heading in the middle of given rhumb in degrees;
+// - band()     : return the lowest temperature of the band of given temperature.
+
+namespace ws::data::aggregate
+{
+	// temperature bands are this many degrees wide
+	constexpr int32_t band_width {10};
+	// points of the compass, 11.25 degrees each
+	constexpr uint32_t rhumbs {32};
+	constexpr std::size_t bins {10};
+	// samples reduced by a single task, also the smallest number of samples worth a second thread
+	constexpr std::size_t chunk {8192};
+
+	struct sample
+	{
+		uint32_t heading;
+		int32_t temperature;
+		std::array<float, 3> errors;
+		std::array<float, 3> deviation;
+		std::array<bool, 3> failed;
+	};
+
+	struct group
+	{
+		std::size_t count;
+		std::size_t passed;
+		std::array<std::size_t, 3> failed;
+		std::array<statistics::running, 3> errors;
+		std::array<statistics::running, 3> deviation;
+	};
+
+	struct distribution
+	{
+		statistics::summary summary;
+		std::array<std::size_t, bins> histogram;
+	};
+
+	struct report
+	{
+		group total;
+		// number of the rhumb and its group, ascending, only rhumbs that were met
+		std::vector<std::pair<uint32_t, group>> rhumbs;
+		// the lowest temperature of the band and its group, ascending
+		std::vector<std::pair<int32_t, group>> bands;
+		std::array<distribution, 3> deviation;
+	};
+
+	report summarize(std::span<const sample>, uint32_t = 0);
+	uint32_t rhumb(uint32_t);
+	double bearing(uint32_t);
+	int32_t band(int32_t);
+}
@@ -0,0 +1,160 @@
+//
+//  allan.cpp
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#include <cmath>
+#include <algorithm>
+#include "allan.h"
+#include "thread_pool.h"
+
+namespace ws::data::allan
+{
+	namespace
+	{
+		// minimum of the curve of bias instability is sqrt(2 * ln(2) / π) of it
+		constexpr double flicker {0.664};
+		// largest distance of a slope of the curve from the slope of a noise term
+		constexpr double tolerance {0.25};
+
+		// θ[k], sum of the first k differences from the mean, θ[0] is zero
+		std::vector<double> integrate(std::span<const float> column)
+		{
+			double mean {};
+			for (const float value : column) { mean += value; }
+			mean /= static_cast<double>(std::max<std::size_t>(column.size(), 1));
+			std::vector<double> sums(column.size() + 1);
+			for (std::size_t i {}; i < column.size(); ++i)
+			{
+				sums[i + 1] = sums[i] + (static_cast<double>(column[i]) - mean);
+			}
+			return sums;
+		}
+
+		double deviation(const std::vector<double> & sums, std::size_t size)
+		{
+			const std::size_t terms {sums.size() - 2 * size};
+			const double * first {sums.data()};
+			const double * middle {first + size};
+			const double * last {first + 2 * size};
+			double squares[4] {};
+			std::size_t k {};
+			for (; k + 4 <= terms; k += 4)
+			{
+				for (std::size_t lane {}; lane < 4; ++lane)
+				{
+					const double difference {last[k + lane] - 2.0 * middle[k + lane] + first[k + lane]};
+					squares[lane] += difference * difference;
+				}
+			}
+			for (; k < terms; ++k)
+			{
+				const double difference {last[k] - 2.0 * middle[k] + first[k]};
+				squares[0] += difference * difference;
+			}
+			const double m {static_cast<double>(size)};
+			return std::sqrt((squares[0] + squares[1] + squares[2] + squares[3]) / (2.0 * m * m * static_cast<double>(terms)));
+		}
+	}
+
+	std::vector<std::size_t> sizes(std::size_t samples)
+	{
+		std::vector<std::size_t> result;
+		// the largest cluster size leaves room for two clusters
+		const std::size_t largest {samples > 0 ? (samples - 1) / 2 : 0};
+		for (std::size_t step {};; ++step)
+		{
+			const auto size {static_cast<std::size_t>(std::llround(std::pow(10.0, static_cast<double>(step) / per_decade)))};
+			if (size > largest) { break; }
+			if (result.empty() || result.back() != size) { result.push_back(size); }
+		}
+		return result;
+	}
+
+	curve compute(std::span<const float> column, double period)
+	{
+		return std::move(compute(std::span<const std::span<const float>>(&column, 1), period, 1).front());
+	}
+
+	std::vector<curve> compute(std::span<const std::span<const float>> columns, double period, uint32_t threads)
+	{
+		std::vector<curve> result(columns.size());
+		std::vector<std::vector<double>> sums(columns.size());
+		std::size_t longest {};
+		std::size_t points {};
+		for (std::size_t i {}; i < columns.size(); ++i)
+		{
+			for (const std::size_t size : sizes(columns[i].size()))
+			{
+				result[i].points.push_back(point {static_cast<double>(size) * period, 0.0, size});
+			}
+			longest = std::max(longest, columns[i].size());
+			points += result[i].points.size();
+		}
+		task_group tasks {threads, points, longest >= parallel};
+		for (std::size_t i {}; i < columns.size(); ++i)
+		{
+			tasks.submit([&sums, &columns, i] { sums[i] = integrate(columns[i]); });
+		}
+		tasks.wait();
+		for (std::size_t i {}; i < columns.size(); ++i)
+		{
+			for (point & point : result[i].points)
+			{
+				tasks.submit([&sums, &point, i] { point.deviation = deviation(sums[i], point.size); });
+			}
+		}
+		tasks.wait();
+		for (std::size_t i {}; i < columns.size(); ++i)
+		{
+			result[i].fitted = fit(result[i].points, columns[i].size());
+		}
+		return result;
+	}
+
+	coefficients fit(std::span<const point> points, std::size_t samples)
+	{
+		std::vector<point> usable;
+		for (const point & point : points)
+		{
+			if (samples / point.size >= clusters && point.deviation > 0.0) { usable.push_back(point); }
+		}
+		coefficients result {};
+		if (usable.empty()) { return result; }
+		const auto bottom {static_cast<std::size_t>(std::min_element(usable.begin(), usable.end(),
+			[](const point & a, const point & b) { return a.deviation < b.deviation; }) - usable.begin())};
+		result.bias_instability = usable[bottom].deviation / flicker;
+		// segment of the curve with slope closest to given one, the falling part is before the bottom, the growing after
+		auto closest {[&usable](std::size_t from, std::size_t to, double slope, double & deviation, double & tau)
+		{
+			double distance {tolerance};
+			bool found {};
+			for (std::size_t i {from}; i + 1 < to; ++i)
+			{
+				const double segment {std::log(usable[i + 1].deviation / usable[i].deviation) / std::log(usable[i + 1].tau / usable[i].tau)};
+				if (std::abs(segment - slope) <= distance)
+				{
+					distance = std::abs(segment - slope);
+					// middle of the segment on the log-log plot
+					deviation = std::sqrt(usable[i].deviation * usable[i + 1].deviation);
+					tau = std::sqrt(usable[i].tau * usable[i + 1].tau);
+					found = true;
+				}
+			}
+			return found;
+		}};
+		double deviation {};
+		double tau {};
+		if (closest(0, bottom + 1, -0.5, deviation, tau))
+		{
+			result.random_walk = deviation * std::sqrt(tau);
+		}
+		if (closest(bottom, usable.size(), 0.5, deviation, tau))
+		{
+			result.rate_random_walk = deviation * std::sqrt(3.0 / tau);
+		}
+		return result;
+	}
+}
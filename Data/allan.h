@@ -0,0 +1,69 @@
+//
+//  allan.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <span>
+#include <vector>
+#include <cstdint>
+
+// Allan deviation of a single column of data (see 'columns.h'), e.g. of a gyroscope, and noise terms read from
+// its curve. The deviation is the overlapping one: for cluster size 'm' samples (τ = m * period) it is
+//
+//     σ²(τ) = ∑(θ[k + 2m] - 2θ[k + m] + θ[k]) ^ 2 / (2 * m ^ 2 * (n - 2m + 1)),  k = 0 ... n - 2m
+//
+// where θ[k] is the sum of the first k samples. Sums are taken once per column in double, with the mean of
+// the column taken away so they stay small however long the recording is, then every cluster size costs one
+// pass over them, whatever its size. Cluster sizes grow by 'per_decade' steps per decade from one sample to
+// half of the column. Many columns are computed at once on a thread pool (see 'thread_pool.h'): first their
+// sums, a task per column, then a task per column and cluster size, all on the calling thread unless some column
+// has 'parallel' samples. Result does not depend on the number of threads.
+//
+// Noise terms are read from the points with at least 'clusters' whole clusters, the rest are too uncertain:
+// - random_walk     : angle random walk N, where the curve falls as N / √τ, i.e. its value at τ = 1 s;
+// - bias_instability: the flat bottom of the curve divided by 0.664;
+// - rate_random_walk: rate random walk K, where the curve grows as K * √(τ / 3), i.e. its value at τ = 3 s.
+// A term is zero if the curve has no part of its slope (±1/2 within 1/4) in the right place. Terms are in units
+// of the column times √s, units of the column and units of the column divided by √s.
+//
+// Namespace behaviors:
+// - sizes()  : return cluster sizes of the curve of given number of samples;
+// - compute(): return curve of given column, or curves of given columns with given number of threads, zero means
+//              one per hardware thread, 'period' is time between samples in seconds;
+// - fit()    : return noise terms of given points of a column of given number of samples.
+
+namespace ws::data::allan
+{
+	constexpr std::size_t per_decade {10};
+	constexpr std::size_t clusters {9};
+	constexpr std::size_t parallel {1 << 16};
+
+	struct point
+	{
+		double tau;
+		double deviation;
+		// cluster size in samples
+		std::size_t size;
+	};
+
+	struct coefficients
+	{
+		double random_walk;
+		double bias_instability;
+		double rate_random_walk;
+	};
+
+	struct curve
+	{
+		std::vector<point> points;
+		coefficients fitted;
+	};
+
+	std::vector<std::size_t> sizes(std::size_t);
+	curve compute(std::span<const float>, double = 1.0);
+	std::vector<curve> compute(std::span<const std::span<const float>>, double = 1.0, uint32_t = 0);
+	coefficients fit(std::span<const point>, std::size_t);
+}
@@ -0,0 +1,305 @@
+//
+//  archive.cpp
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#include <bit>
+#include <array>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+#include "archive.h"
+#include "record.h"
+
+namespace ws::data
+{
+	namespace
+	{
+		constexpr char magic[8] {'B', 'I', 'N', 'S', '.', 'A', 'R', 'C'};
+		constexpr uint32_t version {1};
+		// packed bits are read eight bytes at a time, the last word of the last column runs into these bytes
+		constexpr std::size_t padding {8};
+
+		static_assert(sizeof(archive::header) == 32 && sizeof(archive::block) == 32, "header and index entries are written as they are");
+		static_assert(schema::position(&row::count) == 0, "the column of 'count' is the first one of a block");
+
+		enum class encoding : uint8_t
+		{
+			XOR,
+			DELTA
+		};
+
+		struct column
+		{
+			encoding method;
+			uint8_t shift;
+			uint8_t width;
+			uint8_t reserved;
+			uint32_t first;
+		};
+		static_assert(sizeof(column) == 8);
+
+		// raw bits of a field as it is written to .dat file, narrow fields keep their low bytes
+		template <typename T>
+		uint32_t bits(const field<T> & field, const row & row)
+		{
+			const auto value {std::bit_cast<uint32_t>(row.*field.member)};
+			return field.width < sizeof(uint32_t) ? value & ((1u << (field.width * 8)) - 1) : value;
+		}
+
+		// small differences of either sign become small numbers: 0, -1, 1, -2, 2... go to 0, 1, 2, 3, 4...
+		uint32_t zigzag(uint32_t difference)
+		{
+			return (difference << 1) ^ static_cast<uint32_t>(static_cast<int32_t>(difference) >> 31);
+		}
+
+		uint32_t unzigzag(uint32_t value)
+		{
+			return (value >> 1) ^ (0u - (value & 1));
+		}
+
+		std::size_t packed_size(std::size_t values, uint8_t width)
+		{
+			return ((values - 1) * width + 7) / 8;
+		}
+
+		void encode_column(const uint32_t * values, std::size_t size, std::pmr::string & out)
+		{
+			uint32_t xors {};
+			uint32_t deltas {};
+			for (std::size_t i {1}; i < size; ++i)
+			{
+				xors |= values[i] ^ values[i - 1];
+				deltas |= zigzag(values[i] - values[i - 1]);
+			}
+			// bits set in any residual, trailing zeros common to all of them are not stored
+			auto fit {[](uint32_t any, column & column)
+			{
+				column.shift = any ? static_cast<uint8_t>(std::countr_zero(any)) : 0;
+				column.width = any ? static_cast<uint8_t>(std::bit_width(any) - column.shift) : 0;
+			}};
+			column xor_column {encoding::XOR, 0, 0, 0, values[0]};
+			column delta_column {encoding::DELTA, 0, 0, 0, values[0]};
+			fit(xors, xor_column);
+			fit(deltas, delta_column);
+			const column column {delta_column.width < xor_column.width ? delta_column : xor_column};
+			out.append(reinterpret_cast<const char *>(&column), sizeof(column));
+			if (!column.width) { return; }
+			const std::size_t begin {out.size()};
+			const std::size_t size_in_bytes {packed_size(size, column.width)};
+			// room for the last whole word, cut off below
+			out.resize(begin + size_in_bytes + sizeof(uint64_t));
+			char * packed {out.data() + begin};
+			for (std::size_t i {1}; i < size; ++i)
+			{
+				const uint32_t residual {column.method == encoding::XOR ? values[i] ^ values[i - 1] : zigzag(values[i] - values[i - 1])};
+				const std::size_t bit {(i - 1) * column.width};
+				uint64_t word {};
+				std::memcpy(&word, packed + bit / 8, sizeof(word));
+				word |= static_cast<uint64_t>(residual >> column.shift) << (bit % 8);
+				std::memcpy(packed + bit / 8, &word, sizeof(word));
+			}
+			out.resize(begin + size_in_bytes);
+		}
+
+		// every value is the previous one with the next residual applied, the method is chosen once per column
+		template <encoding method>
+		void unpack(const std::byte * data, const column & column, std::size_t size, uint32_t * values)
+		{
+			const uint64_t mask {(uint64_t {1} << column.width) - 1};
+			uint32_t value {column.first};
+			for (std::size_t i {1}; i < size; ++i)
+			{
+				const std::size_t bit {(i - 1) * column.width};
+				uint64_t word {};
+				std::memcpy(&word, data + bit / 8, sizeof(word));
+				const auto residual {static_cast<uint32_t>((word >> (bit % 8)) & mask) << column.shift};
+				if constexpr (method == encoding::XOR) { value ^= residual; }
+				else { value += unzigzag(residual); }
+				values[i] = value;
+			}
+		}
+
+		// returns the first byte after the column, nullptr if the column is malformed or runs past the end
+		const std::byte * decode_column(const std::byte * data, const std::byte * end, std::size_t size, uint32_t * values)
+		{
+			column column {};
+			if (end - data < static_cast<std::ptrdiff_t>(sizeof(column))) { return nullptr; }
+			std::memcpy(&column, data, sizeof(column));
+			data += sizeof(column);
+			if (column.method > encoding::DELTA || column.width + column.shift > 32) { return nullptr; }
+			const std::size_t size_in_bytes {packed_size(size, column.width)};
+			if (static_cast<std::size_t>(end - data) < size_in_bytes) { return nullptr; }
+			values[0] = column.first;
+			if (!column.width)
+			{
+				// a zero residual is the same value for both methods
+				std::fill(values, values + size, column.first);
+				return data;
+			}
+			column.method == encoding::XOR ? unpack<encoding::XOR>(data, column, size, values) : unpack<encoding::DELTA>(data, column, size, values);
+			return data + size_in_bytes;
+		}
+
+		const std::byte * skip_column(const std::byte * data, const std::byte * end, std::size_t size)
+		{
+			column column {};
+			if (end - data < static_cast<std::ptrdiff_t>(sizeof(column))) { return nullptr; }
+			std::memcpy(&column, data, sizeof(column));
+			data += sizeof(column);
+			const std::size_t size_in_bytes {packed_size(size, column.width)};
+			return column.width <= 32 && static_cast<std::size_t>(end - data) >= size_in_bytes ? data + size_in_bytes : nullptr;
+		}
+	}
+
+	archive::archive(std::pmr::memory_resource * resource) : m_rows(resource), m_blocks(resource), m_index(resource) {}
+
+	void archive::push(const row & row)
+	{
+		if (m_rows.capacity() < block_rows) { m_rows.reserve(block_rows); }
+		m_rows.push_back(row);
+		++m_size;
+		if (m_rows.size() == block_rows) { this->flush(); }
+	}
+
+	void archive::finish(std::string & out)
+	{
+		this->flush();
+		header header {};
+		std::memcpy(header.magic, magic, sizeof(magic));
+		header.version = version;
+		header.fields = schema::count;
+		header.rows = m_size;
+		header.block_rows = block_rows;
+		header.blocks = static_cast<uint32_t>(m_index.size());
+		out.reserve(out.size() + sizeof(header) + m_index.size() * sizeof(block) + m_blocks.size() + padding);
+		out.append(reinterpret_cast<const char *>(&header), sizeof(header));
+		out.append(reinterpret_cast<const char *>(m_index.data()), m_index.size() * sizeof(block));
+		out.append(m_blocks.data(), m_blocks.size());
+		out.append(padding, '\0');
+		m_blocks.clear();
+		m_index.clear();
+		m_size = 0;
+	}
+
+	bool archive::open(std::span<const std::byte> bytes)
+	{
+		m_index.clear();
+		m_size = 0;
+		m_data = nullptr;
+		header header {};
+		if (bytes.size() < sizeof(header) + padding) { return false; }
+		std::memcpy(&header, bytes.data(), sizeof(header));
+		if (std::memcmp(header.magic, magic, sizeof(magic)) || header.version != version || header.fields != schema::count ||
+			header.block_rows != block_rows || header.blocks != (header.rows + block_rows - 1) / block_rows)
+		{
+			return false;
+		}
+		const std::size_t index_size {static_cast<std::size_t>(header.blocks) * sizeof(block)};
+		if (bytes.size() < sizeof(header) + index_size + padding) { return false; }
+		m_index.resize(header.blocks);
+		std::memcpy(m_index.data(), bytes.data() + sizeof(header), index_size);
+		// blocks follow each other without gaps, every block but the last one is full
+		uint64_t offset {};
+		for (std::size_t i {}; i < m_index.size(); ++i)
+		{
+			const block & block {m_index[i]};
+			if (block.offset != offset || block.rows != std::min<uint64_t>(block_rows, header.rows - i * block_rows))
+			{
+				m_index.clear();
+				return false;
+			}
+			offset += block.size;
+		}
+		if (offset != bytes.size() - sizeof(header) - index_size - padding)
+		{
+			m_index.clear();
+			return false;
+		}
+		m_size = header.rows;
+		m_data = bytes.data() + sizeof(header) + index_size;
+		return true;
+	}
+
+	bool archive::decode(std::size_t index, const projection & projection, std::span<row> rows) const
+	{
+		if (index >= m_index.size() || rows.size() < m_index[index].rows) { return false; }
+		const block & block {m_index[index]};
+		const std::byte * data {m_data + block.offset};
+		const std::byte * end {data + block.size};
+		if (crc8(data, block.size) != block.crc8) { return false; }
+		std::array<uint32_t, block_rows> values;
+		const bool decoded {schema::all_of_enumerated([&](const auto & field, std::size_t i)
+		{
+			using type = typename std::remove_cvref_t<decltype(field)>::type;
+			if (!projection[i])
+			{
+				data = skip_column(data, end, block.rows);
+				return data != nullptr;
+			}
+			data = decode_column(data, end, block.rows, values.data());
+			if (!data) { return false; }
+			for (std::size_t j {}; j < block.rows; ++j)
+			{
+				rows[j].*field.member = std::bit_cast<type>(values[j]);
+			}
+			return true;
+		})};
+		return decoded && data == end;
+	}
+
+	std::size_t archive::seek(uint32_t count) const
+	{
+		std::array<uint32_t, block_rows> counts;
+		for (std::size_t i {}; i < m_index.size(); ++i)
+		{
+			const block & block {m_index[i]};
+			// no count of the block reaches the one sought
+			if (block.highest < count) { continue; }
+			if (block.first >= count) { return i * block_rows; }
+			const std::byte * data {m_data + block.offset};
+			if (!decode_column(data, data + block.size, block.rows, counts.data())) { return m_size; }
+			return i * block_rows + ws::data::seek(block.rows, count, [&counts](std::size_t j) { return counts[j]; });
+		}
+		return m_size;
+	}
+
+	std::size_t archive::size() const
+	{
+		return m_size;
+	}
+
+	std::size_t archive::blocks() const
+	{
+		return m_index.size();
+	}
+
+	void archive::flush()
+	{
+		if (m_rows.empty()) { return; }
+		block entry {m_blocks.size(), 0, static_cast<uint32_t>(m_rows.size()), 0, 0, 0, 0};
+		std::array<uint32_t, block_rows> values;
+		schema::for_each([this, &entry, &values](const auto & field)
+		{
+			for (std::size_t i {}; i < m_rows.size(); ++i)
+			{
+				values[i] = bits(field, m_rows[i]);
+			}
+			encode_column(values.data(), m_rows.size(), m_blocks);
+			if constexpr (std::is_same_v<decltype(field.member), uint32_t row:: *>)
+			{
+				if (field.member == &row::count)
+				{
+					entry.first = values[0];
+					entry.highest = *std::max_element(values.begin(), values.begin() + m_rows.size());
+				}
+			}
+		});
+		entry.size = static_cast<uint32_t>(m_blocks.size() - entry.offset);
+		entry.crc8 = crc8(reinterpret_cast<const std::byte *>(m_blocks.data() + entry.offset), entry.size);
+		m_index.push_back(entry);
+		m_rows.clear();
+	}
+}
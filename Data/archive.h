@@ -0,0 +1,99 @@
+//
+//  archive.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <span>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include "row.h"
+#include "schema.h"
+
+// Archive class is the codec of .arc files, a compressed columnar form of .dat records for long-term storage.
+// Rows are cut into blocks of 'block_rows' rows, every field of a block is kept as a column of raw bits of the
+// field, as wide as in .dat file (see 'schema.h'), so a file saved from an archive is the same as one saved
+// from the rows it was made of. A column keeps its first value and the residuals of the rest: either the xor
+// with the previous value, which leaves only low bits of the mantissa for a slowly varying float, or the
+// difference with it in zigzag form, which leaves a small number for a counter. The smaller of them is taken,
+// trailing zero bits common to all residuals are dropped and the rest are packed with the fewest bits that
+// fit them all, so a constant field takes no bits at all. An index after the header gives offset, size, number
+// of rows, checksum (see crc8() in 'record.h') and range of 'count' of every block, so a block is found and
+// decoded without touching others and a column out of projection is passed over by its size. All numbers are
+// little endian, same as in .dat files; eight zero bytes end the file, so packed bits are always read as whole words.
+//
+// File layout:
+// - header : magic "BINS.ARC", version, number of fields, number of rows, rows per block, number of blocks;
+// - index  : one entry per block, offsets are counted from the first byte after the index;
+// - blocks : columns in on-disk order of fields, each is method, shift, width, first value and packed residuals;
+// - padding: eight zero bytes.
+//
+// Class properties:
+// - m_rows   : rows of the block being written;
+// - m_blocks : encoded blocks written so far;
+// - m_index  : index entries of all blocks, written or read;
+// - m_size   : number of rows, written or read;
+// - m_data   : first byte of the blocks of an opened archive, the bytes are not owned.
+//
+// Class behaviors:
+// - push()   : add a row, a block is encoded as soon as it is full;
+// - finish() : encode the last block, append the whole archive to given buffer and start a new one;
+// - open()   : read the header and the index of an archive in given bytes, returns false if they are malformed;
+// - decode() : decode fields of given projection of a single block into given rows, returns false if the
+//              checksum of the block does not match or its columns are malformed;
+// - seek()   : return index of the first row whose 'count' is not less than given value, skipping blocks by
+//              their range of counts (see seek() in 'record.h'), size() if there is none;
+// - size()   : return number of rows;
+// - blocks() : return number of blocks;
+// - flush()  : encode rows of the block being written and add its index entry.
+
+namespace ws::data
+{
+	class archive
+	{
+	public:
+		static constexpr std::size_t block_rows {256};
+		struct header
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t fields;
+			uint64_t rows;
+			uint32_t block_rows;
+			uint32_t blocks;
+		};
+		struct block
+		{
+			uint64_t offset;
+			uint32_t size;
+			uint32_t rows;
+			uint32_t first;
+			uint32_t highest;
+			uint32_t crc8;
+			uint32_t reserved;
+		};
+	public:
+		explicit archive(std::pmr::memory_resource * = std::pmr::get_default_resource());
+	public:
+		void push(const row &);
+		void finish(std::string &);
+		bool open(std::span<const std::byte>);
+		bool decode(std::size_t, const projection &, std::span<row>) const;
+		std::size_t seek(uint32_t) const;
+		std::size_t size() const;
+		std::size_t blocks() const;
+	private:
+		void flush();
+	private:
+		std::pmr::vector<row> m_rows;
+		std::pmr::string m_blocks;
+		std::pmr::vector<block> m_index;
+		std::size_t m_size {};
+		const std::byte * m_data {};
+	};
+}
@@ -0,0 +1,117 @@
+//
+//  arena.cpp
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#include <cstdint>
+#include <algorithm>
+#include "arena.h"
+
+namespace ws::data
+{
+	namespace
+	{
+		// the buffer starts at a cache line and grows by whole 64 KiB steps
+		constexpr std::size_t buffer_alignment {64};
+		constexpr std::size_t buffer_step {64 << 10};
+	}
+
+	arena::arena(std::size_t capacity, std::pmr::memory_resource * upstream) : m_upstream(upstream)
+	{
+		if (capacity)
+		{
+			m_capacity = (capacity + buffer_step - 1) / buffer_step * buffer_step;
+			m_buffer = static_cast<std::byte *>(m_upstream->allocate(m_capacity, buffer_alignment));
+			++m_allocations;
+		}
+	}
+
+	arena::~arena()
+	{
+		this->release();
+		if (m_buffer) { m_upstream->deallocate(m_buffer, m_capacity, buffer_alignment); }
+	}
+
+	void arena::reset()
+	{
+		this->release();
+		if (m_peak > m_capacity)
+		{
+			if (m_buffer) { m_upstream->deallocate(m_buffer, m_capacity, buffer_alignment); }
+			m_capacity = (m_peak + buffer_step - 1) / buffer_step * buffer_step;
+			m_buffer = static_cast<std::byte *>(m_upstream->allocate(m_capacity, buffer_alignment));
+			++m_allocations;
+		}
+		m_used = 0;
+	}
+
+	void arena::trim(std::size_t limit)
+	{
+		this->reset();
+		if (m_capacity > limit)
+		{
+			m_upstream->deallocate(m_buffer, m_capacity, buffer_alignment);
+			m_buffer = nullptr;
+			m_capacity = 0;
+			m_peak = 0;
+		}
+	}
+
+	std::size_t arena::capacity() const
+	{
+		return m_capacity;
+	}
+
+	std::size_t arena::peak() const
+	{
+		return m_peak;
+	}
+
+	std::size_t arena::allocations() const
+	{
+		return m_allocations;
+	}
+
+	void * arena::do_allocate(std::size_t size, std::size_t alignment)
+	{
+		if (m_buffer)
+		{
+			const auto address {reinterpret_cast<std::uintptr_t>(m_buffer) + m_used};
+			const std::size_t used {m_used + ((alignment - address % alignment) % alignment)};
+			if (used + size <= m_capacity)
+			{
+				m_used = used + size;
+				m_peak = std::max(m_peak, m_used + m_overflowed);
+				return m_buffer + used;
+			}
+		}
+		void * pointer {m_upstream->allocate(size, alignment)};
+		m_overflow.push_back({pointer, size, alignment});
+		m_overflowed += size;
+		m_peak = std::max(m_peak, m_used + m_overflowed);
+		++m_allocations;
+		return pointer;
+	}
+
+	void arena::do_deallocate(void *, std::size_t, std::size_t)
+	{
+		// everything is given back at once by reset()
+	}
+
+	bool arena::do_is_equal(const std::pmr::memory_resource & other) const noexcept
+	{
+		return this == &other;
+	}
+
+	void arena::release()
+	{
+		for (const block & block : m_overflow)
+		{
+			m_upstream->deallocate(block.pointer, block.size, block.alignment);
+		}
+		m_overflow.clear();
+		m_overflowed = 0;
+	}
+}
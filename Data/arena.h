@@ -0,0 +1,76 @@
+//
+//  arena.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <memory_resource>
+
+// Arena class is a monotonic memory resource for containers of a file (see 'file.h') that is loaded, analyzed and
+// thrown away, one file after another, by the same thread. Allocations are cut one after another from a single
+// buffer, deallocation does nothing, reset() gives the whole buffer back at once. When the buffer is too small,
+// blocks are taken from the upstream resource, and the next reset() grows the buffer to the largest amount ever
+// used, so after the first few files the arena works without allocations at all. A buffer grown by one huge file
+// would be kept for good, so its owner calls trim() once a batch of files is done to give back a buffer larger
+// than it is worth keeping. Arena is not thread safe, every thread should have its own; it is neither copyable
+// nor movable, since containers keep a pointer to it.
+//
+// Class properties:
+// - m_upstream   : resource the buffer and overflow blocks are taken from;
+// - m_buffer     : start of the buffer;
+// - m_capacity   : size of the buffer in bytes;
+// - m_used       : bytes of the buffer given away since the last reset;
+// - m_overflow   : blocks taken from the upstream resource since the last reset;
+// - m_overflowed : bytes of those blocks;
+// - m_peak       : the largest number of bytes used between two resets;
+// - m_allocations: number of allocations from the upstream resource, the buffer included.
+//
+// Class behaviors:
+// - reset()      : free everything allocated from the arena, grow the buffer if it was too small;
+// - trim()       : reset the arena and free the buffer if it is larger than given size, the peak is forgotten then;
+// - capacity()   : return the 'm_capacity' member;
+// - peak()       : return the 'm_peak' member;
+// - allocations(): return the 'm_allocations' member.
+
+namespace ws::data
+{
+	class arena : public std::pmr::memory_resource
+	{
+	public:
+		explicit arena(std::size_t = 0, std::pmr::memory_resource * = std::pmr::get_default_resource());
+		arena(const arena &) = delete;
+		arena & operator = (const arena &) = delete;
+		~arena() override;
+	public:
+		void reset();
+		void trim(std::size_t);
+		std::size_t capacity() const;
+		std::size_t peak() const;
+		std::size_t allocations() const;
+	private:
+		void * do_allocate(std::size_t, std::size_t) override;
+		void do_deallocate(void *, std::size_t, std::size_t) override;
+		bool do_is_equal(const std::pmr::memory_resource &) const noexcept override;
+		void release();
+	private:
+		struct block
+		{
+			void * pointer;
+			std::size_t size;
+			std::size_t alignment;
+		};
+	private:
+		std::pmr::memory_resource * m_upstream;
+		std::byte * m_buffer {};
+		std::size_t m_capacity {};
+		std::size_t m_used {};
+		std::vector<block> m_overflow;
+		std::size_t m_overflowed {};
+		std::size_t m_peak {};
+		std::size_t m_allocations {};
+	};
+}
@@ -0,0 +1,149 @@
+//
+//  batch.cpp
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#include <cstdio>
+#include <format>
+#include <charconv>
+#include "batch.h"
+
+namespace ws::data
+{
+	int batch::run(int argc, char * argv[])
+	{
+		if (!this->parse(argc, argv))
+		{
+			fputs("Использование: BINS_workstation <папка или файл>... [--report файл] [--summary файл] [--allan файл] [--spectrum файл] [--convert] [--archive] [--threads n] [--txt] [--arc] [--cache] [--quiet]\n", stderr);
+			return static_cast<int>(status::USAGE);
+		}
+		// the greeting is meant for the console interface
+		while (!m_logger.empty()) { m_logger.extract(); }
+		if (m_cache && !m_collection.set_cache(cache::default_folder(), cache::default_capacity))
+		{
+			m_logger.log("Не удалось открыть папку кэша, файлы будут разобраны заново\n", logger::severity::WARNING);
+		}
+		bool inputs {true};
+		// messages of loading and converting many files are printed while they run, so the logger does not fill up
+		auto show {[this](logger::severity severity, const std::string & message) { this->show(severity, message); }};
+		const bool analyze {!m_report.empty() || !m_summary.empty() || !m_allan.empty() || !m_spectrum.empty()};
+		for (const auto & input : m_inputs)
+		{
+			// std::filesystem could throw if the path is not valid on this system
+			try
+			{
+				if (std::filesystem::is_directory(input))
+				{
+					if (analyze)
+					{
+						m_logger.drain([this, &input, &inputs] { inputs = m_collection.add_all(input, m_logger) && inputs; }, show);
+					}
+					if (m_convert)
+					{
+						m_logger.drain([this, &input, &inputs] { inputs = m_collection.convert_all(input, m_logger, m_target) && inputs; }, show);
+					}
+				}
+				else if (std::filesystem::is_regular_file(input))
+				{
+					if (analyze) { inputs = m_collection.add(input, m_logger) && inputs; }
+					if (m_convert) { inputs = m_collection.convert(input, m_logger, m_target) && inputs; }
+				}
+				else
+				{
+					m_logger.log(std::format("Нет такой папки или файла \"{}\"\n", input.string()), logger::severity::FAILURE);
+					inputs = false;
+				}
+			}
+			catch (const std::exception &)
+			{
+				m_logger.log(std::format("Ошибка при обработке \"{}\"\n", input.string()), logger::severity::FAILURE);
+				inputs = false;
+			}
+			this->get_logs();
+		}
+		if (!m_report.empty())
+		{
+			const bool saved {std::filesystem::path(m_report).extension() == ".json"
+							  ? m_collection.save_json(m_report, m_logger)
+							  : m_collection.save_data(m_report, m_logger)};
+			this->get_logs();
+			if (!saved) { return static_cast<int>(status::OUTPUT); }
+		}
+		if (!m_summary.empty())
+		{
+			const bool saved {m_collection.save_summary(m_summary, m_logger)};
+			this->get_logs();
+			if (!saved) { return static_cast<int>(status::OUTPUT); }
+		}
+		if (!m_allan.empty())
+		{
+			const bool saved {m_collection.save_allan(m_allan, m_logger)};
+			this->get_logs();
+			if (!saved) { return static_cast<int>(status::OUTPUT); }
+		}
+		if (!m_spectrum.empty())
+		{
+			const bool saved {m_collection.save_spectrum(m_spectrum, m_logger)};
+			this->get_logs();
+			if (!saved) { return static_cast<int>(status::OUTPUT); }
+		}
+		return static_cast<int>(inputs ? status::SUCCESS : status::INPUT);
+	}
+
+	bool batch::parse(int argc, char * argv[])
+	{
+		for (int i {1}; i < argc; ++i)
+		{
+			const std::string_view argument {argv[i]};
+			if (argument == "--convert") { m_convert = true; }
+			else if (argument == "--archive")
+			{
+				m_convert = true;
+				m_target = extension::ARC;
+			}
+			else if (argument == "--quiet") { m_quiet = true; }
+			else if (argument == "--cache") { m_cache = true; }
+			else if (argument == "--txt") { m_collection.set_extension(extension::TXT); }
+			else if (argument == "--arc") { m_collection.set_extension(extension::ARC); }
+			else if (argument == "--report" || argument == "--summary" || argument == "--allan" || argument == "--spectrum" ||
+					 argument == "--threads")
+			{
+				if (++i == argc) { return false; }
+				if (argument == "--report") { m_report = argv[i]; continue; }
+				if (argument == "--summary") { m_summary = argv[i]; continue; }
+				if (argument == "--allan") { m_allan = argv[i]; continue; }
+				if (argument == "--spectrum") { m_spectrum = argv[i]; continue; }
+				uint32_t threads {};
+				const std::string_view value {argv[i]};
+				if (std::from_chars(value.data(), value.data() + value.size(), threads).ec != std::errc {}) { return false; }
+				m_collection.set_threads(threads);
+			}
+			else if (argument.starts_with("--")) { return false; }
+			else { m_inputs.emplace_back(argument); }
+		}
+		return !m_inputs.empty() && (m_convert || !m_report.empty() || !m_summary.empty() || !m_allan.empty() ||
+										 !m_spectrum.empty());
+	}
+
+	void batch::get_logs()
+	{
+		while (!m_logger.empty())
+		{
+			logger::severity severity {};
+			const std::string message {m_logger.extract(severity)};
+			this->show(severity, message);
+		}
+	}
+
+	void batch::show(logger::severity severity, const std::string & message) const
+	{
+		// failures are printed even when quiet, one message per line whether it ends with a new line or not
+		if (!m_quiet || severity == logger::severity::FAILURE)
+		{
+			fputs(message.c_str(), stderr);
+			if (!message.ends_with('\n')) { fputc('\n', stderr); }
+		}
+	}
+}
@@ -0,0 +1,88 @@
+//
+//  batch.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <string>
+#include <vector>
+#include <filesystem>
+#include "collection.h"
+
+// Batch class runs the program without the console interface, for scripts and unattended machines: folders
+// and files given on the command line are added (see 'collection.h') or converted, and the report is written
+// to the given file, as .json (see file_collection::save_json()) if its extension is '.json', else the same
+// as the 'save' menu writes. Nothing is drawn, messages of the logger go to stderr, only failures if '--quiet'
+// is given, those of adding and converting a folder as soon as they are logged. The result is the exit code
+// of the program (see 'status').
+//
+// Usage: BINS_workstation <folder or file>... [--report file] [--summary file] [--allan file] [--spectrum file] [--convert]
+//        [--archive] [--threads n] [--txt] [--arc] [--cache] [--quiet]
+// - --report  : where to write the report, required unless '--convert', '--summary', '--allan' or '--spectrum' is given;
+// - --summary : where to write statistics of all files as .json (see file_collection::save_summary());
+// - --allan   : where to write noise terms of gyroscopes of all files as a table (see file_collection::save_allan());
+// - --spectrum: where to write spectra of all files as a table (see file_collection::save_spectrum());
+// - --convert : convert .dat files to .txt instead of adding them, or as well if '--report' is given;
+// - --archive : same as '--convert', but to .arc archives (see 'archive.h');
+// - --threads : number of threads to load files, zero means one per hardware thread (default);
+// - --txt     : add .txt files instead of .dat;
+// - --arc     : add .arc files instead of .dat;
+// - --cache   : keep images of parsed files in the default cache folder (see 'cache.h'), so the next run over
+//               the same files does not parse them again.
+//
+// Class properties:
+// - m_inputs    : folders and files to process;
+// - m_report    : report file, empty if not asked for;
+// - m_summary   : summary file, empty if not asked for;
+// - m_allan     : file of noise terms, empty if not asked for;
+// - m_spectrum  : file of spectra, empty if not asked for;
+// - m_convert   : convert inputs;
+// - m_target    : format inputs are converted to;
+// - m_cache     : use the cache of parsed files;
+// - m_quiet     : print only failures of the logger;
+// - m_logger    : an instance of logger class (see 'logger.h');
+// - m_collection: an instance of file_collection class (see 'collection.h').
+//
+// Class behaviors:
+// - run()     : parse arguments and process inputs, returns the exit code;
+// - parse()   : read arguments to class properties, returns false if they are wrong;
+// - get_logs(): print messages stored in 'm_logger';
+// - show()    : print a single message of given severity unless it is quiet.
+
+namespace ws::data
+{
+	class batch
+	{
+	public:
+		enum class status : int
+		{
+			SUCCESS = 0,
+			// wrong arguments, nothing was done
+			USAGE = 1,
+			// some inputs do not exist, have no files or could not be loaded or converted
+			INPUT = 2,
+			// report could not be written
+			OUTPUT = 3
+		};
+	public:
+		int run(int, char * []);
+	private:
+		bool parse(int, char * []);
+		void get_logs();
+		void show(logger::severity, const std::string &) const;
+	private:
+		std::vector<std::filesystem::path> m_inputs;
+		std::string m_report;
+		std::string m_summary;
+		std::string m_allan;
+		std::string m_spectrum;
+		bool m_convert {};
+		extension m_target {extension::TXT};
+		bool m_cache {};
+		bool m_quiet {};
+		logger m_logger;
+		file_collection m_collection;
+	};
+}
@@ -0,0 +1,1054 @@
+//
+//  benchmark.cpp
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <format>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <random>
+#include <bit>
+#include <numbers>
+#include <algorithm>
+#include <filesystem>
+#include "aggregate.h"
+#include "allan.h"
+#include "arena.h"
+#include "file.h"
+#include "collection.h"
+#include "integrity.h"
+#include "record.h"
+#include "spectrum.h"
+#include "statistics.h"
+#include "store.h"
+#include "writer.h"
+
+// Benchmark suite of every stage of the program: loading .dat, .txt and .arc files with each loader and storage,
+// analysis of a single column, file_collection::add_all() (load and analyze) with and without the cache
+// (see 'cache.h') and the manifest (see 'manifest.h'), convert_all(), file::save(), save_data(), statistics
+// of a large collection (see 'aggregate.h'), Allan deviation (see 'allan.h') and spectra (see 'spectrum.h') of a
+// long recording and spectra of the corpus.
+// Every case runs over several corpora: the bundled files (by default 'test files' near the executable) and
+// synthetic corpora made of them at every given scale: 'many' has 'scale' copies of every file, 'long' has
+// every file 'scale' times longer. All corpora are built in a temporary folder and removed at the end.
+// A case runs a given number of times over the whole corpus (fewer times over larger corpora), total time
+// is reported as rows/s, MB/s of source data and ns/row. Rows are analyzed files for save_data() and values
+// for column cases. Heap allocations per run and peak resident memory of every case are reported too (peak
+// memory only on Linux, where it could be reset before a case). Results could be written to a JSON file and compared with a JSON file of an earlier run.
+// Before timing, the bundled files are used to check that both .dat loaders, both .txt loaders, columnar
+// storage and both .txt writers give the same results, an archive saved back as .dat is the same file and spectra
+// are the same as by a plain discrete Fourier transform; the former implementations of the deviation and of the
+// .txt writer and the plain transform are timed too, as 'legacy' cases.
+//
+// Usage: BINS_benchmark [folder] [--repeats n] [--scale n]... [--case text] [--json file] [--baseline file]
+// - folder    : folder with .dat files, 'test files' by default;
+// - --repeats : number of runs over the bundled corpus, 20 by default;
+// - --scale   : scale of synthetic corpora, could be given several times, 4 and 16 by default, 0 for none;
+// - --case    : run only cases which name contains given text;
+// - --json    : write results to given file;
+// - --baseline: print how much faster every case is than in given file written with --json.
+
+// every heap allocation of the program is counted
+namespace
+{
+	std::atomic<std::size_t> allocations;
+}
+
+void * operator new(std::size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void * pointer {std::malloc(size ? size : 1)}) { return pointer; }
+	throw std::bad_alloc {};
+}
+
+void operator delete(void * pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void * pointer, std::size_t) noexcept
+{
+	std::free(pointer);
+}
+
+// memory resources of the standard library (see 'arena.h') allocate with given alignment
+void * operator new(std::size_t size, std::align_val_t alignment)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	const auto align {static_cast<std::size_t>(alignment)};
+	if (void * pointer {std::aligned_alloc(align, (size + align - 1) / align * align + (size ? 0 : align))}) { return pointer; }
+	throw std::bad_alloc {};
+}
+
+void operator delete(void * pointer, std::align_val_t) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void * pointer, std::size_t, std::align_val_t) noexcept
+{
+	std::free(pointer);
+}
+
+namespace
+{
+	void print(const std::string_view string)
+	{
+		fputs(std::string(string).c_str(), stdout);
+		fflush(stdout);
+	}
+
+	// same fields as file_collection::ingest() loads
+	const ws::data::projection analyzed {ws::data::schema::select(&ws::data::row::count, &ws::data::row::thdg, &ws::data::row::roll,
+																  &ws::data::row::pitch, &ws::data::row::gyro_X, &ws::data::row::gyro_Y,
+																  &ws::data::row::gyro_Z, &ws::data::row::acc_X, &ws::data::row::acc_Y,
+																  &ws::data::row::acc_Z, &ws::data::row::F_dith_X, &ws::data::row::F_dith_Y,
+																  &ws::data::row::F_dith_Z, &ws::data::row::gyro_X_temperature,
+																  &ws::data::row::gyro_Y_temperature, &ws::data::row::gyro_Z_temperature)};
+
+	struct corpus
+	{
+		std::string name;
+		std::filesystem::path folder;
+		std::vector<std::filesystem::path> files;
+		std::uintmax_t bytes;
+		std::size_t rows;
+		uint32_t repeats;
+	};
+
+	struct result
+	{
+		std::string corpus;
+		std::string name;
+		std::size_t files;
+		std::size_t rows;
+		std::uintmax_t bytes;
+		uint32_t repeats;
+		double seconds;
+		std::size_t allocations;
+		std::size_t peak;
+	};
+
+	// peak resident memory of the process in KiB, it starts from the current one again after reset
+	void reset_peak()
+	{
+		std::ofstream {"/proc/self/clear_refs"} << "5";
+	}
+
+	std::size_t peak()
+	{
+		std::ifstream fin {"/proc/self/status"};
+		std::string line;
+		while (std::getline(fin, line))
+		{
+			if (line.starts_with("VmHWM:")) { return std::stoull(line.substr(6)); }
+		}
+		return 0;
+	}
+
+	// records of the source repeated 'passes' times, 'count' goes on from pass to pass, so it is still a single recording
+	bool stretch(const std::filesystem::path & source, const std::filesystem::path & target, uint32_t passes)
+	{
+		ws::data::record_view view;
+		if (!view.open(source.string())) { return false; }
+		constexpr auto count {ws::data::schema::find<&ws::data::row::count>()};
+		constexpr auto crc {ws::data::schema::find<&ws::data::row::crc8>()};
+		ws::data::writer fout;
+		if (!fout.open(target.string(), true)) { return false; }
+		std::array<std::byte, ws::data::schema::size> bytes;
+		for (uint32_t pass {}; pass < passes; ++pass)
+		{
+			for (std::size_t i {}; i < view.size(); ++i)
+			{
+				std::memcpy(bytes.data(), view[i].data(), bytes.size());
+				// 'count' is 2 bytes wide, very long recordings wrap around
+				const auto value {static_cast<uint16_t>(view[i].get<&ws::data::row::count>() + pass * view.size())};
+				std::memcpy(bytes.data() + count.offset, &value, count.width);
+				bytes[crc.offset] = static_cast<std::byte>(ws::data::crc8(bytes.data(), crc.offset));
+				fout.write(std::string_view(reinterpret_cast<const char *>(bytes.data()), bytes.size()));
+			}
+		}
+		return fout.close();
+	}
+
+	std::vector<std::filesystem::path> list(const std::filesystem::path & folder, ws::data::extension extension)
+	{
+		std::vector<std::filesystem::path> files;
+		for (const auto & entry : std::filesystem::recursive_directory_iterator(folder))
+		{
+			if (entry.is_regular_file() && entry.path().extension().string() == extension)
+			{
+				files.push_back(entry.path());
+			}
+		}
+		std::sort(files.begin(), files.end());
+		return files;
+	}
+
+	corpus describe(const std::string & name, const std::filesystem::path & folder, uint32_t repeats)
+	{
+		corpus corpus {name, folder, list(folder, ws::data::extension::DAT), 0, 0, repeats};
+		for (const auto & path : corpus.files)
+		{
+			corpus.bytes += std::filesystem::file_size(path);
+			ws::data::record_view view;
+			if (view.open(path.string())) { corpus.rows += view.size(); }
+		}
+		return corpus;
+	}
+
+	class suite
+	{
+	public:
+		explicit suite(std::string filter) : m_filter(std::move(filter)) {}
+	public:
+		// 'function' does one run of the case and returns number of rows it processed
+		template <typename F>
+		void run(const corpus & corpus, const std::string_view name, std::uintmax_t bytes, F function)
+		{
+			if (!m_filter.empty() && name.find(m_filter) == std::string_view::npos) { return; }
+			std::size_t rows {};
+			reset_peak();
+			const std::size_t allocated {allocations.load()};
+			auto begin {std::chrono::steady_clock::now()};
+			for (uint32_t i {}; i < corpus.repeats; ++i)
+			{
+				rows += function();
+			}
+			double seconds {std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count()};
+			m_results.push_back({corpus.name, std::string(name), corpus.files.size(), rows, bytes * corpus.repeats, corpus.repeats, seconds,
+								 (allocations.load() - allocated) / corpus.repeats, peak()});
+			const result & result {m_results.back()};
+			print(std::format("{:<24}{:>10.3f} s{:>14.0f} rows/s{:>10.1f} MB/s{:>12.1f} ns/row{:>10} allocs{:>10} KiB\n",
+							  name, seconds, rows / seconds, megabytes(result) / seconds, seconds * 1e9 / rows, result.allocations, result.peak));
+		}
+		bool save(const std::filesystem::path & path) const
+		{
+			ws::data::writer fout;
+			if (!fout.open(path.string())) { return false; }
+			// one result per line, so files could be compared line by line too
+			fout.print("{{\n\"results\": [\n");
+			for (std::size_t i {}; i < m_results.size(); ++i)
+			{
+				const result & result {m_results[i]};
+				fout.print("{{\"corpus\": \"{}\", \"case\": \"{}\", \"files\": {}, \"rows\": {}, \"bytes\": {}, \"repeats\": {}, "
+						   "\"seconds\": {:.6f}, \"rows_per_second\": {:.1f}, \"megabytes_per_second\": {:.3f}, \"ns_per_row\": {:.3f}, "
+						   "\"allocations\": {}, \"peak_kib\": {}}}{}\n",
+						   result.corpus, result.name, result.files, result.rows, result.bytes, result.repeats, result.seconds,
+						   result.rows / result.seconds, megabytes(result) / result.seconds, result.seconds * 1e9 / result.rows,
+						   result.allocations, result.peak,
+						   i + 1 < m_results.size() ? "," : "");
+			}
+			fout.print("]\n}}\n");
+			return fout.close();
+		}
+		void compare(const std::filesystem::path & path) const
+		{
+			std::ifstream fin {path};
+			if (!fin.is_open())
+			{
+				print(std::format("No such file \"{}\"\n", path.string()));
+				return;
+			}
+			// values are read back from the lines written by save()
+			auto value {[](const std::string & line, const std::string_view key)
+			{
+				const std::string pattern {std::format("\"{}\": ", key)};
+				const std::size_t begin {line.find(pattern)};
+				if (begin == std::string::npos) { return std::string(); }
+				std::size_t first {begin + pattern.size()};
+				std::size_t last {line.find_first_of(",}", first)};
+				std::string text {line.substr(first, last - first)};
+				text.erase(std::remove(text.begin(), text.end(), '"'), text.end());
+				return text;
+			}};
+			print(std::format("\ncompared with \"{}\"\n", path.string()));
+			std::string line;
+			while (std::getline(fin, line))
+			{
+				const std::string corpus {value(line, "corpus")};
+				const std::string name {value(line, "case")};
+				const std::string time {value(line, "ns_per_row")};
+				if (corpus.empty() || name.empty() || time.empty()) { continue; }
+				for (const result & result : m_results)
+				{
+					if (result.corpus == corpus && result.name == name)
+					{
+						const double speedup {std::stod(time) / (result.seconds * 1e9 / result.rows)};
+						print(std::format("{:<10}{:<24}{:>12.1f} ns/row{:>12.1f} ns/row{:>8.2f}x\n",
+										  corpus, name, std::stod(time), result.seconds * 1e9 / result.rows, speedup));
+					}
+				}
+			}
+		}
+	private:
+		static double megabytes(const result & result)
+		{
+			return static_cast<double>(result.bytes) / (1024.0 * 1024.0);
+		}
+	private:
+		std::string m_filter;
+		std::vector<result> m_results;
+	};
+
+	// one table lookup per byte, as crc8() was before it folded eight bytes at once
+	uint8_t legacy_crc8(const std::byte * data, std::size_t size)
+	{
+		uint8_t crc {};
+		for (std::size_t i {}; i < size; ++i)
+		{
+			crc = ws::data::crc8_table[0][crc ^ static_cast<uint8_t>(data[i])];
+		}
+		return crc;
+	}
+
+	// former file_collection::deviation(): mean first, then vector of squared differences, all in float
+	float legacy_deviation(std::span<const float> column)
+	{
+		float sum {};
+		for (auto value : column) { sum += value; }
+		float average {sum / column.size()};
+		std::vector<float> difference;
+		difference.reserve(column.size());
+		for (auto value : column)
+		{
+			difference.push_back(static_cast<float>(std::pow(value - average, 2)));
+		}
+		sum = 0.0f;
+		for (auto value : difference) { sum += value; }
+		return std::sqrt(sum / (column.size() - 1));
+	}
+
+	// density of the same segments as spectrum::welch() by a plain discrete Fourier transform of every segment,
+	// sines and cosines are taken from a table
+	std::vector<double> legacy_density(std::span<const float> column, double period)
+	{
+		const std::size_t length {std::min(ws::data::spectrum::segment, std::bit_floor(column.size()))};
+		if (column.size() < ws::data::spectrum::shortest) { return {}; }
+		const std::size_t segments {(column.size() - length) / (length / 2) + 1};
+		// a segment is never longer than spectrum::segment
+		std::array<double, ws::data::spectrum::segment> window {};
+		std::array<double, ws::data::spectrum::segment> cosine {};
+		std::array<double, ws::data::spectrum::segment> sine {};
+		std::array<double, ws::data::spectrum::segment> samples {};
+		double power {};
+		for (std::size_t i {}; i < length; ++i)
+		{
+			const double angle {2.0 * std::numbers::pi * static_cast<double>(i) / static_cast<double>(length)};
+			window[i] = 0.5 - 0.5 * std::cos(angle);
+			cosine[i] = std::cos(angle);
+			sine[i] = std::sin(angle);
+			power += window[i] * window[i];
+		}
+		std::vector<double> density(length / 2 + 1);
+		for (std::size_t segment {}; segment < segments; ++segment)
+		{
+			const std::span<const float> data {column.subspan(segment * (length / 2), length)};
+			double mean {};
+			for (const float value : data) { mean += value; }
+			mean /= static_cast<double>(length);
+			for (std::size_t i {}; i < length; ++i) { samples[i] = (data[i] - mean) * window[i]; }
+			for (std::size_t k {}; k < density.size(); ++k)
+			{
+				double real {};
+				double imaginary {};
+				for (std::size_t i {}; i < length; ++i)
+				{
+					real += samples[i] * cosine[k * i % length];
+					imaginary -= samples[i] * sine[k * i % length];
+				}
+				const bool paired {k > 0 && k < length / 2};
+				density[k] += (real * real + imaginary * imaginary) * period / (power * static_cast<double>(segments)) * (paired ? 2.0 : 1.0);
+			}
+		}
+		return density;
+	}
+
+	// former file::save<extension::TXT>(): a temporary string and a stream call for every value
+	bool legacy_save(const ws::data::file & file, const std::string & filename)
+	{
+		std::ofstream fout {filename, std::ios_base::out};
+		if (!fout.is_open()) { return false; }
+		for (const ws::data::row & row : file.get_data())
+		{
+			fout << std::format("{}\t", row.count);
+			fout << std::format("{}\t", row.mode);
+			fout << std::format("{}\t", row.system_time);
+			fout << std::format("{}\t", row.mode_time);
+			fout << std::format("{: .5f}\t", row.pitch);
+			fout << std::format("{: .5f}\t", row.roll);
+			fout << std::format("{: .2f}\t", row.heading);
+			fout << std::format("{: .5f}\t", row.azimuth);
+			fout << std::format("{: .5f}\t", row.thdg);
+			fout << std::format("{: .5f}\t", row.latitude);
+			fout << std::format("{: .5f}\t", row.longtitude);
+			fout << std::format("{: .2f}\t", row.H);
+			fout << std::format("{: .5f}\t{: .5f}\t{: .5f}\t", row.Ve, row.Vn, row.Vu);
+			fout << std::format("{: .5f}\t{: .5f}\t{: .5f}\t", row.dAt_X, row.dAt_Y, row.dAt_Z);
+			fout << std::format("{: .5f}\t{: .5f}\t{: .5f}\t", row.dVt_X, row.dVt_Y, row.dVt_Z);
+			fout << std::format("{: .2f}\t{: .2f}\t{: .2f}\t", row.gyro_X, row.gyro_Y, row.gyro_Z);
+			fout << std::format("{: .5f}\t{: .5f}\t{: .5f}\t", row.acc_X, row.acc_Y, row.acc_Z);
+			fout << std::format("{: .2f}\t{: .2f}\t{: .2f}\t", row.U_cplc_X, row.U_cplc_Y, row.U_cplc_Z);
+			fout << std::format("{: .2f}\t{: .2f}\t{: .2f}\t", row.U_hfo_X, row.U_hfo_Y, row.U_hfo_Z);
+			fout << std::format("{: .1f}\t{: .1f}\t{: .1f}\t", row.F_out_X, row.F_out_Y, row.F_out_Z);
+			fout << std::format("{: .1f}\t{: .1f}\t{: .1f}\t", row.F_dith_X, row.F_dith_Y, row.F_dith_Z);
+			fout << std::format("{}\t{}\t{}\t", row.gyro_X_temperature, row.gyro_Y_temperature, row.gyro_Z_temperature);
+			fout << std::format("{}\t{}\t{}\t", row.acc_X_temperature, row.acc_Y_temperature, row.acc_Z_temperature);
+			fout << std::format("{}\t{}\t{}\t", row.dpb_X_temperature, row.dpb_Y_temperature, row.dpb_Z_temperature);
+			fout << std::format("{: .0f}\t{: .0f}\t{: .0f}\t", row.drift_X, row.drift_Y, row.drift_Z);
+			fout << std::format("{}\t", row.faults);
+			fout << std::format("{: .2f}\t{: .2f}\t{: .2f}\t{: .2f}\t{: .2f}\t{: .2f}\t", row.D12, row.D13, row.D21, row.D23, row.D31, row.D32);
+			fout << std::format("{: .5f}\t{: .5f}\t{: .5f}\t", row.Mg1, row.Mg2, row.Mg3);
+			fout << std::format("{: .5f}\t{: .5f}\t{: .5f}\t", row.Wo1, row.Wo2, row.Wo3);
+			fout << std::format("{: .5f}\t{: .5f}\t{: .5f}\t{: .5f}\t{: .5f}\t{: .5f}\t", row.E12, row.E13, row.E21, row.E23, row.E31, row.E32);
+			fout << std::format("{: .1f}\t{: .1f}\t{: .5f}\t", row.Ma1, row.Ma2, row.Ma3);
+			fout << std::format("{: .5f}\t{: .5f}\t{: .5f}\t", row.Ao1, row.Ao2, row.Ao3);
+			fout << std::format("{}\t", row.reserve);
+			fout << std::format("{}\t", row.crc8);
+			fout << std::format("{}\n", row.error);
+		}
+		return !fout.bad();
+	}
+
+	std::string read_all(const std::filesystem::path & path)
+	{
+		std::ifstream fin {path, std::ios_base::in | std::ios_base::binary};
+		return std::string {std::istreambuf_iterator<char> {fin}, std::istreambuf_iterator<char> {}};
+	}
+
+	bool same_rows(const std::filesystem::path & path)
+	{
+		ws::data::file stream;
+		ws::data::file mapped;
+		bool stream_loaded {stream.load<ws::data::extension::DAT, ws::data::loader::STREAM>(path.string())};
+		bool mapped_loaded {mapped.load<ws::data::extension::DAT, ws::data::loader::MAPPED>(path.string())};
+		if (stream_loaded != mapped_loaded) { return false; }
+		if (stream.get_data().size() != mapped.get_data().size()) { return false; }
+		// 'row' has no padding, so rows could be compared bytewise
+		if (std::memcmp(stream.get_data().data(), mapped.get_data().data(), stream.get_data().size() * sizeof(ws::data::row)) != 0)
+		{
+			return false;
+		}
+		// rows gathered back from columnar storage must be the same too
+		ws::data::file columns {ws::data::storage::COLUMNS};
+		columns.load<ws::data::extension::DAT, ws::data::loader::MAPPED>(path.string());
+		for (std::size_t i {}; i < columns.size(); ++i)
+		{
+			ws::data::row row {columns.at(i)};
+			if (std::memcmp(&row, &stream.get_data()[i], sizeof(ws::data::row)) != 0) { return false; }
+		}
+		return columns.size() == stream.get_data().size();
+	}
+
+	// keeps results of cases that read values without storing them, so the reads are not optimized away
+	volatile double sink;
+
+	// with an arena every file is loaded to the memory of the previous one, the way file_collection::add_all() does
+	template <ws::data::extension E, ws::data::loader L>
+	std::size_t load(const std::vector<std::filesystem::path> & files, ws::data::storage storage = ws::data::storage::ROWS,
+					 const ws::data::projection & projection = ws::data::schema::all(), ws::data::arena * arena = nullptr)
+	{
+		std::size_t rows {};
+		for (const auto & path : files)
+		{
+			{
+				ws::data::file file {storage, projection, arena ? arena : std::pmr::get_default_resource()};
+				if (file.load<E, L>(path.string()))
+				{
+					rows += file.size();
+				}
+			}
+			if (arena) { arena->reset(); }
+		}
+		return rows;
+	}
+
+	std::uintmax_t size(const std::vector<std::filesystem::path> & files)
+	{
+		std::uintmax_t bytes {};
+		for (const auto & path : files) { bytes += std::filesystem::file_size(path); }
+		return bytes;
+	}
+
+	// results of every loader and writer must be the same, checked on the bundled files only
+	bool validate(const corpus & corpus, const std::filesystem::path & scratch)
+	{
+		for (const auto & path : corpus.files)
+		{
+			if (!same_rows(path))
+			{
+				print(std::format("Loaders disagree on \"{}\"\n", path.filename().string()));
+				return false;
+			}
+			ws::data::file file;
+			file.load<ws::data::extension::DAT, ws::data::loader::MAPPED>(path.string());
+			const std::filesystem::path legacy {scratch / "legacy.txt"};
+			const std::filesystem::path buffered {scratch / "buffered.txt"};
+			legacy_save(file, legacy.string());
+			file.save<ws::data::extension::TXT>(buffered.string());
+			if (read_all(legacy) != read_all(buffered))
+			{
+				print(std::format("Text writers disagree on \"{}\"\n", path.filename().string()));
+				return false;
+			}
+			// an archive saved back as .dat gives the same file
+			const std::filesystem::path archived {scratch / "archived.arc"};
+			const std::filesystem::path original {scratch / "original.dat"};
+			const std::filesystem::path restored {scratch / "restored.dat"};
+			ws::data::file archive;
+			file.save<ws::data::extension::ARC>(archived.string());
+			file.save<ws::data::extension::DAT>(original.string());
+			if (!archive.load<ws::data::extension::ARC, ws::data::loader::MAPPED>(archived.string()) ||
+				!archive.save<ws::data::extension::DAT>(restored.string()) || read_all(original) != read_all(restored))
+			{
+				print(std::format("Archive differs from \"{}\"\n", path.filename().string()));
+				return false;
+			}
+			ws::data::file stream;
+			ws::data::file blocks;
+			stream.load<ws::data::extension::TXT, ws::data::loader::STREAM>(buffered.string());
+			blocks.load<ws::data::extension::TXT, ws::data::loader::BUFFERED>(buffered.string());
+			if (stream.get_data().size() != blocks.get_data().size() ||
+				std::memcmp(stream.get_data().data(), blocks.get_data().data(), stream.get_data().size() * sizeof(ws::data::row)) != 0)
+			{
+				print(std::format("Text loaders disagree on \"{}\"\n", path.filename().string()));
+				return false;
+			}
+			// transform is in float, so bins differ from the plain one by a small share of the highest bin
+			ws::data::file columns {ws::data::storage::COLUMNS, analyzed};
+			columns.load<ws::data::extension::DAT, ws::data::loader::MAPPED>(path.string());
+			const std::vector<double> expected {legacy_density(columns.column(&ws::data::row::gyro_X), 1.0)};
+			const ws::data::spectrum::density density {ws::data::spectrum::welch(columns.column(&ws::data::row::gyro_X))};
+			const double highest {expected.empty() ? 0.0 : *std::max_element(expected.begin(), expected.end())};
+			bool same {density.power.size() == expected.size()};
+			for (std::size_t k {}; same && k < expected.size(); ++k)
+			{
+				same = std::abs(density.power[k] - expected[k]) <= 1e-4 * highest;
+			}
+			if (!same)
+			{
+				print(std::format("Spectrum differs from the plain transform on \"{}\"\n", path.filename().string()));
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void benchmark(suite & suite, const corpus & corpus, const std::filesystem::path & scratch)
+	{
+		print(std::format("\n{}: {} files, {:.2f} MB, {} rows, {} repeats\n",
+						  corpus.name, corpus.files.size(), static_cast<double>(corpus.bytes) / (1024.0 * 1024.0), corpus.rows, corpus.repeats));
+
+		// load .dat
+		suite.run(corpus, "load.dat.stream", corpus.bytes, [&corpus]
+		{
+			return load<ws::data::extension::DAT, ws::data::loader::STREAM>(corpus.files);
+		});
+		suite.run(corpus, "load.dat.mapped", corpus.bytes, [&corpus]
+		{
+			return load<ws::data::extension::DAT, ws::data::loader::MAPPED>(corpus.files);
+		});
+		suite.run(corpus, "load.dat.columns", corpus.bytes, [&corpus]
+		{
+			return load<ws::data::extension::DAT, ws::data::loader::MAPPED>(corpus.files, ws::data::storage::COLUMNS);
+		});
+		suite.run(corpus, "load.dat.analysis", corpus.bytes, [&corpus]
+		{
+			return load<ws::data::extension::DAT, ws::data::loader::MAPPED>(corpus.files, ws::data::storage::COLUMNS, analyzed);
+		});
+		suite.run(corpus, "load.dat.analysis.arena", corpus.bytes, [&corpus]
+		{
+			ws::data::arena arena;
+			return load<ws::data::extension::DAT, ws::data::loader::MAPPED>(corpus.files, ws::data::storage::COLUMNS, analyzed, &arena);
+		});
+		// read only gyro_X column through the record view, nothing else is copied
+		suite.run(corpus, "view.gyro_X", corpus.bytes, [&corpus]
+		{
+			std::size_t rows {};
+			double sum {};
+			for (const auto & path : corpus.files)
+			{
+				ws::data::record_view view;
+				if (!view.open(path.string())) { continue; }
+				for (std::size_t j {}; j < view.size(); ++j)
+				{
+					sum += view[j].get<&ws::data::row::gyro_X>();
+				}
+				rows += view.size();
+			}
+			sink = sum;
+			return rows;
+		});
+
+		// checksums of all records, rows are good records
+		auto checksums {[&corpus](auto function)
+		{
+			std::size_t rows {};
+			for (const auto & path : corpus.files)
+			{
+				ws::data::record_view view;
+				if (view.open(path.string())) { rows += function(view); }
+			}
+			return rows;
+		}};
+		suite.run(corpus, "legacy.crc8", corpus.bytes, [&checksums]
+		{
+			return checksums([](const ws::data::record_view & view)
+			{
+				constexpr std::size_t offset {ws::data::schema::find<&ws::data::row::crc8>().offset};
+				std::size_t rows {};
+				for (std::size_t i {}; i < view.size(); ++i)
+				{
+					rows += legacy_crc8(view[i].data(), offset) == static_cast<uint8_t>(view[i].data()[offset]) ? 1 : 0;
+				}
+				return rows;
+			});
+		});
+		suite.run(corpus, "crc8.verify", corpus.bytes, [&checksums]
+		{
+			return checksums([](const ws::data::record_view & view) { return ws::data::integrity::verify(view.bytes().data(), view.size()); });
+		});
+		suite.run(corpus, "crc8.check", corpus.bytes, [&checksums]
+		{
+			ws::data::integrity frames;
+			return checksums([&frames](const ws::data::record_view & view)
+			{
+				frames.check(view.bytes());
+				return frames.get_report().records;
+			});
+		});
+
+		// deviation of gyro columns, rows are values
+		std::vector<ws::data::file> columns;
+		std::size_t values {};
+		for (const auto & path : corpus.files)
+		{
+			columns.emplace_back(ws::data::storage::COLUMNS, analyzed);
+			columns.back().load<ws::data::extension::DAT, ws::data::loader::MAPPED>(path.string());
+			values += columns.back().size() * 3;
+		}
+		auto deviation {[&columns, values](auto function)
+		{
+			double sum {};
+			for (const auto & file : columns)
+			{
+				sum += function(file.column(&ws::data::row::gyro_X));
+				sum += function(file.column(&ws::data::row::gyro_Y));
+				sum += function(file.column(&ws::data::row::gyro_Z));
+			}
+			sink = sum;
+			return values;
+		}};
+		suite.run(corpus, "legacy.deviation", values * sizeof(float), [&deviation]
+		{
+			return deviation([](std::span<const float> column) { return legacy_deviation(column); });
+		});
+		for (auto set : {ws::data::statistics::instruction_set::SCALAR,
+						 ws::data::statistics::instruction_set::SSE,
+						 ws::data::statistics::instruction_set::AVX2})
+		{
+			if (set > ws::data::statistics::detect()) { continue; }
+			constexpr std::string_view names[] {"deviation.scalar", "deviation.sse", "deviation.avx2"};
+			suite.run(corpus, names[static_cast<std::size_t>(set)], values * sizeof(float), [&deviation, set]
+			{
+				return deviation([set](std::span<const float> column) { return ws::data::statistics::summarize(column, set).deviation; });
+			});
+		}
+
+		// spectra of gyroscopes, accelerometers and dither frequencies, rows are values
+		constexpr const float ws::data::row:: * spectral[] {&ws::data::row::gyro_X, &ws::data::row::gyro_Y, &ws::data::row::gyro_Z,
+															 &ws::data::row::acc_X, &ws::data::row::acc_Y, &ws::data::row::acc_Z,
+															 &ws::data::row::F_dith_X, &ws::data::row::F_dith_Y, &ws::data::row::F_dith_Z};
+		auto spectra {[&columns, &spectral](auto function)
+		{
+			std::size_t count {};
+			double sum {};
+			for (const auto & file : columns)
+			{
+				for (const auto member : spectral)
+				{
+					sum += function(file.column(member));
+					count += file.size();
+				}
+			}
+			sink = sum;
+			return count;
+		}};
+		suite.run(corpus, "legacy.psd", values * 3 * sizeof(float), [&spectra]
+		{
+			return spectra([](std::span<const float> column)
+			{
+				const std::vector<double> density {legacy_density(column, 1.0)};
+				return density.empty() ? 0.0 : density.back();
+			});
+		});
+		for (auto set : {ws::data::statistics::instruction_set::SCALAR,
+						 ws::data::statistics::instruction_set::SSE,
+						 ws::data::statistics::instruction_set::AVX2})
+		{
+			if (set > ws::data::statistics::detect()) { continue; }
+			constexpr std::string_view names[] {"psd.scalar", "psd.sse", "psd.avx2"};
+			suite.run(corpus, names[static_cast<std::size_t>(set)], values * 3 * sizeof(float), [&spectra, set]
+			{
+				return spectra([set](std::span<const float> column)
+				{
+					const ws::data::spectrum::density density {ws::data::spectrum::welch(column, 1.0, set)};
+					return density.power.empty() ? 0.0 : density.power.back();
+				});
+			});
+		}
+		columns.clear();
+
+		// load and analyze, files are parsed every time unless the case is about the cache
+		auto add_all {[&corpus](uint32_t threads, const std::filesystem::path & images)
+		{
+			ws::data::logger logger;
+			ws::data::file_collection collection;
+			collection.set_threads(threads);
+			if (!images.empty()) { collection.set_cache(images, std::uintmax_t {1} << 40); }
+			collection.add_all(corpus.folder, logger);
+			return corpus.rows;
+		}};
+		suite.run(corpus, "add_all", corpus.bytes, [&add_all]
+		{
+			return add_all(1, {});
+		});
+		suite.run(corpus, "add_all.parallel", corpus.bytes, [&add_all]
+		{
+			return add_all(0, {});
+		});
+		const std::filesystem::path images {scratch / "cache"};
+		suite.run(corpus, "add_all.cache.cold", corpus.bytes, [&add_all, &images]
+		{
+			std::filesystem::remove_all(images);
+			return add_all(1, images);
+		});
+		add_all(1, images);
+		suite.run(corpus, "add_all.cache.warm", corpus.bytes, [&add_all, &images]
+		{
+			return add_all(1, images);
+		});
+		std::filesystem::remove_all(images);
+		// nothing changed, so adding the corpus again only checks sizes and modification times
+		for (bool watch : {false, true})
+		{
+			ws::data::logger logger;
+			ws::data::file_collection collection;
+			collection.set_watch(watch);
+			collection.add_all(corpus.folder, logger);
+			suite.run(corpus, watch ? "add_all.rescan.watched" : "add_all.rescan", corpus.bytes, [&corpus, &collection, &logger]
+			{
+				collection.add_all(corpus.folder, logger);
+				while (!logger.empty()) { logger.extract(); }
+				return corpus.rows;
+			});
+		}
+
+		// convert every .dat file to .txt next to it
+		suite.run(corpus, "convert_all", corpus.bytes, [&corpus]
+		{
+			ws::data::logger logger;
+			ws::data::file_collection collection;
+			collection.convert_all(corpus.folder, logger);
+			return corpus.rows;
+		});
+		std::vector<std::filesystem::path> texts {list(corpus.folder, ws::data::extension::TXT)};
+		if (texts.empty())
+		{
+			ws::data::logger logger;
+			ws::data::file_collection {}.convert_all(corpus.folder, logger);
+			texts = list(corpus.folder, ws::data::extension::TXT);
+		}
+
+		// load .txt
+		const std::uintmax_t text_bytes {size(texts)};
+		suite.run(corpus, "load.txt.stream", text_bytes, [&texts]
+		{
+			return load<ws::data::extension::TXT, ws::data::loader::STREAM>(texts);
+		});
+		suite.run(corpus, "load.txt.buffered", text_bytes, [&texts]
+		{
+			return load<ws::data::extension::TXT, ws::data::loader::BUFFERED>(texts);
+		});
+		suite.run(corpus, "load.txt.buffered.arena", text_bytes, [&texts]
+		{
+			ws::data::arena arena;
+			return load<ws::data::extension::TXT, ws::data::loader::BUFFERED>(texts, ws::data::storage::ROWS, ws::data::schema::all(), &arena);
+		});
+		for (const auto & path : texts) { std::filesystem::remove(path); }
+
+		// save loaded files, bytes are bytes written
+		std::vector<ws::data::file> files;
+		for (const auto & path : corpus.files)
+		{
+			files.emplace_back();
+			files.back().load<ws::data::extension::DAT, ws::data::loader::MAPPED>(path.string());
+		}
+		const std::string saved {(scratch / "saved").string()};
+		auto save {[&files, &saved](auto function)
+		{
+			std::size_t rows {};
+			for (auto & file : files)
+			{
+				rows += function(file, saved) ? file.size() : 0;
+			}
+			return rows;
+		}};
+		suite.run(corpus, "save.dat", corpus.bytes, [&save]
+		{
+			return save([](ws::data::file & file, const std::string & path) { return file.save<ws::data::extension::DAT>(path); });
+		});
+		suite.run(corpus, "save.txt", text_bytes, [&save]
+		{
+			return save([](ws::data::file & file, const std::string & path) { return file.save<ws::data::extension::TXT>(path); });
+		});
+		suite.run(corpus, "legacy.save.txt", text_bytes, [&save]
+		{
+			return save([](ws::data::file & file, const std::string & path) { return legacy_save(file, path); });
+		});
+		suite.run(corpus, "save.arc", corpus.bytes, [&save]
+		{
+			return save([](ws::data::file & file, const std::string & path) { return file.save<ws::data::extension::ARC>(path); });
+		});
+		std::vector<std::filesystem::path> archives;
+		for (std::size_t i {}; i < files.size(); ++i)
+		{
+			archives.push_back(scratch / std::format("{}.arc", i));
+			files[i].save<ws::data::extension::ARC>(archives.back().string());
+		}
+		files.clear();
+		std::filesystem::remove(saved);
+
+		// load .arc, bytes are bytes of the archives
+		const std::uintmax_t archive_bytes {size(archives)};
+		suite.run(corpus, "load.arc.mapped", archive_bytes, [&archives]
+		{
+			return load<ws::data::extension::ARC, ws::data::loader::MAPPED>(archives);
+		});
+		suite.run(corpus, "load.arc.analysis.arena", archive_bytes, [&archives]
+		{
+			ws::data::arena arena;
+			return load<ws::data::extension::ARC, ws::data::loader::MAPPED>(archives, ws::data::storage::COLUMNS, analyzed, &arena);
+		});
+		for (const auto & path : archives) { std::filesystem::remove(path); }
+
+		// save the report, rows are analyzed files
+		ws::data::logger logger;
+		ws::data::file_collection collection;
+		collection.add_all(corpus.folder, logger);
+		const std::filesystem::path report {scratch / "report.txt"};
+		collection.save_data(report.string(), logger);
+		suite.run(corpus, "save_data", std::filesystem::file_size(report), [&collection, &logger, &report]
+		{
+			collection.save_data(report.string(), logger);
+			while (!logger.empty()) { logger.extract(); }
+			return collection.get_data().size();
+		});
+		std::filesystem::remove(report);
+
+		// results of an archive much larger than the corpus, added in random order, rows are results and bytes
+		// are bytes of their paths; values are as large as an estimate without its noise terms, so results compare
+		// with earlier runs
+		using value = std::array<float, 26>;
+		constexpr std::size_t recordings {100000};
+		std::vector<std::string> paths;
+		paths.reserve(recordings);
+		std::uintmax_t path_bytes {};
+		for (std::size_t i {}; i < recordings; ++i)
+		{
+			paths.push_back(std::format("archive/unit_{:03}/2023{:010}_binout1.dat", i % 500, i));
+			path_bytes += paths.back().size();
+		}
+		std::shuffle(paths.begin(), paths.end(), std::mt19937_64 {recordings});
+		auto name {[](const std::string & path) { return std::string_view(path).substr(path.rfind('/') + 1); }};
+		ws::data::result_store<value> store;
+		std::map<std::string, std::pair<std::string, std::unique_ptr<value>>> map;
+		suite.run(corpus, "results.insert", path_bytes, [&paths, &store, &name]
+		{
+			store = {};
+			for (const auto & path : paths) { store.insert(path, name(path), value {}); }
+			return paths.size();
+		});
+		suite.run(corpus, "legacy.results.insert", path_bytes, [&paths, &map, &name]
+		{
+			map.clear();
+			for (const auto & path : paths) { map.emplace(path, std::make_pair(std::string(name(path)), std::make_unique<value>())); }
+			return paths.size();
+		});
+		suite.run(corpus, "results.iterate", path_bytes, [&store]
+		{
+			std::size_t sum {};
+			for (const auto & result : store) { sum += result.name.size() + static_cast<std::size_t>(result.value[0]); }
+			sink = static_cast<double>(sum);
+			return store.size();
+		});
+		suite.run(corpus, "legacy.results.iterate", path_bytes, [&map]
+		{
+			std::size_t sum {};
+			for (const auto & result : map) { sum += result.second.first.size() + static_cast<std::size_t>((*result.second.second)[0]); }
+			sink = static_cast<double>(sum);
+			return map.size();
+		});
+
+		// statistics of as many estimates grouped by rhumb and temperature, rows are estimates
+		std::vector<ws::data::aggregate::sample> samples(recordings);
+		std::mt19937_64 engine {recordings};
+		std::normal_distribution<float> error {0.0f, 150.0f};
+		std::normal_distribution<float> spread {0.23f, 0.02f};
+		for (auto & sample : samples)
+		{
+			sample.heading = static_cast<uint32_t>(engine() % 360);
+			sample.temperature = static_cast<int32_t>(engine() % 90) - 40;
+			sample.errors = {std::abs(error(engine)), std::abs(error(engine)) / 4.0f, std::abs(error(engine)) / 4.0f};
+			sample.deviation = {spread(engine), spread(engine), spread(engine)};
+			sample.failed = {sample.errors[0] > 432.0f, sample.errors[1] > 108.0f, sample.errors[2] > 108.0f};
+		}
+		suite.run(corpus, "aggregate.1", recordings * sizeof(ws::data::aggregate::sample), [&samples]
+		{
+			sink = static_cast<double>(ws::data::aggregate::summarize(samples, 1).total.passed);
+			return samples.size();
+		});
+		suite.run(corpus, "aggregate", recordings * sizeof(ws::data::aggregate::sample), [&samples]
+		{
+			sink = static_cast<double>(ws::data::aggregate::summarize(samples).total.passed);
+			return samples.size();
+		});
+
+		// Allan deviation of three gyroscopes of a recording much longer than the corpus: white noise and a random
+		// walk of the rate, rows are samples of all three
+		constexpr std::size_t seconds {1 << 21};
+		std::array<std::vector<float>, 3> gyros;
+		std::normal_distribution<double> noise {0.0, 1.0};
+		for (auto & gyro : gyros)
+		{
+			double walk {};
+			gyro.resize(seconds);
+			for (float & value : gyro)
+			{
+				walk += 0.01 * noise(engine);
+				value = static_cast<float>(2.0 * noise(engine) + walk);
+			}
+		}
+		const std::array<std::span<const float>, 3> channels {gyros[0], gyros[1], gyros[2]};
+		suite.run(corpus, "allan.1", 3 * seconds * sizeof(float), [&channels]
+		{
+			sink = ws::data::allan::compute(channels, 1.0, 1).front().fitted.random_walk;
+			return 3 * seconds;
+		});
+		suite.run(corpus, "allan", 3 * seconds * sizeof(float), [&channels]
+		{
+			sink = ws::data::allan::compute(channels).front().fitted.random_walk;
+			return 3 * seconds;
+		});
+		suite.run(corpus, "psd.long.1", 3 * seconds * sizeof(float), [&channels]
+		{
+			sink = ws::data::spectrum::welch(channels, 1.0, 1).front().power.back();
+			return 3 * seconds;
+		});
+		suite.run(corpus, "psd.long", 3 * seconds * sizeof(float), [&channels]
+		{
+			sink = ws::data::spectrum::welch(channels).front().power.back();
+			return 3 * seconds;
+		});
+	}
+}
+
+int main(int argc, char * argv[])
+{
+	std::filesystem::path folder {"test files"};
+	uint32_t repeats {20};
+	std::vector<uint32_t> scales;
+	std::string filter;
+	std::filesystem::path json;
+	std::filesystem::path baseline;
+	for (int i {1}; i < argc; ++i)
+	{
+		const std::string_view argument {argv[i]};
+		const bool value {i + 1 < argc};
+		if (argument == "--repeats" && value) { repeats = std::max(static_cast<uint32_t>(std::stoul(argv[++i])), 1u); }
+		else if (argument == "--scale" && value) { scales.push_back(static_cast<uint32_t>(std::stoul(argv[++i]))); }
+		else if (argument == "--case" && value) { filter = argv[++i]; }
+		else if (argument == "--json" && value) { json = argv[++i]; }
+		else if (argument == "--baseline" && value) { baseline = argv[++i]; }
+		else { folder = argument; }
+	}
+	if (scales.empty()) { scales = {4, 16}; }
+	if (!std::filesystem::is_directory(folder))
+	{
+		print(std::format("No such folder \"{}\"\n", folder.string()));
+		return 1;
+	}
+	const std::vector<std::filesystem::path> sources {list(folder, ws::data::extension::DAT)};
+	if (sources.empty())
+	{
+		print(std::format("No .dat files in \"{}\"\n", folder.string()));
+		return 1;
+	}
+
+	// every corpus is a folder of its own, so cases could write .txt files next to .dat files
+	const std::filesystem::path scratch {std::filesystem::temp_directory_path() / "BINS_benchmark"};
+	std::filesystem::remove_all(scratch);
+	std::vector<corpus> corpora;
+	std::filesystem::create_directories(scratch / "bundled");
+	for (const auto & path : sources)
+	{
+		std::filesystem::copy_file(path, scratch / "bundled" / path.filename());
+	}
+	corpora.push_back(describe("bundled", scratch / "bundled", repeats));
+	if (!validate(corpora.back(), scratch)) { return 1; }
+	for (uint32_t scale : scales)
+	{
+		if (scale < 2) { continue; }
+		const std::filesystem::path many {scratch / std::format("many-{}", scale)};
+		const std::filesystem::path long_ {scratch / std::format("long-{}", scale)};
+		std::filesystem::create_directories(many);
+		std::filesystem::create_directories(long_);
+		for (const auto & path : sources)
+		{
+			for (uint32_t i {}; i < scale; ++i)
+			{
+				std::filesystem::copy_file(path, many / std::format("{:05}_{}", i, path.filename().string()));
+			}
+			stretch(path, long_ / path.filename(), scale);
+		}
+		// larger corpora run fewer times, so every corpus takes about the same time
+		const uint32_t scaled {std::max(repeats / scale, 1u)};
+		corpora.push_back(describe(many.filename().string(), many, scaled));
+		corpora.push_back(describe(long_.filename().string(), long_, scaled));
+	}
+
+	suite suite {filter};
+	for (const auto & corpus : corpora)
+	{
+		benchmark(suite, corpus, scratch);
+	}
+	std::filesystem::remove_all(scratch);
+	if (!json.empty())
+	{
+		if (!suite.save(json))
+		{
+			print(std::format("Could not write \"{}\"\n", json.string()));
+			return 1;
+		}
+		print(std::format("\nresults written to \"{}\"\n", json.string()));
+	}
+	if (!baseline.empty())
+	{
+		suite.compare(baseline);
+	}
+	return 0;
+}
@@ -0,0 +1,78 @@
+//
+//  bounded_queue.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <mutex>
+#include <deque>
+#include <condition_variable>
+
+// Bounded_queue is a blocking queue of fixed capacity to pass items between stages of a pipeline running
+// in different threads. Push() blocks while the queue is full, so a fast stage waits for a slow one
+// (backpressure) and memory used by queued items stays bounded. Pop() blocks while the queue is empty
+// and returns false once the queue is closed and drained.
+//
+// Class properties:
+// - m_items   : queued items;
+// - m_capacity: maximum number of queued items;
+// - m_closed  : set by close(), no more items will be pushed;
+// - m_mutex, m_not_full, m_not_empty: used to block pushing and popping threads.
+//
+// Class behaviors:
+// - push() : add an item, waits while the queue is full;
+// - pop()  : take the oldest item, waits while the queue is empty, returns false if queue is closed and empty;
+// - close(): tell consumers that no more items will be pushed.
+
+namespace ws::data
+{
+	template <typename T>
+	class bounded_queue
+	{
+	public:
+		explicit bounded_queue(std::size_t capacity) : m_capacity(capacity), m_closed() {}
+		bounded_queue(const bounded_queue &) = delete;
+		bounded_queue & operator = (const bounded_queue &) = delete;
+	public:
+		void push(T item)
+		{
+			{
+				std::unique_lock<std::mutex> lock {m_mutex};
+				m_not_full.wait(lock, [this] { return m_items.size() < m_capacity; });
+				m_items.push_back(std::move(item));
+			}
+			m_not_empty.notify_one();
+		}
+
+		bool pop(T & item)
+		{
+			{
+				std::unique_lock<std::mutex> lock {m_mutex};
+				m_not_empty.wait(lock, [this] { return !m_items.empty() || m_closed; });
+				if (m_items.empty()) { return false; }
+				item = std::move(m_items.front());
+				m_items.pop_front();
+			}
+			m_not_full.notify_one();
+			return true;
+		}
+
+		void close()
+		{
+			{
+				std::lock_guard<std::mutex> lock {m_mutex};
+				m_closed = true;
+			}
+			m_not_empty.notify_all();
+		}
+	private:
+		std::deque<T> m_items;
+		std::size_t m_capacity;
+		bool m_closed;
+		std::mutex m_mutex;
+		std::condition_variable m_not_full;
+		std::condition_variable m_not_empty;
+	};
+}
@@ -0,0 +1,270 @@
+//
+//  cache.cpp
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#include <array>
+#include <format>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+#include "cache.h"
+#include "mapping.h"
+#include "writer.h"
+
+namespace ws::data
+{
+	namespace
+	{
+		constexpr std::array<char, 8> magic {'B', 'I', 'N', 'S', 'I', 'M', 'G', '\0'};
+
+		// canonical path of the source file follows the header, columns (see 'columns.h') follow the path
+		struct header
+		{
+			std::array<char, 8> magic;
+			uint32_t version;
+			uint32_t path_size;
+			uint64_t size;
+			int64_t time;
+			uint64_t rows;
+			// what the loader found broken in the source file (see 'integrity.h'), reported again on a hit
+			uint64_t records;
+			uint64_t skipped;
+			uint64_t repaired;
+			uint64_t garbage;
+			uint64_t truncated;
+			std::array<char, schema::count> fields;
+		};
+
+		// everything that tells one state of a source file from another
+		struct source
+		{
+			std::string path;
+			uint64_t size;
+			int64_t time;
+		};
+
+		bool identify(const std::filesystem::path & path, source & source)
+		{
+			std::error_code error;
+			source.path = std::filesystem::canonical(path, error).string();
+			if (error) { return false; }
+			source.size = static_cast<uint64_t>(std::filesystem::file_size(path, error));
+			if (error) { return false; }
+			source.time = static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+			return !error;
+		}
+
+		std::array<char, schema::count> fields(const projection & projection)
+		{
+			std::array<char, schema::count> fields {};
+			for (std::size_t i {}; i < schema::count; ++i) { fields[i] = projection[i] ? '1' : '0'; }
+			return fields;
+		}
+
+		const std::filesystem::path image_extension {".bin"};
+
+		// several programs may share the cache folder, so names of temporary images hold the process as well
+		uint64_t process()
+		{
+		#if defined(_WIN32)
+			return static_cast<uint64_t>(_getpid());
+		#else
+			return static_cast<uint64_t>(getpid());
+		#endif
+		}
+	}
+
+	bool cache::open(const std::filesystem::path & folder, std::uintmax_t capacity)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(folder, error);
+		if (error || !std::filesystem::is_directory(folder, error))
+		{
+			this->close();
+			return false;
+		}
+		m_folder = folder;
+		m_capacity = capacity;
+		// images left by earlier runs count too, but a disabled cache leaves them alone
+		if (this->enabled()) { this->evict(); }
+		return this->enabled();
+	}
+
+	void cache::close()
+	{
+		m_capacity = 0;
+	}
+
+	bool cache::enabled() const
+	{
+		return m_capacity != 0;
+	}
+
+	bool cache::load(const std::filesystem::path & path, file & file) const
+	{
+		if (!this->enabled()) { return false; }
+		source source {};
+		const std::filesystem::path name {identify(path, source) ? this->entry(source.path) : std::filesystem::path()};
+		mapping image;
+		header header {};
+		bool hit {!name.empty() && image.open(name.string()) && image.size() >= sizeof(header)};
+		if (hit)
+		{
+			std::memcpy(&header, image.data(), sizeof(header));
+			hit = header.magic == magic && header.version == version &&
+				  header.size == source.size && header.time == source.time &&
+				  header.fields == fields(file.get_projection()) &&
+				  header.path_size == source.path.size() && image.size() - sizeof(header) >= header.path_size &&
+				  std::string_view(reinterpret_cast<const char *>(image.data()) + sizeof(header), header.path_size) == source.path;
+		}
+		if (hit)
+		{
+			const std::size_t offset {sizeof(header) + header.path_size};
+			const integrity::report report {static_cast<std::size_t>(header.records), static_cast<std::size_t>(header.skipped),
+											static_cast<std::size_t>(header.repaired), static_cast<std::size_t>(header.garbage),
+											static_cast<std::size_t>(header.truncated)};
+			hit = file.restore(std::span<const std::byte>(image.data() + offset, image.size() - offset),
+							   static_cast<std::size_t>(header.rows), report);
+		}
+		if (!hit)
+		{
+			++m_misses;
+			return false;
+		}
+		// the image was used just now, so it is the last one to be evicted
+		std::error_code error;
+		std::filesystem::last_write_time(name, std::filesystem::file_time_type::clock::now(), error);
+		++m_hits;
+		return true;
+	}
+
+	void cache::store(const std::filesystem::path & path, const file & file) const
+	{
+		if (!this->enabled()) { return; }
+		source source {};
+		if (!identify(path, source)) { return; }
+		const std::filesystem::path name {this->entry(source.path)};
+		// another thread or program may be reading the old image, so the new one is written aside and renamed
+		std::filesystem::path temporary {name};
+		temporary += std::format(".{}.{}.tmp", process(), std::hash<std::thread::id>{}(std::this_thread::get_id()));
+		std::error_code error;
+		std::size_t size {};
+		{
+			writer fout;
+			if (!fout.open(temporary.string(), true)) { return; }
+			// padding of the header is written too, so it is zeroed rather than left as it was on the stack
+			header header;
+			std::memset(&header, 0, sizeof(header));
+			header.magic = magic;
+			header.version = version;
+			header.path_size = static_cast<uint32_t>(source.path.size());
+			header.size = source.size;
+			header.time = source.time;
+			header.rows = static_cast<uint64_t>(file.size());
+			header.records = static_cast<uint64_t>(file.get_integrity().records);
+			header.skipped = static_cast<uint64_t>(file.get_integrity().skipped);
+			header.repaired = static_cast<uint64_t>(file.get_integrity().repaired);
+			header.garbage = static_cast<uint64_t>(file.get_integrity().garbage);
+			header.truncated = static_cast<uint64_t>(file.get_integrity().truncated);
+			header.fields = fields(file.get_projection());
+			std::string & out {fout.buffer()};
+			out.append(reinterpret_cast<const char *>(&header), sizeof(header));
+			out.append(source.path);
+			const bool dumped {file.dump(out)};
+			size = out.size();
+			fout.commit();
+			if (!fout.close() || !dumped)
+			{
+				std::filesystem::remove(temporary, error);
+				return;
+			}
+		}
+		std::filesystem::rename(temporary, name, error);
+		if (error)
+		{
+			std::filesystem::remove(temporary, error);
+			return;
+		}
+		// the image may have replaced an older one of the same file, then the size is overestimated
+		// until the next eviction counts it exactly
+		if ((m_size += size) > m_capacity) { this->evict(); }
+	}
+
+	std::size_t cache::hits() const
+	{
+		return m_hits;
+	}
+
+	std::size_t cache::misses() const
+	{
+		return m_misses;
+	}
+
+	const std::filesystem::path & cache::get_folder() const
+	{
+		return m_folder;
+	}
+
+	std::uintmax_t cache::get_capacity() const
+	{
+		return m_capacity;
+	}
+
+	std::filesystem::path cache::default_folder()
+	{
+		std::error_code error;
+		const std::filesystem::path temporary {std::filesystem::temp_directory_path(error)};
+		return error ? std::filesystem::path() : temporary / "BINS_workstation";
+	}
+
+	std::filesystem::path cache::entry(const std::string & path) const
+	{
+		return m_folder / std::format("{:016x}{}", std::hash<std::string>{}(path), image_extension.string());
+	}
+
+	void cache::evict() const
+	{
+		std::lock_guard<std::mutex> lock {m_mutex};
+		struct image
+		{
+			std::filesystem::path path;
+			std::uintmax_t size;
+			std::filesystem::file_time_type time;
+		};
+		std::vector<image> images;
+		std::uintmax_t total {};
+		std::error_code error;
+		for (std::filesystem::directory_iterator i {m_folder, error}; !error && i != std::filesystem::directory_iterator(); i.increment(error))
+		{
+			if (i->path().extension() != image_extension) { continue; }
+			std::error_code status;
+			const std::uintmax_t size {i->file_size(status)};
+			if (status) { continue; }
+			const std::filesystem::file_time_type time {i->last_write_time(status)};
+			if (status) { continue; }
+			images.push_back({i->path(), size, time});
+			total += size;
+		}
+		if (total > m_capacity)
+		{
+			std::sort(images.begin(), images.end(), [](const image & left, const image & right) { return left.time < right.time; });
+			for (const image & image : images)
+			{
+				if (total <= m_capacity) { break; }
+				// an image that is mapped right now may not be removable, it stays until the next eviction
+				if (std::filesystem::remove(image.path, error)) { total -= image.size; }
+			}
+		}
+		m_size = total;
+	}
+}
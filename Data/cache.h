@@ -0,0 +1,84 @@
+//
+//  cache.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include "file.h"
+
+// Cache class keeps parsed source files on disk as compact columnar images, so a file that was already
+// loaded once is mapped into memory (see 'mapping.h') and copied column by column instead of being parsed
+// again. An image holds only the fields of the projection it was loaded with (see 'file.h'). Every image
+// lives in its own file in the cache folder, named after the hash of the canonical path of the source file.
+// The header of an image stores the canonical path, size and modification time of the source file, loader
+// version and projection; if any of them differ from the current ones the image is not used and is replaced
+// by the next store(). The header also keeps what the loader found broken in the source file (see
+// 'integrity.h'), so a hit reports the same damage as parsing the file would. Total size of the folder is
+// kept under the capacity: least recently used images are removed first, every hit refreshes modification
+// time of the image. The cache never fails loading: any error while reading or writing an image is treated
+// as a miss. Load() and store() are safe to call from several threads at once, open() and close() are not.
+// The cache is off until open() is called; programs that want it use the default folder in the temporary
+// folder of the system and the default capacity.
+//
+// Class properties:
+// - m_folder  : folder where images are kept;
+// - m_capacity: maximum total size of images in bytes, zero disables the cache;
+// - m_hits    : number of files loaded from images;
+// - m_misses  : number of files that had to be parsed;
+// - m_size    : total size of images, exact after every eviction and may be overestimated between them;
+// - m_mutex   : serializes eviction of old images.
+//
+// Class behaviors:
+// - open()        : use given folder and capacity, the folder is created if needed, returns false if it could not be;
+// - close()       : disable the cache, images are kept on disk;
+// - enabled()     : check if the cache is used;
+// - load()        : fill given file from the image of the source file, returns false on a miss;
+// - store()       : write the image of given loaded file and evict old images if needed;
+// - hits()        : return number of hits;
+// - misses()      : return number of misses;
+// - get_folder()  : return a const reference to 'm_folder' member;
+// - get_capacity(): return current state of 'm_capacity' member;
+// - default_folder(): return 'BINS_workstation' folder in the temporary folder, empty if there is none.
+
+namespace ws::data
+{
+	class cache
+	{
+	public:
+		// version of loaders and of the image layout, images written with any other version are never used,
+		// so it must be raised whenever loaders or 'schema.h' change what ends up in the columns
+		static constexpr uint32_t version {2};
+		static constexpr std::uintmax_t default_capacity {std::uintmax_t {256} << 20};
+	public:
+		cache() = default;
+		cache(const cache &) = delete;
+		cache & operator = (const cache &) = delete;
+	public:
+		bool open(const std::filesystem::path &, std::uintmax_t);
+		void close();
+		bool enabled() const;
+		bool load(const std::filesystem::path &, file &) const;
+		void store(const std::filesystem::path &, const file &) const;
+		std::size_t hits() const;
+		std::size_t misses() const;
+		const std::filesystem::path & get_folder() const;
+		std::uintmax_t get_capacity() const;
+		static std::filesystem::path default_folder();
+	private:
+		std::filesystem::path entry(const std::string &) const;
+		void evict() const;
+	private:
+		std::filesystem::path m_folder;
+		std::uintmax_t m_capacity {};
+		mutable std::atomic<std::size_t> m_hits {};
+		mutable std::atomic<std::size_t> m_misses {};
+		mutable std::atomic<std::uintmax_t> m_size {};
+		mutable std::mutex m_mutex;
+	};
+}
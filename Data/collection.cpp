@@ -5,14 +5,92 @@
 //  Created by Denis Fedorov on 02.02.2023.
 //
 
+#include <cmath>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <algorithm>
 #include <fstream>
+#include <condition_variable>
 #include "collection.h"
+#include "bounded_queue.h"
+#include "profiler.h"
+#include "record.h"
+#include "statistics.h"
+#include "tail.h"
+#include "thread_pool.h"
+#include "writer.h"
 
 namespace ws::data
 {
-	file_collection::file_collection() : m_extension(extension::DAT)
+	namespace
 	{
+		// analysis reads only a few fields, so only they are loaded
+		const projection analyzed {schema::select(&row::count, &row::thdg, &row::roll, &row::pitch,
+												  &row::gyro_X, &row::gyro_Y, &row::gyro_Z, &row::acc_X, &row::acc_Y, &row::acc_Z,
+												  &row::F_dith_X, &row::F_dith_Y, &row::F_dith_Z,
+												  &row::gyro_X_temperature, &row::gyro_Y_temperature, &row::gyro_Z_temperature)};
 
+		// limits of errors in arc seconds the report marks red: 432" for heading, 108" for roll and pitch
+		constexpr float heading_limit {432.0f};
+		constexpr float tilt_limit {108.0f};
+
+		// longest time between a record written to a followed file and the refreshed estimate
+		constexpr std::chrono::milliseconds follow_period {20};
+
+		// the largest arena buffer kept between calls, enough for a day long recording (see 'arena.h')
+		constexpr std::size_t retained {32 << 20};
+
+		// records are written once a second, so 'count' is also time in seconds
+		constexpr double record_period {1.0};
+
+		// columns characterize() takes noise terms and spectra of: gyroscopes, accelerometers and dither frequencies
+		constexpr std::array<const float row:: *, 9> noisy {&row::gyro_X, &row::gyro_Y, &row::gyro_Z,
+															 &row::acc_X, &row::acc_Y, &row::acc_Z,
+															 &row::F_dith_X, &row::F_dith_Y, &row::F_dith_Z};
+
+		// what the loader found broken in a .dat file (see 'integrity.h'), empty if nothing was
+		std::string damage(const std::filesystem::path & path, const integrity::report & report)
+		{
+			WS_COUNT(RECORDS_SKIPPED, report.skipped);
+			WS_COUNT(RECORDS_REPAIRED, report.repaired);
+			if (!report.skipped && !report.repaired && !report.garbage) { return {}; }
+			return std::format("Файл \"{}\" повреждён: пропущено записей: {}, восстановлено после сдвига: {}, байт вне записей: {}\n",
+							   path.filename().string(), report.skipped, report.repaired, report.garbage);
+		}
+
+		// text as a JSON string: quotes and backslashes are escaped, so are control characters, which JSON does
+		// not allow in strings as they are
+		std::string quote(const std::string_view text)
+		{
+			std::string result {"\""};
+			for (const char c : text)
+			{
+				if (c == '"' || c == '\\') { result += '\\'; }
+				if (static_cast<unsigned char>(c) < 0x20) { result += std::format("\\u{:04x}", static_cast<unsigned int>(c)); }
+				else { result += c; }
+			}
+			return result + '"';
+		}
+
+		// value formatted as given, or null if it is NaN or infinite, which JSON has no numbers for
+		template <typename T>
+		std::string number(T value, const std::string_view format = "{}")
+		{
+			return std::isfinite(value) ? std::vformat(format, std::make_format_args(value)) : std::string {"null"};
+		}
+
+		// size of a file for the profiler, zero if it is unknown
+		[[maybe_unused]] std::uintmax_t size_of(const std::filesystem::path & path)
+		{
+			std::error_code error;
+			const std::uintmax_t size {std::filesystem::file_size(path, error)};
+			return error ? 0 : size;
+		}
+	}
+
+	file_collection::file_collection() : m_extension(extension::DAT), m_threads(), m_watch()
+	{
 	}
 
 	bool file_collection::add(const std::filesystem::path & path, logger & logger)
@@ -20,73 +98,276 @@ namespace ws::data
 		// if files at given path already were added, return
 		if (m_collection.contains(path.string()))
 		{
-			logger.log(std::format("Файл \"{}\" уже добавлен", path.filename().string()));
+			logger.log(std::format("Файл \"{}\" уже добавлен", path.filename().string()), logger::severity::WARNING);
 			return false;
 		}
 		else
 		{
-			std::unique_ptr<file> file {std::make_unique<ws::data::file>()};
-			if (path.filename().extension().string() == extension::DAT)
+			if (m_arenas.empty()) { m_arenas.push_back(std::make_unique<arena>()); }
+			std::string message;
+			std::optional<estimate> result {this->ingest(path, message, m_arenas.front().get(), m_threads)};
+			m_arenas.front()->trim(retained);
+			if (result)
 			{
-				if (file->load<extension::DAT>(path.string()))
-				{
-					m_collection.emplace(path.string(), std::make_pair(path.filename().string(), this->analyze(file)));
-					return true;
-				}
-				else
-				{
-					logger.log(std::format("Не удалось открыть \"{}\"\n", path.filename().string()));
-					return false;
-				}
+				m_collection.insert(path.string(), path.filename().string(), *result);
+				if (!message.empty()) { logger.log(message, logger::severity::WARNING); }
+				return true;
 			}
 			else
 			{
-				if (file->load<extension::TXT>(path.string()))
+				logger.log(message, logger::severity::FAILURE);
+				return false;
+			}
+		}
+	}
+
+	bool file_collection::add_all(const std::filesystem::path & path, logger & logger)
+	{
+		// only files that are new or changed since the folder was added last time are loaded (see 'manifest.h'),
+		// so adding the same folder again costs a walk over the tree at most
+		auto known {m_manifests.try_emplace(std::make_pair(path.string(), m_extension), path, m_extension).first};
+		manifest::changes changes {};
+		{
+			WS_PROFILE(WALK);
+			changes = known->second.scan(m_watch);
+		}
+		WS_COUNT(FILES_SKIPPED, known->second.size() - changes.changed.size());
+		for (const auto & removed : changes.removed)
+		{
+			m_collection.erase(removed);
+		}
+		std::vector<std::filesystem::path> & paths {changes.changed};
+		uint32_t updated {};
+		uint32_t file_count {};
+		// estimate of a changed file is replaced, so is estimate of a file added alone before, but only by a loaded
+		// one: a file that failed keeps its old estimate and stays pending in the manifest to be loaded next time
+		auto settle {[this, &known, &logger, &updated, &file_count](const std::filesystem::path & file, std::optional<estimate> & result,
+																 const std::string & message)
+		{
+			if (!result)
+			{
+				logger.log(message, logger::severity::FAILURE);
+				return;
+			}
+			updated += static_cast<uint32_t>(m_collection.contains(file.string()));
+			m_collection.insert_or_assign(file.string(), file.filename().string(), std::move(*result));
+			known->second.commit(file);
+			if (!message.empty()) { logger.log(message, logger::severity::WARNING); }
+			++file_count;
+		}};
+		const std::size_t hits {m_cache.hits()};
+		const std::size_t misses {m_cache.misses()};
+		const uint32_t threads {m_threads ? m_threads : std::max(std::thread::hardware_concurrency(), 1u)};
+		if (threads < 2 || paths.size() < 2)
+		{
+			if (m_arenas.empty()) { m_arenas.push_back(std::make_unique<arena>()); }
+			for (const auto & file : paths)
+			{
+				std::string message;
+				std::optional<estimate> result {this->ingest(file, message, m_arenas.front().get(), m_threads)};
+				m_arenas.front()->reset();
+				settle(file, result, message);
+			}
+		}
+		else
+		{
+			// workers only load and analyze files, this thread alone puts results to the collection and
+			// writes to the logger in the order files were found, so result does not depend on timing
+			struct slot
+			{
+				bool ready;
+				std::optional<estimate> result;
+				std::string message;
+			};
+			std::vector<slot> slots(paths.size());
+			std::mutex mutex;
+			std::condition_variable condition;
+			// declared after the slots, so workers are joined before the slots are destroyed
+			thread_pool pool {threads};
+			// a worker loads files one after another, so its arena is reused from file to file
+			while (m_arenas.size() < pool.size() + 1)
+			{
+				m_arenas.push_back(std::make_unique<arena>());
+			}
+			for (std::size_t i {}; i < paths.size(); ++i)
+			{
+				pool.submit([this, &pool, &paths, &slots, &mutex, &condition, i]
 				{
-					m_collection.emplace(path.string(), std::make_pair(path.filename().string(), this->analyze(file)));
-					return true;
-				}
-				else
+					arena & arena {*m_arenas[pool.index() + 1]};
+					std::string message;
+					// files are already spread over the workers, so each is analyzed on its own one
+					std::optional<estimate> result {this->ingest(paths[i], message, &arena, 1)};
+					arena.reset();
+					{
+						std::lock_guard<std::mutex> lock {mutex};
+						slots[i].result = std::move(result);
+						slots[i].message = std::move(message);
+						slots[i].ready = true;
+					}
+					condition.notify_one();
+				});
+			}
+			for (std::size_t i {}; i < paths.size(); ++i)
+			{
 				{
-					logger.log(std::format("Не удалось открыть \"{}\"\n", path.filename().string()));
-					return false;
+					std::unique_lock<std::mutex> lock {mutex};
+					condition.wait(lock, [&slots, i] { return slots[i].ready; });
 				}
+				settle(paths[i], slots[i].result, slots[i].message);
 			}
+			pool.wait();
 		}
+		// buffers grown by a huge file are not kept until the next add_all()
+		for (const auto & arena : m_arenas) { arena->trim(retained); }
+		if (!known->second.size())
+		{
+			logger.log(std::format("Нет файлов в \"{}\"\n", path.string()), logger::severity::WARNING);
+		}
+		else if (paths.empty() && changes.removed.empty())
+		{
+			logger.log(std::format("Нет изменений в \"{}\"\n", path.string()));
+		}
+		else if (!paths.empty())
+		{
+			logger.log(std::format("{} файл(ов) добавлен(о)\n", file_count));
+		}
+		if (updated || !changes.removed.empty())
+		{
+			logger.log(std::format("{} файл(ов) изменено, {} удалено\n", updated, changes.removed.size()));
+		}
+		if (m_cache.enabled() && !paths.empty())
+		{
+			logger.log(std::format("Кэш: {} из кэша, {} разобрано заново\n", m_cache.hits() - hits, m_cache.misses() - misses));
+		}
+		return known->second.size() && file_count == paths.size();
 	}
 
-	void file_collection::add_all(const std::filesystem::path & path, logger & logger)
+	bool file_collection::follow(const std::filesystem::path & path, logger & logger,
+								 const std::function<void(const std::string &)> & refresh, std::stop_token stop,
+								 std::chrono::milliseconds idle)
 	{
-		uint32_t file_count {};
-		// check all files at given directory with recursive directory iterator
-		for (std::filesystem::directory_entry entry : std::filesystem::recursive_directory_iterator(path))
+		tail source;
+		if (!source.open(path.string()))
+		{
+			logger.log(std::format("Не удалось открыть \"{}\"\n", path.filename().string()), logger::severity::FAILURE);
+			return false;
+		}
+		// same values as analyze() finds in a loaded file, but updated row by row
+		statistics::running deviation_X;
+		statistics::running deviation_Y;
+		statistics::running deviation_Z;
+		int64_t temperature_X {};
+		int64_t temperature_Y {};
+		int64_t temperature_Z {};
+		std::size_t size {};
+		uint32_t first_count {};
+		// row the angles are taken from, it is fixed once found the same way analyze() finds its index
+		row anchor {};
+		bool fixed {};
+		row last {};
+		// noise terms and spectra need the whole recording, so their columns are kept and analyzed once it ends
+		std::array<std::vector<float>, noisy.size()> kept;
+		auto snapshot {[&]
+		{
+			estimate result {};
+			result.thdg = convert_degree(anchor.thdg);
+			result.roll = convert_degree(anchor.roll);
+			result.pitch = convert_degree(anchor.pitch);
+			result.heading = static_cast<uint32_t>(std::roundf(anchor.thdg));
+			if (result.heading == 360) { result.heading = 0; }
+			result.duration = last.count;
+			result.deviation_X = static_cast<float>(deviation_X.get().deviation);
+			result.deviation_Y = static_cast<float>(deviation_Y.get().deviation);
+			result.deviation_Z = static_cast<float>(deviation_Z.get().deviation);
+			// sums are divided before they are narrowed, so long recordings do not overflow
+			const auto rows {static_cast<int64_t>(size)};
+			result.temperature_X = static_cast<int32_t>(temperature_X / rows / 100);
+			result.temperature_Y = static_cast<int32_t>(temperature_Y / rows / 100);
+			result.temperature_Z = static_cast<int32_t>(temperature_Z / rows / 100);
+			return result;
+		}};
+		std::vector<row> rows;
+		auto arrived {std::chrono::steady_clock::now()};
+		while (!stop.stop_requested())
 		{
-			if (entry.path().filename().extension().string() == (m_extension == extension::DAT ? extension::DAT : extension::TXT))
+			rows.clear();
+			if (source.read(rows, analyzed))
 			{
-				if (this->add(entry.path(), logger))
+				for (const row & row : rows)
 				{
-					++file_count;
+					if (!size) { first_count = row.count; }
+					// the row where 'count' is 600, or the second row if recording starts later, else the last row
+					if (!fixed)
+					{
+						anchor = row;
+						fixed = first_count > 600 ? size == 1 : row.count == 600;
+					}
+					deviation_X.push(row.gyro_X);
+					deviation_Y.push(row.gyro_Y);
+					deviation_Z.push(row.gyro_Z);
+					for (std::size_t i {}; i < noisy.size(); ++i) { kept[i].push_back(row.*noisy[i]); }
+					temperature_X += row.gyro_X_temperature;
+					temperature_Y += row.gyro_Y_temperature;
+					temperature_Z += row.gyro_Z_temperature;
+					last = row;
+					++size;
 				}
+				refresh(std::format("{}", snapshot()));
+				arrived = std::chrono::steady_clock::now();
+			}
+			else if (source.ended() || std::chrono::steady_clock::now() - arrived > idle)
+			{
+				break;
+			}
+			else
+			{
+				std::this_thread::sleep_for(follow_period);
 			}
 		}
-		if (!file_count)
+		if (!size)
+		{
+			logger.log(std::format("Нет данных в \"{}\"\n", path.filename().string()), logger::severity::WARNING);
+			return false;
+		}
+		estimate result {snapshot()};
+		std::array<std::span<const float>, noisy.size()> columns {};
+		std::copy(kept.begin(), kept.end(), columns.begin());
+		this->characterize(result, columns, m_threads);
+		m_collection.insert_or_assign(path.string(), path.filename().string(), result);
+		if (stop.stop_requested())
 		{
-			logger.log(std::format("Нет файлов в \"{}\"\n", path.string()));
+			logger.log(std::format("Анализ записи \"{}\" остановлен, строк: {}\n", path.filename().string(), size));
 		}
 		else
 		{
-			logger.log(std::format("{} файл(ов) добавлен(о)\n", file_count));
+			logger.log(std::format("Запись \"{}\" завершена, строк: {}\n", path.filename().string(), size));
 		}
+		return true;
 	}
 
-	bool file_collection::convert(const std::filesystem::path & path, logger & logger)
+	bool file_collection::convert(const std::filesystem::path & path, logger & logger, extension target)
 	{
 		std::unique_ptr<file> file {std::make_unique<ws::data::file>()};
-		if (file->load<extension::DAT>(path.string()))
+		bool loaded {};
+		{
+			WS_PROFILE(PARSE);
+			loaded = file->load<extension::DAT, loader::MAPPED>(path.string());
+		}
+		if (loaded)
 		{
+			WS_COUNT(FILES_LOADED, 1);
+			WS_COUNT(ROWS_DECODED, file->size());
+			WS_COUNT(BYTES_READ, size_of(path));
+			if (const std::string message {damage(path, file->get_integrity())}; !message.empty())
+			{
+				logger.log(message, logger::severity::WARNING);
+			}
 			std::filesystem::path new_path(path);
-			new_path.replace_extension(".txt");
-			file->save<extension::TXT>(new_path.string());
+			new_path.replace_extension(suffix(target));
+			{
+				WS_PROFILE(WRITE);
+				target == extension::ARC ? file->save<extension::ARC>(new_path.string()) : file->save<extension::TXT>(new_path.string());
+			}
 			logger.log(std::format("\"{}\" {} \"{}\"",
 								   path.filename().string(),
 								   utility::apply("->", utility::text::GREEN),
@@ -95,65 +376,417 @@ namespace ws::data
 		}
 		else
 		{
-			logger.log(std::format("Не удалось конвертировать \"{}\"\n", path.string()));
+			logger.log(std::format("Не удалось конвертировать \"{}\"\n", path.string()), logger::severity::FAILURE);
 			return false;
 		}
 	}
 
-	void file_collection::convert_all(const std::filesystem::path & path, logger & logger)
+	bool file_collection::convert_all(const std::filesystem::path & path, logger & logger, extension target)
 	{
-		uint32_t file_count {};
+		std::vector<std::filesystem::path> paths;
 		for (std::filesystem::directory_entry entry : std::filesystem::recursive_directory_iterator(path))
 		{
 			if (entry.path().filename().extension().string() == extension::DAT)
 			{
-				if (this->convert(entry.path(), logger))
+				paths.push_back(entry.path());
+			}
+		}
+		// reading, formatting and writing run in their own threads and pass files to the next stage through
+		// short queues, so disk and processor work at the same time; a full queue stops the previous stage,
+		// thus no more than a few files are kept in memory however many files are converted
+		struct loaded
+		{
+			std::filesystem::path path;
+			std::unique_ptr<ws::data::file> data;
+		};
+		struct formatted
+		{
+			std::filesystem::path path;
+			std::string text;
+			bool loaded;
+		};
+		// time each stage spent working (waiting for other stages excluded) and amount of bytes it processed
+		struct stage
+		{
+			double seconds;
+			std::uintmax_t bytes;
+		};
+		constexpr std::size_t depth {4};
+		bounded_queue<loaded> to_format {depth};
+		bounded_queue<formatted> to_write {depth};
+		stage reading {};
+		stage formatting {};
+		stage writing {};
+		auto elapsed {[](std::chrono::steady_clock::time_point begin)
+		{
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		}};
+
+		std::thread reader {[&paths, &to_format, &reading, &elapsed]
+		{
+			for (const auto & path : paths)
+			{
+				auto begin {std::chrono::steady_clock::now()};
+				std::unique_ptr<file> file {std::make_unique<ws::data::file>()};
+				{
+					WS_PROFILE(PARSE);
+					if (file->load<extension::DAT, loader::MAPPED>(path.string()))
+					{
+						std::error_code error;
+						auto size {std::filesystem::file_size(path, error)};
+						reading.bytes += error ? 0 : size;
+						WS_COUNT(FILES_LOADED, 1);
+						WS_COUNT(ROWS_DECODED, file->size());
+						WS_COUNT(BYTES_READ, error ? 0 : size);
+					}
+					else
+					{
+						WS_COUNT(FILES_FAILED, 1);
+						file.reset();
+					}
+				}
+				reading.seconds += elapsed(begin);
+				to_format.push({path, std::move(file)});
+			}
+			to_format.close();
+		}};
+
+		std::thread formatter {[&to_format, &to_write, &formatting, &elapsed, target]
+		{
+			loaded item;
+			while (to_format.pop(item))
+			{
+				auto begin {std::chrono::steady_clock::now()};
+				formatted result {std::move(item.path), {}, item.data != nullptr};
+				if (item.data)
 				{
-					++file_count;
+					WS_PROFILE(FORMAT);
+					target == extension::ARC ? item.data->encode<extension::ARC>(result.text) : item.data->encode<extension::TXT>(result.text);
+					item.data.reset();
 				}
+				formatting.bytes += result.text.size();
+				formatting.seconds += elapsed(begin);
+				to_write.push(std::move(result));
+			}
+			to_write.close();
+		}};
+
+		// this thread writes files and messages to the logger in the order files were found
+		uint32_t file_count {};
+		uint32_t failed {};
+		formatted item;
+		while (to_write.pop(item))
+		{
+			if (!item.loaded)
+			{
+				logger.log(std::format("Не удалось конвертировать \"{}\"\n", item.path.string()), logger::severity::FAILURE);
+				++failed;
+				continue;
+			}
+			auto begin {std::chrono::steady_clock::now()};
+			std::filesystem::path new_path(item.path);
+			new_path.replace_extension(suffix(target));
+			bool written {};
+			{
+				WS_PROFILE(WRITE);
+				// an archive is written byte for byte, text gets line endings of the system
+				std::ofstream fout {new_path.string(), target == extension::ARC ? std::ios_base::out | std::ios_base::binary : std::ios_base::out};
+				fout.write(item.text.data(), static_cast<std::streamsize>(item.text.size()));
+				fout.close();
+				written = !fout.fail();
+			}
+			writing.bytes += item.text.size();
+			writing.seconds += elapsed(begin);
+			if (!written)
+			{
+				logger.log(std::format("Не удалось записать \"{}\"\n", new_path.string()), logger::severity::FAILURE);
+				++failed;
+				continue;
 			}
+			logger.log(std::format("\"{}\" {} \"{}\"",
+								   item.path.filename().string(),
+								   utility::apply("->", utility::text::GREEN),
+								   new_path.filename().string()));
+			++file_count;
 		}
+		reader.join();
+		formatter.join();
+
 		if (!file_count)
 		{
-			logger.log(std::format("Нет файлов для конвертирования\n"));
+			logger.log(std::format("Нет файлов для конвертирования\n"), logger::severity::WARNING);
 		}
 		else
 		{
 			logger.log(std::format("\n{} файла(ов) конвертировано\n", file_count));
+			// the stage with the longest time is the bottleneck
+			auto speed {[](const stage & stage)
+			{
+				return stage.seconds > 0.0 ? static_cast<double>(stage.bytes) / (1024.0 * 1024.0) / stage.seconds : 0.0;
+			}};
+			logger.log(std::format("Чтение: {:.2f} с ({:.1f} МБ/с), форматирование: {:.2f} с ({:.1f} МБ/с), запись: {:.2f} с ({:.1f} МБ/с)\n",
+								   reading.seconds, speed(reading),
+								   formatting.seconds, speed(formatting),
+								   writing.seconds, speed(writing)));
 		}
+		return file_count && !failed;
 	}
 
-	void file_collection::save_data(const std::string_view filename, logger & logger) const
+	bool file_collection::save_data(const std::string_view filename, logger & logger) const
 	{
+		WS_PROFILE(SAVE);
 		// replace all spaces between words with tab symbol so .txt file could be open
 		// in 'MS Excel' later using tab delimiter
-		std::ofstream fout {filename.data(), std::ios_base::out};
-		if (!fout.is_open())
+		ws::data::writer fout;
+		if (!fout.open(filename))
 		{
-			logger.log(std::format("Не удалось записать в файл \"{}\"\n", filename.data()));
+			logger.log(std::format("Не удалось записать в файл \"{}\"\n", filename.data()), logger::severity::FAILURE);
+			return false;
 		}
 		for (const auto & data : m_collection)
 		{
+			const estimate & result {data.value};
 			// filename
-			fout << std::format("{:-<74}\n", data.second.first);
+			fout.print("{:-<74}\n", data.name);
 			// first row
-			fout << std::format("Heading:\t{}°\t", data.second.second->heading);
-			fout << std::format("THdg:\t{}°{:>2}'{:>2}\"\t", data.second.second->thdg.degree, data.second.second->thdg.minute, data.second.second->thdg.second);
-			fout << std::format("{}°{:0>2}'{:0>2}\"\t", data.second.second->thdg.degree_error, data.second.second->thdg.minute_error, data.second.second->thdg.second_error);
-			fout << std::format("X\t{:.4f}\n", data.second.second->deviation_X);
+			fout.print("Heading:\t{}°\t", result.heading);
+			fout.print("THdg:\t{}°{:>2}'{:>2}\"\t", result.thdg.degree, result.thdg.minute, result.thdg.second);
+			fout.print("{}°{:0>2}'{:0>2}\"\t", result.thdg.degree_error, result.thdg.minute_error, result.thdg.second_error);
+			fout.print("X\t{:.4f}\n", result.deviation_X);
 			// second row
-			fout << std::format("Duration:\t{} s.\t", data.second.second->duration);
-			fout << std::format("Roll:\t{}°{}'{}\"\t", data.second.second->roll.degree, data.second.second->roll.minute, data.second.second->roll.second);
-			fout << std::format("{}°{:0>2}'{:0>2}\"\t", data.second.second->roll.degree_error, data.second.second->roll.minute_error, data.second.second->roll.second_error);
-			fout << std::format("Y\t{:.4f}\n", data.second.second->deviation_Y);
+			fout.print("Duration:\t{} s.\t", result.duration);
+			fout.print("Roll:\t{}°{}'{}\"\t", result.roll.degree, result.roll.minute, result.roll.second);
+			fout.print("{}°{:0>2}'{:0>2}\"\t", result.roll.degree_error, result.roll.minute_error, result.roll.second_error);
+			fout.print("Y\t{:.4f}\n", result.deviation_Y);
 			// third row
-			fout << std::format("Temperature:\t{}°C\t", (data.second.second->temperature_X + data.second.second->temperature_Y + data.second.second->temperature_Z) / 3);
-			fout << std::format("Pitch:\t{}°{}'{}\"\t", data.second.second->pitch.degree, data.second.second->pitch.minute, data.second.second->pitch.second);
-			fout << std::format("{}°{:0>2}'{:0>2}\"\t", data.second.second->pitch.degree_error, data.second.second->pitch.minute_error, data.second.second->pitch.second_error);
-			fout << std::format("Z\t{:.4f}\n\n", data.second.second->deviation_Z);
+			fout.print("Temperature:\t{}°C\t", (result.temperature_X + result.temperature_Y + result.temperature_Z) / 3);
+			fout.print("Pitch:\t{}°{}'{}\"\t", result.pitch.degree, result.pitch.minute, result.pitch.second);
+			fout.print("{}°{:0>2}'{:0>2}\"\t", result.pitch.degree_error, result.pitch.minute_error, result.pitch.second_error);
+			fout.print("Z\t{:.4f}\n\n", result.deviation_Z);
+		}
+		if (!fout.close())
+		{
+			logger.log(std::format("Не удалось записать в файл \"{}\"\n", filename.data()), logger::severity::FAILURE);
+			return false;
 		}
 		logger.log(std::format("Анализ успешно записан в \"{}\"\n", filename.data()));
-		fout.close();
+		return true;
+	}
+
+	bool file_collection::save_json(const std::string_view filename, logger & logger) const
+	{
+		// one object per file, angles in decimal degrees and their errors in arc seconds, so scripts need
+		// not parse the text report
+		ws::data::writer fout;
+		if (!fout.open(filename))
+		{
+			logger.log(std::format("Не удалось записать в файл \"{}\"\n", filename.data()), logger::severity::FAILURE);
+			return false;
+		}
+		auto angle {[](const estimate::angle & angle)
+		{
+			const float sign {std::signbit(angle.degree) ? -1.0f : 1.0f};
+			return std::format("{{\"value\": {}, \"error\": {}}}", number(angle.degree + sign * (angle.minute / 60.0f + angle.second / 3600.0f), "{:.6f}"),
+							   number(angle.degree_error * 3600.0f + angle.minute_error * 60.0f + angle.second_error));
+		}};
+		auto noise {[](const allan::coefficients & coefficients)
+		{
+			return std::format("{{\"random_walk\": {}, \"bias_instability\": {}, \"rate_random_walk\": {}}}",
+							   number(coefficients.random_walk, "{:.6g}"), number(coefficients.bias_instability, "{:.6g}"),
+							   number(coefficients.rate_random_walk, "{:.6g}"));
+		}};
+		// axes X, Y and Z of a sensor
+		auto spectra {[](const std::array<spectrum::features, 3> & axes)
+		{
+			std::string result;
+			for (const spectrum::features & features : axes)
+			{
+				std::string bands;
+				for (const float band : features.band) { bands += std::format("{}{}", bands.empty() ? "" : ", ", number(band, "{:.6g}")); }
+				result += std::format("{}{{\"peak\": {}, \"power\": {}, \"bands\": [{}]}}", result.empty() ? "[" : ", ",
+									  number(features.peak, "{:.6g}"), number(features.power, "{:.6g}"), bands);
+			}
+			return result + "]";
+		}};
+		fout.print("[\n");
+		std::size_t i {};
+		for (const auto & data : m_collection)
+		{
+			const estimate & result {data.value};
+			const auto failed {to_sample(result).failed};
+			const bool passed {!failed[0] && !failed[1] && !failed[2]};
+			fout.print("  {{\"path\": {}, \"heading\": {}, \"duration\": {}, \"thdg\": {}, \"roll\": {}, \"pitch\": {}, "
+					   "\"deviation\": [{}, {}, {}], \"temperature\": [{}, {}, {}], \"allan\": [{}, {}, {}], "
+					   "\"spectrum\": {{\"gyro\": {}, \"acc\": {}, \"dither\": {}}}, \"passed\": {}}}{}\n",
+					   quote(data.path), result.heading, result.duration, angle(result.thdg), angle(result.roll), angle(result.pitch),
+					   number(result.deviation_X, "{:.4f}"), number(result.deviation_Y, "{:.4f}"), number(result.deviation_Z, "{:.4f}"),
+					   result.temperature_X, result.temperature_Y, result.temperature_Z,
+					   noise(result.allan_X), noise(result.allan_Y), noise(result.allan_Z),
+					   spectra(result.gyro_spectrum), spectra(result.acc_spectrum), spectra(result.dither_spectrum),
+					   passed, ++i < m_collection.size() ? "," : "");
+		}
+		fout.print("]\n");
+		if (!fout.close())
+		{
+			logger.log(std::format("Не удалось записать в файл \"{}\"\n", filename.data()), logger::severity::FAILURE);
+			return false;
+		}
+		logger.log(std::format("Анализ успешно записан в \"{}\"\n", filename.data()));
+		return true;
+	}
+
+	bool file_collection::save_allan(const std::string_view filename, logger & logger) const
+	{
+		// one row per file, tab delimited like save_data(), so the table opens in 'MS Excel' as it is
+		ws::data::writer fout;
+		if (!fout.open(filename))
+		{
+			logger.log(std::format("Не удалось записать в файл \"{}\"\n", filename.data()), logger::severity::FAILURE);
+			return false;
+		}
+		fout.print("File\tDuration, s");
+		for (const char axis : {'X', 'Y', 'Z'})
+		{
+			fout.print("\tARW {0}\tBias instability {0}\tRRW {0}", axis);
+		}
+		fout.print("\n");
+		for (const auto & data : m_collection)
+		{
+			const estimate & result {data.value};
+			fout.print("{}\t{}", data.name, result.duration);
+			for (const allan::coefficients & coefficients : {result.allan_X, result.allan_Y, result.allan_Z})
+			{
+				fout.print("\t{:.6g}\t{:.6g}\t{:.6g}", coefficients.random_walk, coefficients.bias_instability, coefficients.rate_random_walk);
+			}
+			fout.print("\n");
+		}
+		if (!fout.close())
+		{
+			logger.log(std::format("Не удалось записать в файл \"{}\"\n", filename.data()), logger::severity::FAILURE);
+			return false;
+		}
+		logger.log(std::format("Шумы гироскопов успешно записаны в \"{}\"\n", filename.data()));
+		return true;
+	}
+
+	bool file_collection::save_spectrum(const std::string_view filename, logger & logger) const
+	{
+		// one row per file like save_allan(), every column of the file takes peak frequency, power and power in bands
+		ws::data::writer fout;
+		if (!fout.open(filename))
+		{
+			logger.log(std::format("Не удалось записать в файл \"{}\"\n", filename.data()), logger::severity::FAILURE);
+			return false;
+		}
+		constexpr std::string_view sensors[] {"gyro", "acc", "F_dith"};
+		fout.print("File\tDuration, s");
+		for (const std::string_view sensor : sensors)
+		{
+			for (const char axis : {'X', 'Y', 'Z'})
+			{
+				fout.print("\tPeak {0}_{1}, Hz\tPower {0}_{1}", sensor, axis);
+				for (std::size_t band {1}; band <= spectrum::bands; ++band) { fout.print("\tBand {} {}_{}", band, sensor, axis); }
+			}
+		}
+		fout.print("\n");
+		for (const auto & data : m_collection)
+		{
+			const estimate & result {data.value};
+			fout.print("{}\t{}", data.name, result.duration);
+			for (const auto * axes : {&result.gyro_spectrum, &result.acc_spectrum, &result.dither_spectrum})
+			{
+				for (const spectrum::features & features : *axes)
+				{
+					fout.print("\t{:.6g}\t{:.6g}", features.peak, features.power);
+					for (const float band : features.band) { fout.print("\t{:.6g}", band); }
+				}
+			}
+			fout.print("\n");
+		}
+		if (!fout.close())
+		{
+			logger.log(std::format("Не удалось записать в файл \"{}\"\n", filename.data()), logger::severity::FAILURE);
+			return false;
+		}
+		logger.log(std::format("Спектры успешно записаны в \"{}\"\n", filename.data()));
+		return true;
+	}
+
+	aggregate::report file_collection::summarize() const
+	{
+		WS_PROFILE(AGGREGATE);
+		std::vector<aggregate::sample> samples;
+		samples.reserve(m_collection.size());
+		for (const auto & data : m_collection)
+		{
+			samples.push_back(to_sample(data.value));
+		}
+		return aggregate::summarize(samples, m_threads);
+	}
+
+	bool file_collection::save_summary(const std::string_view filename, logger & logger) const
+	{
+		return this->save_summary(filename, this->summarize(), logger);
+	}
+
+	bool file_collection::save_summary(const std::string_view filename, const aggregate::report & report, logger & logger) const
+	{
+		// every group is an object with the number of files, how many passed and failed on every limit, and
+		// statistics of errors in arc seconds and of deviations of the gyroscopes
+		ws::data::writer fout;
+		if (!fout.open(filename))
+		{
+			logger.log(std::format("Не удалось записать в файл \"{}\"\n", filename.data()), logger::severity::FAILURE);
+			return false;
+		}
+		auto statistics {[](const statistics::running & running)
+		{
+			const statistics::summary summary {running.get()};
+			return std::format("{{\"mean\": {:.4f}, \"deviation\": {:.4f}, \"min\": {:.4f}, \"max\": {:.4f}}}",
+							   summary.mean, summary.deviation, summary.min, summary.max);
+		}};
+		auto group {[&statistics](const aggregate::group & group)
+		{
+			return std::format("\"files\": {}, \"passed\": {}, \"failed\": {{\"thdg\": {}, \"roll\": {}, \"pitch\": {}}}, "
+							   "\"errors\": {{\"thdg\": {}, \"roll\": {}, \"pitch\": {}}}, \"deviation\": [{}, {}, {}]",
+							   group.count, group.passed, group.failed[0], group.failed[1], group.failed[2],
+							   statistics(group.errors[0]), statistics(group.errors[1]), statistics(group.errors[2]),
+							   statistics(group.deviation[0]), statistics(group.deviation[1]), statistics(group.deviation[2]));
+		}};
+		fout.print("{{\n  \"limits\": {{\"thdg\": {}, \"roll\": {}, \"pitch\": {}}},\n", heading_limit, tilt_limit, tilt_limit);
+		fout.print("  \"total\": {{{}}},\n  \"rhumbs\": [\n", group(report.total));
+		for (std::size_t i {}; i < report.rhumbs.size(); ++i)
+		{
+			fout.print("    {{\"rhumb\": {}, \"heading\": {}, {}}}{}\n", report.rhumbs[i].first, aggregate::bearing(report.rhumbs[i].first),
+					   group(report.rhumbs[i].second), i + 1 < report.rhumbs.size() ? "," : "");
+		}
+		fout.print("  ],\n  \"temperature\": [\n");
+		for (std::size_t i {}; i < report.bands.size(); ++i)
+		{
+			fout.print("    {{\"from\": {}, \"to\": {}, {}}}{}\n", report.bands[i].first, report.bands[i].first + aggregate::band_width,
+					   group(report.bands[i].second), i + 1 < report.bands.size() ? "," : "");
+		}
+		fout.print("  ],\n  \"deviation\": [\n");
+		for (std::size_t axis {}; axis < 3; ++axis)
+		{
+			const aggregate::distribution & distribution {report.deviation[axis]};
+			std::string histogram;
+			for (const std::size_t count : distribution.histogram)
+			{
+				histogram += std::format("{}{}", histogram.empty() ? "" : ", ", count);
+			}
+			fout.print("    {{\"axis\": \"{}\", \"mean\": {:.4f}, \"deviation\": {:.4f}, \"min\": {:.4f}, \"max\": {:.4f}, \"histogram\": [{}]}}{}\n",
+					   "XYZ"[axis], distribution.summary.mean, distribution.summary.deviation, distribution.summary.min,
+					   distribution.summary.max, histogram, axis < 2 ? "," : "");
+		}
+		fout.print("  ]\n}}\n");
+		if (!fout.close())
+		{
+			logger.log(std::format("Не удалось записать в файл \"{}\"\n", filename.data()), logger::severity::FAILURE);
+			return false;
+		}
+		logger.log(std::format("Сводка успешно записана в \"{}\"\n", filename.data()));
+		return true;
 	}
 
 	bool file_collection::empty() const
@@ -163,7 +796,17 @@ namespace ws::data
 
 	void file_collection::set_extension()
 	{
-		m_extension == extension::DAT ? m_extension = extension::TXT : m_extension = extension::DAT;
+		switch (m_extension)
+		{
+		case extension::DAT: m_extension = extension::TXT; break;
+		case extension::TXT: m_extension = extension::ARC; break;
+		default: m_extension = extension::DAT; break;
+		}
+	}
+
+	void file_collection::set_extension(extension extension)
+	{
+		m_extension = extension;
 	}
 
 	extension file_collection::get_extension() const
@@ -171,73 +814,177 @@ namespace ws::data
 		return m_extension;
 	}
 
-	const std::map<std::string, std::pair<std::string, std::unique_ptr<file_collection::estimate>>> & file_collection::get_data() const
+	void file_collection::set_threads(uint32_t threads)
+	{
+		m_threads = threads;
+	}
+
+	uint32_t file_collection::get_threads() const
+	{
+		return m_threads;
+	}
+
+	void file_collection::set_watch(bool watch)
+	{
+		m_watch = watch;
+	}
+
+	bool file_collection::get_watch() const
+	{
+		return m_watch;
+	}
+
+	bool file_collection::set_cache(const std::filesystem::path & folder, std::uintmax_t capacity)
+	{
+		return m_cache.open(folder, capacity);
+	}
+
+	const cache & file_collection::get_cache() const
+	{
+		return m_cache;
+	}
+
+	const result_store<file_collection::estimate> & file_collection::get_data() const
 	{
 		return m_collection;
 	}
 
-	std::unique_ptr<file_collection::estimate> file_collection::analyze(const std::unique_ptr<file> & new_file)
+	std::optional<file_collection::estimate> file_collection::ingest(const std::filesystem::path & path, std::string & message,
+																	  std::pmr::memory_resource * resource, uint32_t threads) const
 	{
+		// keep loaded fields column by column, the file is gone before the function returns
+		std::unique_ptr<file> file {std::make_unique<ws::data::file>(storage::COLUMNS, analyzed, resource)};
+		bool cached {};
+		{
+			WS_PROFILE(CACHE);
+			cached = m_cache.load(path, *file);
+		}
+		if (cached)
+		{
+			WS_COUNT(FILES_CACHED, 1);
+			message = damage(path, file->get_integrity());
+			return this->analyze(file, threads);
+		}
+		bool loaded {};
+		{
+			WS_PROFILE(PARSE);
+			const std::string suffix {path.filename().extension().string()};
+			if (suffix == extension::DAT) { loaded = file->load<extension::DAT, loader::MAPPED>(path.string()); }
+			else if (suffix == extension::ARC) { loaded = file->load<extension::ARC, loader::MAPPED>(path.string()); }
+			else { loaded = file->load<extension::TXT, loader::BUFFERED>(path.string()); }
+		}
+		if (loaded)
+		{
+			WS_COUNT(FILES_LOADED, 1);
+			WS_COUNT(ROWS_DECODED, file->size());
+			WS_COUNT(BYTES_READ, size_of(path));
+			message = damage(path, file->get_integrity());
+			m_cache.store(path, *file);
+			return this->analyze(file, threads);
+		}
+		WS_COUNT(FILES_FAILED, 1);
+		if (file->get_error().line)
+		{
+			message = std::format("Ошибка в \"{}\": строка {}, столбец {}\n",
+								  path.filename().string(), file->get_error().line, file->get_error().column);
+		}
+		else
+		{
+			message = std::format("Не удалось открыть \"{}\"\n", path.filename().string());
+		}
+		return std::nullopt;
+	}
+
+	file_collection::estimate file_collection::analyze(const std::unique_ptr<file> & new_file, uint32_t threads) const
+	{
+		WS_PROFILE(ANALYZE);
 		// find index where value of '600' is located in the array, all later calculations will use this index
 		auto find_index {[](const std::unique_ptr<file> & file, const uint32_t row:: * member) -> std::size_t
 		{
-			// if file begins with value greater than '600', return '1' as index, i.e. first index
-			if (file->get_data().front().*member > 600)
+			auto column {file->column(member)};
+			// if file begins with value greater than '600', return '1' as index, i.e. first index, or the only one
+			if (column.front() > 600)
 			{
-				return static_cast<std::size_t>(1);
+				return std::min<std::size_t>(1, column.size() - 1);
 			}
-			// else find '600'
+			// else find '600', counts grow by one, so it is found by its offset or by binary search (see 'record.h')
 			else
 			{
-				for (auto i {file->get_data().cbegin()}; i != file->get_data().cend(); ++i)
-				{
-					if ((*i).*member == 600)
-					{
-						return static_cast<std::size_t>(std::distance(file->get_data().cbegin(), i));
-					}
-				}
+				const std::size_t index {seek(column.size(), 600, [&column](std::size_t i) { return column[i]; })};
 				// if file is too short (no value '600' found), return the lenght of file as index, i.e. last index
-				return static_cast<std::size_t>(std::distance(file->get_data().cbegin(), file->get_data().cend()) - 1);
+				return index < column.size() && column[index] == 600 ? index : column.size() - 1;
 			}
 		}};
 
+		estimate result {};
+		// nothing to read from a file without rows, or with fields kept row by row (see 'file.h')
+		if (new_file->column(&row::count).empty())
+		{
+			return result;
+		}
 		auto index {find_index(new_file, &row::count)};
-		std::unique_ptr<estimate> result {std::make_unique<estimate>()};
-		result->thdg = convert_degree(new_file->get_data().at(index).thdg);
-		result->roll = convert_degree(new_file->get_data().at(index).roll);
-		result->pitch = convert_degree(new_file->get_data().at(index).pitch);
-		result->heading = static_cast<uint32_t>(std::roundf(new_file->get_data().at(index).thdg));
-		if (result->heading == 360) { result->heading = 0; }
-		result->duration = new_file->get_data().back().count;
-		result->deviation_X = deviation(new_file, &row::gyro_X);
-		result->deviation_Y = deviation(new_file, &row::gyro_Y);
-		result->deviation_Z = deviation(new_file, &row::gyro_Z);
-		auto size {static_cast<int>(new_file->get_data().size())};
-		result->temperature_X = this->accumulate(new_file, &row::gyro_X_temperature) / size / 100;
-		result->temperature_Y = this->accumulate(new_file, &row::gyro_Y_temperature) / size / 100;
-		result->temperature_Z = this->accumulate(new_file, &row::gyro_Z_temperature) / size / 100;
+		result.thdg = convert_degree(new_file->column(&row::thdg)[index]);
+		result.roll = convert_degree(new_file->column(&row::roll)[index]);
+		result.pitch = convert_degree(new_file->column(&row::pitch)[index]);
+		result.heading = static_cast<uint32_t>(std::roundf(new_file->column(&row::thdg)[index]));
+		if (result.heading == 360) { result.heading = 0; }
+		result.duration = new_file->column(&row::count).back();
+		result.deviation_X = deviation(new_file, &row::gyro_X);
+		result.deviation_Y = deviation(new_file, &row::gyro_Y);
+		result.deviation_Z = deviation(new_file, &row::gyro_Z);
+		auto size {static_cast<int64_t>(new_file->size())};
+		result.temperature_X = static_cast<int32_t>(this->accumulate(new_file, &row::gyro_X_temperature) / size / 100);
+		result.temperature_Y = static_cast<int32_t>(this->accumulate(new_file, &row::gyro_Y_temperature) / size / 100);
+		result.temperature_Z = static_cast<int32_t>(this->accumulate(new_file, &row::gyro_Z_temperature) / size / 100);
+		std::array<std::span<const float>, noisy.size()> columns {};
+		for (std::size_t i {}; i < noisy.size(); ++i) { columns[i] = new_file->column(noisy[i]); }
+		this->characterize(result, columns, threads);
 		return result;
 	}
 
-	float file_collection::deviation(const std::unique_ptr<file> & file, const float row:: * member)
+	void file_collection::characterize(estimate & result, std::span<const std::span<const float>> columns, uint32_t threads) const
 	{
-		// standart deviation formula: σ = sqrt((∑(variable - average) ^ 2) / size - 1)
-		// (*i).*member represents each veriable contained in given array (vector)
-		// calculate average value of given array
-		float average {this->accumulate<float>(file, member) / file->get_data().size()};
-		std::vector<float> difference;
-		difference.reserve(file->get_data().size());
-		// calculate (variable - average) ^ 2 part
-		for (auto i {file->get_data().cbegin()}; i != file->get_data().cend(); ++i)
 		{
-			difference.push_back(static_cast<float>(std::pow((*i).*member - average, 2)));
+			WS_PROFILE(ALLAN);
+			const std::vector<allan::curve> curves {allan::compute(columns.first(3), record_period, threads)};
+			result.allan_X = curves[0].fitted;
+			result.allan_Y = curves[1].fitted;
+			result.allan_Z = curves[2].fitted;
+		}
+		{
+			WS_PROFILE(SPECTRUM);
+			const std::vector<spectrum::density> densities {spectrum::welch(columns, record_period, threads)};
+			for (std::size_t axis {}; axis < 3; ++axis)
+			{
+				result.gyro_spectrum[axis] = spectrum::describe(densities[axis]);
+				result.acc_spectrum[axis] = spectrum::describe(densities[3 + axis]);
+				result.dither_spectrum[axis] = spectrum::describe(densities[6 + axis]);
+			}
 		}
-		// calculate ∑(variable - average) ^ 2) part
-		average = accumulate(difference);
-		// calculate (∑(variable - average) ^ 2) / size - 1 part
-		average /= file->get_data().size() - 1;
-		// return sqrt((∑(variable - average) ^ 2) / size - 1)
-		return std::sqrt(average);
+	}
+
+	float file_collection::deviation(const std::unique_ptr<file> & file, const float row:: * member) const
+	{
+		// standart deviation formula: σ = sqrt((∑(variable - average) ^ 2) / size - 1)
+		// calculated in a single pass over the column (see 'statistics.h')
+		return static_cast<float>(statistics::summarize(file->column(member)).deviation);
+	}
+
+	aggregate::sample file_collection::to_sample(const estimate & result)
+	{
+		auto seconds {[](const estimate::angle & angle)
+		{
+			return angle.degree_error * 3600.0f + angle.minute_error * 60.0f + angle.second_error;
+		}};
+		// same limits as the report marks red, checked the same way: minutes and seconds of the error
+		auto over {[](const estimate::angle & angle, float limit)
+		{
+			return angle.minute_error * 60.0f + angle.second_error > limit;
+		}};
+		return aggregate::sample {result.heading, (result.temperature_X + result.temperature_Y + result.temperature_Z) / 3,
+								  {seconds(result.thdg), seconds(result.roll), seconds(result.pitch)},
+								  {result.deviation_X, result.deviation_Y, result.deviation_Z},
+								  {over(result.thdg, heading_limit), over(result.roll, tilt_limit), over(result.pitch, tilt_limit)}};
 	}
 
 	file_collection::estimate::angle file_collection::convert_degree(float degree) const
@@ -260,24 +1007,9 @@ namespace ws::data
 	}
 
 	template <typename T>
-	T file_collection::accumulate(const std::unique_ptr<file> & file, const T row:: * member) const
+	std::conditional_t<std::is_integral_v<T>, int64_t, T> file_collection::accumulate(const std::unique_ptr<file> & file, const T row:: * member) const
 	{
-		T sum {};
-		for (auto i {file->get_data().cbegin()}; i != file->get_data().cend(); ++i)
-		{
-			sum += (*i).*member;
-		}
-		return sum;
-	}
-
-	template <typename T>
-	T file_collection::accumulate(const std::vector<T> & data)
-	{
-		float sum {};
-		for (auto i : data)
-		{
-			sum += i;
-		}
-		return sum;
+		// only the column of the given field is read, the sum is exact in double up to 2 ^ 53
+		return static_cast<std::conditional_t<std::is_integral_v<T>, int64_t, T>>(statistics::summarize(file->column(member)).sum);
 	}
-}
\ No newline at end of file
+}
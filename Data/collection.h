@@ -7,36 +7,94 @@
 
 #pragma once
 #include <map>
+#include <optional>
+#include <chrono>
+#include <functional>
+#include <type_traits>
 #include <memory>
 #include <filesystem>
+#include <stop_token>
 #include "file.h"
+#include "aggregate.h"
+#include "allan.h"
+#include "spectrum.h"
+#include "arena.h"
+#include "cache.h"
+#include "manifest.h"
+#include "store.h"
 #include "logger.h"
 #include "utility.h"
 
 // File_collection class represents group of files (see 'file.h'). Struct 'estimate' is the essential of the program.
 // It contains calculated results based on a single file. Struct contains 'angle' member, which represents converted
 // decimal angle to degrees, minutes and seconds. It also has degree_error, minute_error and second_error - INS
-// deviation from set course. Has std::formatter specialization, thus it could be used as argument for std::format().
+// deviation from set course. Noise terms of every gyroscope are read from its Allan deviation (see 'allan.h'), peak
+// frequency and power in bands of every gyroscope, accelerometer and dither frequency from its spectrum (see 'spectrum.h').
+// Has std::formatter specialization, thus it could be used as argument for std::format().
 // 
 // Class properties:
 // - m_extension : extension (see file.h);
-// - m_collection: std::map - key:   - std::string - path given by user where all source files located;
-//                          - value: - std::pair   - first : std::string     - name of a single source file;
-//                                                 - second: std::unique_ptr - pointer to the 'estimate' data structure.
+// - m_threads   : number of threads used by add_all(), zero means one per hardware thread;
+// - m_watch     : if set, add_all() watches added folders for changes (Linux only, see 'watcher.h');
+// - m_manifests : states of files found by add_all() (see 'manifest.h'), one per folder and extension;
+// - m_cache     : images of already parsed files (see 'cache.h'), disabled until set_cache() is called;
+// - m_arenas    : memory for files being ingested (see 'arena.h'), the first one for the calling thread and one
+//                 more for every worker of add_all(), each is reset after every file and reused for the next one,
+//                 buffers larger than 32 MiB are freed once add() or add_all() is done;
+// - m_collection: result_store (see 'store.h') - key  : path given by user where all source files located;
+//                                              - name : name of a single source file;
+//                                              - value: the 'estimate' data structure, kept inline.
 // Class behaviors:
 // - add()           : loads a single file from given path;
-// - add_all()       : loads all files with set extenstion from given path to a folder;
-// - convert()       : converts a single .dat file to .txt;
-// - convert_all()   : converts all .dat files at given path to folder to .txt;
-// - save_data()     : saves all calculated data from 'm_collection' to .txt file;
+// - add_all()       : loads all files with set extenstion from given path to a folder, files are loaded and
+//                     analyzed in parallel (see 'thread_pool.h'), results are added in the order files were found;
+//                     if the folder was added before, only new and changed files are loaded and estimates of
+//                     removed files are dropped; returns false if no files were found or some could not be loaded;
+// - follow()        : analyzes a .dat file that is still being written or a named pipe (see 'tail.h') as records
+//                     arrive, every new batch of records gives a refreshed 'estimate' to the given function at most
+//                     20 ms after it was written; ends when the pipe is closed, no record came for the given time
+//                     or a stop is requested through the given token, which is checked every 20 ms, so it could
+//                     run on its own thread; then the last estimate is added like a loaded file, only it has noise
+//                     terms and spectra, which need the whole recording;
+// - convert()       : converts a single .dat file to .txt, or to .arc archive for long-term storage (see 'archive.h');
+// - convert_all()   : converts all .dat files at given path to folder to .txt or .arc, reading, formatting and writing
+//                     run at the same time in a pipeline (see 'bounded_queue.h'), time of every stage is logged;
+//                     returns false if no files were converted or some could not be;
+// - save_data()     : saves all calculated data from 'm_collection' to .txt file, returns false if it could not be written;
+// - save_json()     : same as save_data(), but to .json file for scripts: an array of objects, one per file, with
+//                     angles in decimal degrees, their errors in arc seconds, whether they are within limits and
+//                     noise terms and spectra;
+// - save_allan()    : saves noise terms of gyroscopes of all files to .txt file as a table, one row per file, tab
+//                     delimited for 'MS Excel', returns false if it could not be written;
+// - save_spectrum() : saves peak frequency, power and power in bands of every gyroscope, accelerometer and dither
+//                     frequency of all files to .txt file as a table like save_allan(), returns false if it could not be written;
+// - summarize()     : returns statistics of all estimates grouped by rhumb and temperature band (see 'aggregate.h'),
+//                     computed with 'm_threads' threads, the same however many;
+// - save_summary()  : saves the result of summarize(), or a report it returned earlier, to .json file for acceptance
+//                     reports, returns false if it could not be written;
 // - empty()         : checks if files were loaded;
-// - set_extension() : sets the 'm_extension' member to load .dat or .txt files;
+// - set_extension() : sets the 'm_extension' member to load .dat, .txt or .arc files, the next one in this order
+//                     if no extension is given;
 // - get_extension() : returns current state of 'm_extension' member;
+// - set_threads()   : sets the 'm_threads' member;
+// - get_threads()   : returns current state of 'm_threads' member;
+// - set_watch()     : sets the 'm_watch' member;
+// - get_watch()     : returns current state of 'm_watch' member;
+// - set_cache()     : sets folder and capacity of 'm_cache', zero capacity disables it;
+// - get_cache()     : returns a const reference to 'm_cache' member, e.g. for its hit and miss counters;
 // - get_data()      : returns a const reference to 'm_collection' member;
+// - ingest()        : loads only the fields analyze() needs from a single file, from 'm_cache' if the file did not
+//                     change since it was parsed last time, and returns its 'estimate', nothing and a message for the logger if file could not be loaded
+//                     (a warning with the estimate if broken records of a .dat file were skipped, see 'integrity.h'), safe to call from
+//                     several threads at once if each gives its own memory resource for the file;
 // - analyze()       : takes raw data and returns calculated 'estimate' data structure;
+// - characterize()  : fills noise terms and spectra of an 'estimate' from given columns of gyroscopes, accelerometers
+//                     and dither frequencies, in this order, with given number of threads;
+// - to_sample()     : takes an 'estimate' and returns what summarize() needs of it, errors in arc seconds and limits it exceeds;
 // - convert_degree(): converts decimal angle to degrees °, minutes ' and seconds ";
-// - deviation()     : calculates standard deviation;
-// - accumulate()    : calculates sum of all values in an array of data, similar to std::reduce or std::accumulate from <numeric>.
+// - deviation()     : calculates standard deviation of a single field (see 'statistics.h');
+// - accumulate()    : calculates sum of all values of a single field, similar to std::reduce or std::accumulate from <numeric>,
+//                     integers are summed in int64_t, so long recordings do not overflow.
 
 namespace ws::data
 {
@@ -67,29 +125,57 @@ namespace ws::data
 			int32_t temperature_X;
 			int32_t temperature_Y;
 			int32_t temperature_Z;
+			allan::coefficients allan_X;
+			allan::coefficients allan_Y;
+			allan::coefficients allan_Z;
+			// X, Y and Z axes
+			std::array<spectrum::features, 3> gyro_spectrum;
+			std::array<spectrum::features, 3> acc_spectrum;
+			std::array<spectrum::features, 3> dither_spectrum;
 		};
 	public:
 		bool add(const std::filesystem::path &, logger &);
-		void add_all(const std::filesystem::path &, logger &);
-		bool convert(const std::filesystem::path &, logger &);
-		void convert_all(const std::filesystem::path &, logger &);
-		void save_data(const std::string_view, logger &) const;
+		bool add_all(const std::filesystem::path &, logger &);
+		bool follow(const std::filesystem::path &, logger &, const std::function<void(const std::string &)> &,
+					std::stop_token = {}, std::chrono::milliseconds = std::chrono::seconds(10));
+		bool convert(const std::filesystem::path &, logger &, extension = extension::TXT);
+		bool convert_all(const std::filesystem::path &, logger &, extension = extension::TXT);
+		bool save_data(const std::string_view, logger &) const;
+		bool save_json(const std::string_view, logger &) const;
+		bool save_allan(const std::string_view, logger &) const;
+		bool save_spectrum(const std::string_view, logger &) const;
+		aggregate::report summarize() const;
+		bool save_summary(const std::string_view, logger &) const;
+		bool save_summary(const std::string_view, const aggregate::report &, logger &) const;
 		bool empty() const;
 		void set_extension();
+		void set_extension(extension);
 		extension get_extension() const;
-		const std::map<std::string, std::pair<std::string, std::unique_ptr<estimate>>> & get_data() const;
+		void set_threads(uint32_t);
+		uint32_t get_threads() const;
+		void set_watch(bool);
+		bool get_watch() const;
+		bool set_cache(const std::filesystem::path &, std::uintmax_t);
+		const cache & get_cache() const;
+		const result_store<estimate> & get_data() const;
 		friend std::formatter<ws::data::file_collection::estimate>;
 	private:
-		std::unique_ptr<estimate> analyze(const std::unique_ptr<file> &);
+		std::optional<estimate> ingest(const std::filesystem::path &, std::string &, std::pmr::memory_resource *, uint32_t) const;
+		estimate analyze(const std::unique_ptr<file> &, uint32_t) const;
+		void characterize(estimate &, std::span<const std::span<const float>>, uint32_t) const;
+		static aggregate::sample to_sample(const estimate &);
 		estimate::angle convert_degree(float) const;
-		float deviation(const std::unique_ptr<file> &, const float row:: *);
+		float deviation(const std::unique_ptr<file> &, const float row:: *) const;
 		template <typename T>
-		T accumulate(const std::unique_ptr<file> &, const T row:: *) const;
-		template <typename T>	
-		T accumulate(const std::vector<T> &);
+		std::conditional_t<std::is_integral_v<T>, int64_t, T> accumulate(const std::unique_ptr<file> &, const T row:: *) const;
 	private:
 		extension m_extension;
-		std::map<std::string, std::pair<std::string, std::unique_ptr<estimate>>> m_collection;
+		uint32_t m_threads;
+		bool m_watch;
+		std::map<std::pair<std::string, extension>, manifest> m_manifests;
+		cache m_cache;
+		std::vector<std::unique_ptr<arena>> m_arenas;
+		result_store<estimate> m_collection;
 	};
 }
 
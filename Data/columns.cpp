@@ -0,0 +1,174 @@
+//
+//  columns.cpp
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#include <cstddef>
+#include <bitset>
+#include <cstring>
+#include <type_traits>
+#include "columns.h"
+
+namespace ws::data
+{
+	namespace
+	{
+		enum class type : uint8_t
+		{
+			FLOAT,
+			SIGNED,
+			UNSIGNED
+		};
+
+		// type of every field of the row in declaration order, taken from the schema, so it follows any change of it
+		const std::array<type, columns::width> types {[]
+		{
+			std::array<type, columns::width> types {};
+			schema::for_each([&types](const auto & field)
+			{
+				using value = typename std::remove_cvref_t<decltype(field)>::type;
+				static_assert(std::is_same_v<value, float> || std::is_same_v<value, int> || std::is_same_v<value, uint32_t>);
+				if constexpr (std::is_same_v<value, float>) { types[columns::index(field.member)] = type::FLOAT; }
+				else if constexpr (std::is_same_v<value, int>) { types[columns::index(field.member)] = type::SIGNED; }
+				else { types[columns::index(field.member)] = type::UNSIGNED; }
+			});
+			return types;
+		}()};
+
+		static_assert(sizeof(row) == columns::width * sizeof(uint32_t), "row must not have padding");
+		static_assert(columns::width == schema::count, "every member of the row must be a field of the schema");
+	}
+
+	columns::columns(const projection & projection, std::pmr::memory_resource * resource)
+		: m_floats(make<float>(resource, std::make_index_sequence<width>())),
+		  m_signed(make<int>(resource, std::make_index_sequence<width>())),
+		  m_unsigned(make<uint32_t>(resource, std::make_index_sequence<width>())),
+		  m_kept(resource)
+	{
+		std::bitset<width> kept;
+		schema::enumerate([&projection, &kept](const auto & field, std::size_t i)
+		{
+			kept[index(field.member)] = projection[i];
+		});
+		// ascending order, so rows are read and written front to back
+		m_kept.reserve(kept.count());
+		for (std::size_t i {}; i < width; ++i)
+		{
+			if (kept[i]) { m_kept.push_back(i); }
+		}
+	}
+
+	void columns::reserve(std::size_t size)
+	{
+		for (std::size_t i : m_kept)
+		{
+			switch (types[i])
+			{
+				case type::FLOAT: m_floats[i].reserve(size); break;
+				case type::SIGNED: m_signed[i].reserve(size); break;
+				case type::UNSIGNED: m_unsigned[i].reserve(size); break;
+			}
+		}
+	}
+
+	void columns::push_back(const row & row)
+	{
+		// every field is 4 bytes wide and lies at 'index * 4' bytes from the beginning of the row
+		const auto * bytes {reinterpret_cast<const std::byte *>(&row)};
+		for (std::size_t i : m_kept)
+		{
+			switch (types[i])
+			{
+				case type::FLOAT:
+				{
+					float value {};
+					std::memcpy(&value, bytes + i * sizeof(uint32_t), sizeof(value));
+					m_floats[i].push_back(value);
+					break;
+				}
+				case type::SIGNED:
+				{
+					int value {};
+					std::memcpy(&value, bytes + i * sizeof(uint32_t), sizeof(value));
+					m_signed[i].push_back(value);
+					break;
+				}
+				case type::UNSIGNED:
+				{
+					uint32_t value {};
+					std::memcpy(&value, bytes + i * sizeof(uint32_t), sizeof(value));
+					m_unsigned[i].push_back(value);
+					break;
+				}
+			}
+		}
+		++m_size;
+	}
+
+	row columns::at(std::size_t index) const
+	{
+		ws::data::row row {};
+		auto * bytes {reinterpret_cast<std::byte *>(&row)};
+		for (std::size_t i : m_kept)
+		{
+			switch (types[i])
+			{
+				case type::FLOAT: std::memcpy(bytes + i * sizeof(uint32_t), &m_floats[i][index], sizeof(uint32_t)); break;
+				case type::SIGNED: std::memcpy(bytes + i * sizeof(uint32_t), &m_signed[i][index], sizeof(uint32_t)); break;
+				case type::UNSIGNED: std::memcpy(bytes + i * sizeof(uint32_t), &m_unsigned[i][index], sizeof(uint32_t)); break;
+			}
+		}
+		return row;
+	}
+
+	std::size_t columns::size() const
+	{
+		return m_size;
+	}
+
+	void columns::clear()
+	{
+		for (auto & column : m_floats) { column.clear(); }
+		for (auto & column : m_signed) { column.clear(); }
+		for (auto & column : m_unsigned) { column.clear(); }
+		m_size = 0;
+	}
+
+	void columns::dump(std::string & out) const
+	{
+		for (std::size_t i : m_kept)
+		{
+			const void * data {};
+			switch (types[i])
+			{
+				case type::FLOAT: data = m_floats[i].data(); break;
+				case type::SIGNED: data = m_signed[i].data(); break;
+				case type::UNSIGNED: data = m_unsigned[i].data(); break;
+			}
+			out.append(static_cast<const char *>(data), m_size * sizeof(uint32_t));
+		}
+	}
+
+	bool columns::restore(std::span<const std::byte> bytes, std::size_t size)
+	{
+		if (bytes.size() != m_kept.size() * size * sizeof(uint32_t)) { return false; }
+		this->clear();
+		for (std::size_t i : m_kept)
+		{
+			void * data {};
+			switch (types[i])
+			{
+				case type::FLOAT: m_floats[i].resize(size); data = m_floats[i].data(); break;
+				case type::SIGNED: m_signed[i].resize(size); data = m_signed[i].data(); break;
+				case type::UNSIGNED: m_unsigned[i].resize(size); data = m_unsigned[i].data(); break;
+			}
+			// an empty span may have no data at all
+			if (size) { std::memcpy(data, bytes.data(), size * sizeof(uint32_t)); }
+			bytes = bytes.subspan(size * sizeof(uint32_t));
+		}
+		m_size = size;
+		return true;
+	}
+}
@@ -0,0 +1,121 @@
+//
+//  columns.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <array>
+#include <string>
+#include <span>
+#include <vector>
+#include <utility>
+#include <memory_resource>
+#include <cstdint>
+#include "row.h"
+#include "schema.h"
+
+// Columns class is a columnar (struct of arrays) storage for rows (see 'row.h'). Every field of the row
+// is kept in its own contiguous array, so a pass over a single field touches only its own bytes.
+// All fields of the row are 4 bytes wide, hence a field is identified by its index 'offset / 4'.
+// Columns are accessed with the same pointers to members of 'row' that analysis code uses for rows,
+// e.g. column(&row::gyro_X) returns std::span<const float> over all gyro_X values. Only fields of the
+// projection given to the constructor (see 'schema.h') are kept, columns of other fields stay empty and
+// take no memory, at() leaves them zero. Memory of all columns is taken from the resource given to the constructor,
+// e.g. an arena (see 'arena.h') shared by files loaded one after another.
+//
+// Class properties:
+// - m_floats  : columns of float fields, entries of other fields stay empty;
+// - m_signed  : columns of int fields;
+// - m_unsigned: columns of uint32_t fields;
+// - m_kept    : indices of fields that are kept;
+// - m_size    : number of stored rows.
+//
+// Class behaviors:
+// - index()    : return the index of the field pointed to by given member pointer;
+// - reserve()  : reserve memory for given number of rows in every column;
+// - push_back(): scatter a single row into the columns;
+// - at()       : gather a single row back from the columns (row view adapter);
+// - column()   : return all values of a single field;
+// - size()     : return number of stored rows;
+// - clear()    : remove all rows;
+// - dump()     : append raw bytes of every kept column to given buffer, columns go in ascending index order;
+// - restore()  : replace all rows with columns dumped earlier with the same projection, returns false
+//                if size of the bytes does not match given number of rows.
+
+namespace ws::data
+{
+	class columns
+	{
+	public:
+		// number of fields in a single row
+		static constexpr std::size_t width {sizeof(row) / sizeof(uint32_t)};
+	public:
+		explicit columns(const projection & = schema::all(), std::pmr::memory_resource * = std::pmr::get_default_resource());
+	public:
+		template <typename T>
+		static std::size_t index(const T row:: *);
+		void reserve(std::size_t);
+		void push_back(const row &);
+		row at(std::size_t) const;
+		template <typename T>
+		std::span<const T> column(const T row:: *) const;
+		std::size_t size() const;
+		void clear();
+		void dump(std::string &) const;
+		bool restore(std::span<const std::byte>, std::size_t);
+	private:
+		template <typename T>
+		const std::array<std::pmr::vector<T>, width> & storage() const;
+		template <typename T, std::size_t... I>
+		static std::array<std::pmr::vector<T>, width> make(std::pmr::memory_resource *, std::index_sequence<I...>);
+	private:
+		std::array<std::pmr::vector<float>, width> m_floats;
+		std::array<std::pmr::vector<int>, width> m_signed;
+		std::array<std::pmr::vector<uint32_t>, width> m_unsigned;
+		std::pmr::vector<std::size_t> m_kept;
+		std::size_t m_size {};
+	};
+
+	template <typename T>
+	std::size_t columns::index(const T row:: * member)
+	{
+		static_assert(sizeof(T) == sizeof(uint32_t), "every field of the row is 4 bytes wide");
+		// the offset of a member is taken from a real object, so no offsetof tricks are needed
+		static constexpr row sample {};
+		return static_cast<std::size_t>(reinterpret_cast<const std::byte *>(&(sample.*member)) -
+										reinterpret_cast<const std::byte *>(&sample)) / sizeof(uint32_t);
+	}
+
+	template <>
+	inline const std::array<std::pmr::vector<float>, columns::width> & columns::storage<float>() const
+	{
+		return m_floats;
+	}
+
+	template <>
+	inline const std::array<std::pmr::vector<int>, columns::width> & columns::storage<int>() const
+	{
+		return m_signed;
+	}
+
+	template <>
+	inline const std::array<std::pmr::vector<uint32_t>, columns::width> & columns::storage<uint32_t>() const
+	{
+		return m_unsigned;
+	}
+
+	// every column gets the same resource, std::array of them could not be built otherwise
+	template <typename T, std::size_t... I>
+	std::array<std::pmr::vector<T>, columns::width> columns::make(std::pmr::memory_resource * resource, std::index_sequence<I...>)
+	{
+		return {((void)I, std::pmr::vector<T>(resource))...};
+	}
+
+	template <typename T>
+	std::span<const T> columns::column(const T row:: * member) const
+	{
+		return std::span<const T>(this->storage<T>()[index(member)]);
+	}
+}
@@ -6,11 +6,91 @@
 //
 
 #include <format>
+#include <limits>
+#include <algorithm>
 #include <fstream>
+#include <charconv>
+#include <cmath>
+#include <array>
+#include <filesystem>
+#include <type_traits>
 #include "file.h"
+#include "archive.h"
+#include "record.h"
+#include "schema.h"
+#include "writer.h"
 
 namespace ws::data
 {
+	namespace
+	{
+		// reads values of a single .txt line one by one, values are separated by tabs, floats could have
+		// a leading space instead of the '+' sign (see save<extension::TXT>)
+		class cursor
+		{
+		public:
+			cursor(std::string_view line, std::size_t number) : m_line(line), m_position(), m_number(number), m_column() {}
+		public:
+			template <typename T>
+			bool next(T & value)
+			{
+				while (m_position < m_line.size() && m_line[m_position] == ' ') { ++m_position; }
+				m_column = m_position + 1;
+				const char * first {m_line.data() + m_position};
+				const char * last {m_line.data() + m_line.size()};
+				auto [end, error] {std::from_chars(first, last, value)};
+				if (error != std::errc() || (end != last && *end != '\t')) { return false; }
+				m_position = static_cast<std::size_t>(end - m_line.data()) + (end != last ? 1 : 0);
+				return true;
+			}
+			// pass over a single value without converting it
+			bool skip()
+			{
+				m_column = m_position + 1;
+				if (m_position >= m_line.size()) { return false; }
+				const std::size_t end {m_line.find('\t', m_position)};
+				m_position = end == std::string_view::npos ? m_line.size() : end + 1;
+				return true;
+			}
+			// the whole line was read, nothing but spaces left
+			bool end()
+			{
+				while (m_position < m_line.size() && m_line[m_position] == ' ') { ++m_position; }
+				m_column = m_position + 1;
+				return m_position == m_line.size();
+			}
+			parse_error error() const { return parse_error {m_number, m_column}; }
+		private:
+			std::string_view m_line;
+			std::size_t m_position;
+			std::size_t m_number;
+			std::size_t m_column;
+		};
+
+		// fields of a .txt line, same order as in .dat file, fields out of projection are skipped
+		bool parse(cursor & cursor, row & row, const projection & projection)
+		{
+			return schema::all_of_enumerated([&cursor, &row, &projection](const auto & field, std::size_t i)
+			{
+				return projection[i] ? cursor.next(row.*field.member) : cursor.skip();
+			}) && cursor.end();
+		}
+
+		// number of rows of given length from given position to the end of the file, zero if it is unknown
+		std::size_t rows_left(const std::string_view filename, std::uintmax_t position, std::size_t length)
+		{
+			std::error_code error;
+			const std::uintmax_t size {std::filesystem::file_size(filename, error)};
+			if (error || !length || size <= position) { return 0; }
+			return static_cast<std::size_t>((size - position + length - 1) / length);
+		}
+	}
+	file::file(storage storage, const projection & projection, std::pmr::memory_resource * resource)
+		: m_storage(storage), m_projection(projection | schema::select(&row::count)), m_data(resource), m_columns(m_projection, resource)
+	{
+
+	}
+
 	bool operator == (extension lhs, extension rhs)
 	{
 		return static_cast<int>(lhs) == static_cast<int>(rhs);
@@ -18,7 +98,17 @@ namespace ws::data
 
 	bool operator == (const std::string_view string, extension extension)
 	{
-		return (extension == extension::DAT ? string == ".dat" : string == ".txt");
+		return string == suffix(extension);
+	}
+
+	std::string_view suffix(extension extension)
+	{
+		switch (extension)
+		{
+		case extension::DAT: return ".dat";
+		case extension::TXT: return ".txt";
+		default: return ".arc";
+		}
 	}
 
 	// read .dat file
@@ -29,117 +119,114 @@ namespace ws::data
 		if (!fin.is_open()) { return false; }
 		// find starting line to begin reading
 		// raw input data before line 60 very unstable and not required for later analysis
-		// 301 is lenght of single line in bytes
-		uint32_t row_count {};
+		// 301 is lenght of single line in bytes, so the line is found by binary search over offsets (see 'record.h')
 		constexpr uint32_t starting_row {60};
-		while (!fin.eof())
+		std::error_code error;
+		const std::size_t records {static_cast<std::size_t>(std::filesystem::file_size(filename, error) / schema::size)};
+		if (error) { return false; }
+		auto count_at {[&fin](std::size_t index)
 		{
+			uint32_t row_count {};
+			fin.seekg(static_cast<std::streamoff>(index * schema::size));
 			fin.read(reinterpret_cast<char *>(&row_count), 2);
-			if (row_count < starting_row)
-			{
-				fin.seekg(fin.tellg() += 299);
-			}
-			else
-			{
-				// the file pointer is now set at line 60 and so we can read proper data
-				fin.seekg(fin.tellg() -= 2);
-				break;
-			}
-		}
+			return row_count;
+		}};
+		const std::size_t first {seek(records, starting_row, count_at)};
 		// the file has no proper content or too short -- could not be used
-		if (fin.bad() || row_count < starting_row) { return false; }
-		// continue reading input data line by line
+		if (fin.bad() || first == records) { return false; }
+		// the file pointer is now set at line 60 and so we can read proper data
+		fin.clear();
+		fin.seekg(static_cast<std::streamoff>(first * schema::size));
+		// continue reading input data line by line, every line left is 301 bytes long
+		std::array<std::byte, schema::size> bytes {};
 		ws::data::row row {};
-		m_data.reserve(1200);
+		this->reserve(rows_left(filename, static_cast<std::uintmax_t>(fin.tellg()), schema::size));
 		while (fin.good())
 		{
-			fin.read(reinterpret_cast<char *>(&row.count), 2);
-			fin.read(reinterpret_cast<char *>(&row.mode), 2);
-			fin.read(reinterpret_cast<char *>(&row.system_time), 4);
-			fin.read(reinterpret_cast<char *>(&row.mode_time), 4);
-			fin.read(reinterpret_cast<char *>(&row.pitch), 4);
-			fin.read(reinterpret_cast<char *>(&row.roll), 4);
-			fin.read(reinterpret_cast<char *>(&row.heading), 4);
-			fin.read(reinterpret_cast<char *>(&row.azimuth), 4);
-			fin.read(reinterpret_cast<char *>(&row.thdg), 4);
-			fin.read(reinterpret_cast<char *>(&row.latitude), 4);
-			fin.read(reinterpret_cast<char *>(&row.longtitude), 4);
-			fin.read(reinterpret_cast<char *>(&row.H), 4);
-			fin.read(reinterpret_cast<char *>(&row.Ve), 4);
-			fin.read(reinterpret_cast<char *>(&row.Vn), 4);
-			fin.read(reinterpret_cast<char *>(&row.Vu), 4);
-			fin.read(reinterpret_cast<char *>(&row.dAt_X), 4);
-			fin.read(reinterpret_cast<char *>(&row.dAt_Y), 4);
-			fin.read(reinterpret_cast<char *>(&row.dAt_Z), 4);
-			fin.read(reinterpret_cast<char *>(&row.dVt_X), 4);
-			fin.read(reinterpret_cast<char *>(&row.dVt_Y), 4);
-			fin.read(reinterpret_cast<char *>(&row.dVt_Z), 4);
-			fin.read(reinterpret_cast<char *>(&row.gyro_X), 4);
-			fin.read(reinterpret_cast<char *>(&row.gyro_Y), 4);
-			fin.read(reinterpret_cast<char *>(&row.gyro_Z), 4);
-			fin.read(reinterpret_cast<char *>(&row.acc_X), 4);
-			fin.read(reinterpret_cast<char *>(&row.acc_Y), 4);
-			fin.read(reinterpret_cast<char *>(&row.acc_Z), 4);
-			fin.read(reinterpret_cast<char *>(&row.U_cplc_X), 4);
-			fin.read(reinterpret_cast<char *>(&row.U_cplc_Y), 4);
-			fin.read(reinterpret_cast<char *>(&row.U_cplc_Z), 4);
-			fin.read(reinterpret_cast<char *>(&row.U_hfo_X), 4);
-			fin.read(reinterpret_cast<char *>(&row.U_hfo_Y), 4);
-			fin.read(reinterpret_cast<char *>(&row.U_hfo_Z), 4);
-			fin.read(reinterpret_cast<char *>(&row.F_out_X), 4);
-			fin.read(reinterpret_cast<char *>(&row.F_out_Y), 4);
-			fin.read(reinterpret_cast<char *>(&row.F_out_Z), 4);
-			fin.read(reinterpret_cast<char *>(&row.F_dith_X), 4);
-			fin.read(reinterpret_cast<char *>(&row.F_dith_Y), 4);
-			fin.read(reinterpret_cast<char *>(&row.F_dith_Z), 4);
-			fin.read(reinterpret_cast<char *>(&row.gyro_X_temperature), 4);
-			fin.read(reinterpret_cast<char *>(&row.gyro_Y_temperature), 4);
-			fin.read(reinterpret_cast<char *>(&row.gyro_Z_temperature), 4);
-			fin.read(reinterpret_cast<char *>(&row.acc_X_temperature), 4);
-			fin.read(reinterpret_cast<char *>(&row.acc_Y_temperature), 4);
-			fin.read(reinterpret_cast<char *>(&row.acc_Z_temperature), 4);
-			fin.read(reinterpret_cast<char *>(&row.dpb_X_temperature), 4);
-			fin.read(reinterpret_cast<char *>(&row.dpb_Y_temperature), 4);
-			fin.read(reinterpret_cast<char *>(&row.dpb_Z_temperature), 4);
-			fin.read(reinterpret_cast<char *>(&row.drift_X), 4);
-			fin.read(reinterpret_cast<char *>(&row.drift_Y), 4);
-			fin.read(reinterpret_cast<char *>(&row.drift_Z), 4);
-			fin.read(reinterpret_cast<char *>(&row.faults), 2);
-			fin.read(reinterpret_cast<char *>(&row.D12), 4);
-			fin.read(reinterpret_cast<char *>(&row.D13), 4);
-			fin.read(reinterpret_cast<char *>(&row.D21), 4);
-			fin.read(reinterpret_cast<char *>(&row.D23), 4);
-			fin.read(reinterpret_cast<char *>(&row.D31), 4);
-			fin.read(reinterpret_cast<char *>(&row.D32), 4);
-			fin.read(reinterpret_cast<char *>(&row.Mg1), 4);
-			fin.read(reinterpret_cast<char *>(&row.Mg2), 4);
-			fin.read(reinterpret_cast<char *>(&row.Mg3), 4);
-			fin.read(reinterpret_cast<char *>(&row.Wo1), 4);
-			fin.read(reinterpret_cast<char *>(&row.Wo2), 4);
-			fin.read(reinterpret_cast<char *>(&row.Wo3), 4);
-			fin.read(reinterpret_cast<char *>(&row.E12), 4);
-			fin.read(reinterpret_cast<char *>(&row.E13), 4);
-			fin.read(reinterpret_cast<char *>(&row.E21), 4);
-			fin.read(reinterpret_cast<char *>(&row.E23), 4);
-			fin.read(reinterpret_cast<char *>(&row.E31), 4);
-			fin.read(reinterpret_cast<char *>(&row.E32), 4);
-			fin.read(reinterpret_cast<char *>(&row.Ma1), 4);
-			fin.read(reinterpret_cast<char *>(&row.Ma2), 4);
-			fin.read(reinterpret_cast<char *>(&row.Ma2), 4);
-			fin.read(reinterpret_cast<char *>(&row.Ao1), 4);
-			fin.read(reinterpret_cast<char *>(&row.Ao2), 4);
-			fin.read(reinterpret_cast<char *>(&row.Ao3), 4);
-			fin.read(reinterpret_cast<char *>(&row.reserve), 1);
-			fin.read(reinterpret_cast<char *>(&row.crc8), 1);
-			fin.read(reinterpret_cast<char *>(&row.error), 1);
-			m_data.push_back(row);
+			fin.read(reinterpret_cast<char *>(bytes.data()), schema::size);
+			// the last read hits the end of file, do not push previous row once again
+			if (!fin) { break; }
+			ws::data::record(bytes.data()).decode(row, m_projection);
+			this->push(row);
 		}
 		if (!fin.eof()) { return false; }
 		fin.close();
-		m_data.shrink_to_fit();
 		return true;
 	}
 
+	// read .dat file mapped into memory
+	template<>
+	bool file::load<extension::DAT, loader::MAPPED>(const std::string_view filename)
+	{
+		m_integrity = {};
+		record_view view;
+		if (!view.open(filename)) { return false; }
+		// only records with valid checksums are read, from wherever they are (see 'integrity.h')
+		integrity frames {m_data.get_allocator().resource()};
+		frames.check(view.bytes());
+		m_integrity = frames.get_report();
+		const auto & runs {frames.get_runs()};
+		// same as stream loader: skip unstable lines before line 60
+		constexpr uint32_t starting_row {60};
+		std::size_t run {};
+		std::size_t first {};
+		std::size_t skipped {};
+		for (; run < runs.size(); ++run)
+		{
+			const std::byte * data {view.bytes().data() + runs[run].offset};
+			first = seek(runs[run].records, starting_row, [data](std::size_t i) { return record(data + i * schema::size).get<&row::count>(); });
+			if (first < runs[run].records) { break; }
+			skipped += runs[run].records;
+		}
+		if (run == runs.size()) { return false; }
+		// the whole file is already in memory, so the exact amount of rows is known
+		this->reserve(m_integrity.records - skipped - first);
+		ws::data::row row {};
+		for (; run < runs.size(); ++run, first = 0)
+		{
+			const std::byte * data {view.bytes().data() + runs[run].offset};
+			for (std::size_t i {first}; i < runs[run].records; ++i)
+			{
+				record(data + i * schema::size).decode(row, m_projection);
+				this->push(row);
+			}
+		}
+		return true;
+	}
+
+	// read .arc file mapped into memory, block by block (see 'archive.h')
+	template<>
+	bool file::load<extension::ARC, loader::MAPPED>(const std::string_view filename)
+	{
+		m_integrity = {};
+		mapping bytes;
+		if (!bytes.open(filename)) { return false; }
+		archive archive {m_data.get_allocator().resource()};
+		if (!archive.open(std::span<const std::byte>(bytes.data(), bytes.size()))) { return false; }
+		// same as .dat loaders: skip unstable lines before line 60, whole blocks are passed over by the index
+		constexpr uint32_t starting_row {60};
+		const std::size_t first {archive.seek(starting_row)};
+		if (first == archive.size()) { return false; }
+		this->reserve(archive.size() - first);
+		std::pmr::vector<ws::data::row> rows(archive::block_rows, m_data.get_allocator().resource());
+		for (std::size_t block {first / archive::block_rows}; block < archive.blocks(); ++block)
+		{
+			const std::size_t begin {block * archive::block_rows};
+			const std::size_t end {std::min(begin + archive::block_rows, archive.size())};
+			if (!archive.decode(block, m_projection, rows))
+			{
+				m_integrity.skipped += end - std::max(begin, first);
+				continue;
+			}
+			for (std::size_t i {std::max(begin, first)}; i < end; ++i)
+			{
+				this->push(rows[i - begin]);
+			}
+			m_integrity.records += end - std::max(begin, first);
+		}
+		return m_integrity.records != 0;
+	}
+
 	// read .txt file
 	template<>
 	bool file::load<extension::TXT>(const std::string_view filename)
@@ -148,210 +235,289 @@ namespace ws::data
 		if (!fin.is_open()) { return false; }
 		uint32_t row_count {};
 		constexpr uint32_t starting_row {60};
+		auto position {fin.tellg()};
 		while (fin >> row_count)
 		{
 			if (row_count < starting_row)
 			{
 				fin.ignore(std::numeric_limits <std::streamsize>::max(), '\n');
+				position = fin.tellg();
 			}
 			else
 			{
-				fin.seekg(fin.tellg() -= 2);
+				// return to the beginning of the line, count could have any number of digits
+				fin.seekg(position);
 				break;
 			}
 		}
 		if (fin.bad() || row_count < starting_row) { return false; }
+		// lines are about as long as the first one, values are written with fixed width
+		{
+			std::string line;
+			std::getline(fin, line);
+			this->reserve(rows_left(filename, static_cast<std::uintmax_t>(position), line.size()));
+			fin.clear();
+			fin.seekg(position);
+		}
 		ws::data::row row {};
-		m_data.reserve(1200);
 		while (fin.good())
 		{
-			fin >> row.count;
-			fin >> row.mode;
-			fin >> row.system_time;
-			fin >> row.mode_time;
-			fin >> row.pitch;
-			fin >> row.roll;
-			fin >> row.heading;
-			fin >> row.azimuth;
-			fin >> row.thdg;
-			fin >> row.latitude;
-			fin >> row.longtitude;
-			fin >> row.H;
-			fin >> row.Ve >> row.Vn >> row.Vu;
-			fin >> row.dAt_X >> row.dAt_Y >> row.dAt_Z;
-			fin >> row.dVt_X >> row.dVt_Y >> row.dVt_Z;
-			fin >> row.gyro_X >> row.gyro_Y >> row.gyro_Z;
-			fin >> row.acc_X >> row.acc_Y >> row.acc_Z;
-			fin >> row.U_cplc_X >> row.U_cplc_Y >> row.U_cplc_Z;
-			fin >> row.U_hfo_X >> row.U_hfo_Y >> row.U_hfo_Z;
-			fin >> row.F_out_X >> row.F_out_Y >> row.F_out_Z;
-			fin >> row.F_dith_X >> row.F_dith_Y >> row.F_dith_Z;
-			fin >> row.gyro_X_temperature >> row.gyro_Y_temperature >> row.gyro_Z_temperature;
-			fin >> row.acc_X_temperature >> row.acc_Y_temperature >> row.acc_Z_temperature;
-			fin >> row.dpb_X_temperature >> row.dpb_Y_temperature >> row.dpb_Z_temperature;
-			fin >> row.drift_X >> row.drift_Y >> row.drift_Z;
-			fin >> row.faults;
-			fin >> row.D12 >> row.D13 >> row.D21 >> row.D23 >> row.D31 >> row.D32;
-			fin >> row.Mg1 >> row.Mg2 >> row.Mg3;
-			fin >> row.Wo1 >> row.Wo2 >> row.Wo3;
-			fin >> row.E12 >> row.E13 >> row.E21 >> row.E23 >> row.E31 >> row.E32;
-			fin >> row.Ma1 >> row.Ma2 >> row.Ma3;
-			fin >> row.Ao1 >> row.Ao2 >> row.Ao3;
-			fin >> row.reserve;
-			fin >> row.crc8;
-			fin >> row.error;
-			m_data.push_back(row);
+			schema::enumerate([this, &fin, &row](const auto & field, std::size_t i)
+			{
+				typename std::remove_cvref_t<decltype(field)>::type value {};
+				fin >> value;
+				if (m_projection[i]) { row.*field.member = value; }
+			});
+			// the last read hits the end of file, do not push previous row once again
+			if (!fin) { break; }
+			this->push(row);
 		}
 		if (!fin.eof()) { return false; }
 		fin.close();
-		m_data.shrink_to_fit();
 		return true;
 	}
 
+	// read .txt file in large blocks and convert values with std::from_chars, no stream state per value
+	template<>
+	bool file::load<extension::TXT, loader::BUFFERED>(const std::string_view filename)
+	{
+		m_error = {};
+		std::ifstream fin {std::string(filename), std::ios_base::in | std::ios_base::binary};
+		if (!fin.is_open()) { return false; }
+		constexpr std::size_t block_size {1 << 20};
+		constexpr uint32_t starting_row {60};
+		std::string buffer;
+		buffer.reserve(block_size * 2);
+		std::size_t line_number {};
+		// position of the buffer in the file
+		std::uintmax_t offset {};
+		bool started {};
+		ws::data::row row {};
+		// parses all complete lines of the buffer, returns number of parsed bytes
+		auto parse_lines {[&](bool last) -> std::size_t
+		{
+			std::size_t begin {};
+			while (begin < buffer.size())
+			{
+				std::size_t end {buffer.find('\n', begin)};
+				if (end == std::string::npos)
+				{
+					// incomplete line waits for the next block, unless the file is over
+					if (!last) { break; }
+					end = buffer.size();
+				}
+				std::string_view line {buffer.data() + begin, end - begin};
+				if (!line.empty() && line.back() == '\r') { line.remove_suffix(1); }
+				++line_number;
+				begin = end + 1;
+				if (line.find_first_not_of(" \t") == std::string_view::npos) { continue; }
+				ws::data::cursor cursor {line, line_number};
+				if (!ws::data::parse(cursor, row, m_projection))
+				{
+					m_error = cursor.error();
+					return std::string::npos;
+				}
+				// raw input data before line 60 very unstable and not required for later analysis
+				if (!started && row.count < starting_row) { continue; }
+				if (!started)
+				{
+					// lines are about as long as the first one, values are written with fixed width
+					this->reserve(rows_left(filename, offset + static_cast<std::uintmax_t>(line.data() - buffer.data()), line.size()));
+					started = true;
+				}
+				this->push(row);
+			}
+			return std::min(begin, buffer.size());
+		}};
+		while (fin)
+		{
+			std::size_t size {buffer.size()};
+			buffer.resize(size + block_size);
+			fin.read(buffer.data() + size, block_size);
+			buffer.resize(size + static_cast<std::size_t>(fin.gcount()));
+			std::size_t parsed {parse_lines(!fin)};
+			if (parsed == std::string::npos) { return false; }
+			buffer.erase(0, parsed);
+			offset += parsed;
+		}
+		if (fin.bad() || !started) { return false; }
+		return true;
+	}
+
+	namespace
+	{
+		// append a single row in .dat format
+		void append_dat(std::string & out, const row & row)
+		{
+			schema::for_each([&out, &row](const auto & field)
+			{
+				const auto value {row.*field.member};
+				out.append(reinterpret_cast<const char *>(&value), field.width);
+			});
+		}
+
+		// append a value as std::format() does with "{: .Nf}\t" for given precision N or with "{}\t" if
+		// precision is negative; std::to_chars() gives the same digits without parsing a format string
+		template <typename T>
+		void put(std::string & out, T value, int precision)
+		{
+			char digits[64];
+			char * end {};
+			if constexpr (std::is_floating_point_v<T>)
+			{
+				if (precision >= 0)
+				{
+					// a space instead of the '+' sign
+					if (!std::signbit(value)) { out.push_back(' '); }
+					end = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::fixed, precision).ptr;
+				}
+				else
+				{
+					end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+				}
+			}
+			else
+			{
+				end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+			}
+			out.append(digits, end);
+			out.push_back('\t');
+		}
+
+		// append a single row in .txt format, values are written straight into the buffer without
+		// temporary strings, so once the buffer has enough capacity no memory is allocated at all
+		void append_txt(std::string & out, const row & row)
+		{
+			schema::for_each([&out, &row](const auto & field) { put(out, row.*field.member, field.precision); });
+			// the last value ends the line
+			out.back() = '\n';
+		}
+	}
+
+	// append rows in .dat format to the given buffer
+	template<>
+	void file::encode<extension::DAT>(std::string & out) const
+	{
+		out.reserve(out.size() + this->size() * schema::size);
+		for (std::size_t i {}; i < this->size(); ++i)
+		{
+			append_dat(out, this->at(i));
+		}
+	}
+
+	// append rows in .txt format to the given buffer
+	template<>
+	void file::encode<extension::TXT>(std::string & out) const
+	{
+		for (std::size_t i {}; i < this->size(); ++i)
+		{
+			append_txt(out, this->at(i));
+		}
+	}
+
+	// append rows as .arc file to the given buffer, the archive is built in memory (see 'archive.h')
+	template<>
+	void file::encode<extension::ARC>(std::string & out) const
+	{
+		archive archive {m_data.get_allocator().resource()};
+		for (std::size_t i {}; i < this->size(); ++i)
+		{
+			archive.push(this->at(i));
+		}
+		archive.finish(out);
+	}
+
 	// save read data as .dat file -- will be used later in future
 	template<>
 	bool file::save<extension::DAT>(const std::string_view filename)
 	{
-		std::ofstream fout {filename.data(), std::ios_base::out | std::ios_base::binary};
-		if (!fout.is_open()) { return false; }
-		for (ws::data::row & row : m_data)
+		ws::data::writer fout;
+		if (!fout.open(filename, true)) { return false; }
+		for (std::size_t i {}; i < this->size(); ++i)
 		{
-			fout.write(reinterpret_cast<char *>(&row.count), 2);
-			fout.write(reinterpret_cast<char *>(&row.mode), 2);
-			fout.write(reinterpret_cast<char *>(&row.system_time), 4);
-			fout.write(reinterpret_cast<char *>(&row.mode_time), 4);
-			fout.write(reinterpret_cast<char *>(&row.pitch), 4);
-			fout.write(reinterpret_cast<char *>(&row.roll), 4);
-			fout.write(reinterpret_cast<char *>(&row.heading), 4);
-			fout.write(reinterpret_cast<char *>(&row.azimuth), 4);
-			fout.write(reinterpret_cast<char *>(&row.thdg), 4);
-			fout.write(reinterpret_cast<char *>(&row.latitude), 4);
-			fout.write(reinterpret_cast<char *>(&row.longtitude), 4);
-			fout.write(reinterpret_cast<char *>(&row.H), 4);
-			fout.write(reinterpret_cast<char *>(&row.Ve), 4);
-			fout.write(reinterpret_cast<char *>(&row.Vn), 4);
-			fout.write(reinterpret_cast<char *>(&row.Vu), 4);
-			fout.write(reinterpret_cast<char *>(&row.dAt_X), 4);
-			fout.write(reinterpret_cast<char *>(&row.dAt_Y), 4);
-			fout.write(reinterpret_cast<char *>(&row.dAt_Z), 4);
-			fout.write(reinterpret_cast<char *>(&row.dVt_X), 4);
-			fout.write(reinterpret_cast<char *>(&row.dVt_Y), 4);
-			fout.write(reinterpret_cast<char *>(&row.dVt_Z), 4);
-			fout.write(reinterpret_cast<char *>(&row.gyro_X), 4);
-			fout.write(reinterpret_cast<char *>(&row.gyro_Y), 4);
-			fout.write(reinterpret_cast<char *>(&row.gyro_Z), 4);
-			fout.write(reinterpret_cast<char *>(&row.acc_X), 4);
-			fout.write(reinterpret_cast<char *>(&row.acc_Y), 4);
-			fout.write(reinterpret_cast<char *>(&row.acc_Z), 4);
-			fout.write(reinterpret_cast<char *>(&row.U_cplc_X), 4);
-			fout.write(reinterpret_cast<char *>(&row.U_cplc_Y), 4);
-			fout.write(reinterpret_cast<char *>(&row.U_cplc_Z), 4);
-			fout.write(reinterpret_cast<char *>(&row.U_hfo_X), 4);
-			fout.write(reinterpret_cast<char *>(&row.U_hfo_Y), 4);
-			fout.write(reinterpret_cast<char *>(&row.U_hfo_Z), 4);
-			fout.write(reinterpret_cast<char *>(&row.F_out_X), 4);
-			fout.write(reinterpret_cast<char *>(&row.F_out_Y), 4);
-			fout.write(reinterpret_cast<char *>(&row.F_out_Z), 4);
-			fout.write(reinterpret_cast<char *>(&row.F_dith_X), 4);
-			fout.write(reinterpret_cast<char *>(&row.F_dith_Y), 4);
-			fout.write(reinterpret_cast<char *>(&row.F_dith_Z), 4);
-			fout.write(reinterpret_cast<char *>(&row.gyro_X_temperature), 4);
-			fout.write(reinterpret_cast<char *>(&row.gyro_Y_temperature), 4);
-			fout.write(reinterpret_cast<char *>(&row.gyro_Z_temperature), 4);
-			fout.write(reinterpret_cast<char *>(&row.acc_X_temperature), 4);
-			fout.write(reinterpret_cast<char *>(&row.acc_Y_temperature), 4);
-			fout.write(reinterpret_cast<char *>(&row.acc_Z_temperature), 4);
-			fout.write(reinterpret_cast<char *>(&row.dpb_X_temperature), 4);
-			fout.write(reinterpret_cast<char *>(&row.dpb_Y_temperature), 4);
-			fout.write(reinterpret_cast<char *>(&row.dpb_Z_temperature), 4);
-			fout.write(reinterpret_cast<char *>(&row.drift_X), 4);
-			fout.write(reinterpret_cast<char *>(&row.drift_Y), 4);
-			fout.write(reinterpret_cast<char *>(&row.drift_Z), 4);
-			fout.write(reinterpret_cast<char *>(&row.faults), 2);
-			fout.write(reinterpret_cast<char *>(&row.D12), 4);
-			fout.write(reinterpret_cast<char *>(&row.D13), 4);
-			fout.write(reinterpret_cast<char *>(&row.D21), 4);
-			fout.write(reinterpret_cast<char *>(&row.D23), 4);
-			fout.write(reinterpret_cast<char *>(&row.D31), 4);
-			fout.write(reinterpret_cast<char *>(&row.D32), 4);
-			fout.write(reinterpret_cast<char *>(&row.Mg1), 4);
-			fout.write(reinterpret_cast<char *>(&row.Mg2), 4);
-			fout.write(reinterpret_cast<char *>(&row.Mg3), 4);
-			fout.write(reinterpret_cast<char *>(&row.Wo1), 4);
-			fout.write(reinterpret_cast<char *>(&row.Wo2), 4);
-			fout.write(reinterpret_cast<char *>(&row.Wo3), 4);
-			fout.write(reinterpret_cast<char *>(&row.E12), 4);
-			fout.write(reinterpret_cast<char *>(&row.E13), 4);
-			fout.write(reinterpret_cast<char *>(&row.E21), 4);
-			fout.write(reinterpret_cast<char *>(&row.E23), 4);
-			fout.write(reinterpret_cast<char *>(&row.E31), 4);
-			fout.write(reinterpret_cast<char *>(&row.E32), 4);
-			fout.write(reinterpret_cast<char *>(&row.Ma1), 4);
-			fout.write(reinterpret_cast<char *>(&row.Ma2), 4);
-			fout.write(reinterpret_cast<char *>(&row.Ma2), 4);
-			fout.write(reinterpret_cast<char *>(&row.Ao1), 4);
-			fout.write(reinterpret_cast<char *>(&row.Ao2), 4);
-			fout.write(reinterpret_cast<char *>(&row.Ao3), 4);
-			fout.write(reinterpret_cast<char *>(&row.reserve), 1);
-			fout.write(reinterpret_cast<char *>(&row.crc8), 1);
-			fout.write(reinterpret_cast<char *>(&row.error), 1);
+			append_dat(fout.buffer(), this->at(i));
+			fout.commit();
 		}
-		if (fout.bad()) { return false; }
-		fout.close();
-		return true;
+		return fout.close();
 	}
 
-	// save data as .txt file -- used when converting files from .dat to .txt format
+	// save data as .txt file -- used when converting files from .dat to .txt format, rows are formatted
+	// into the buffer of the writer, which goes to the file in large blocks
 	template<>
 	bool file::save<extension::TXT>(const std::string_view filename)
 	{
-		std::ofstream fout {filename.data(), std::ios_base::out};
-		if (!fout.is_open()) { return false; }
-		for (const ws::data::row & row : m_data)
+		ws::data::writer fout;
+		if (!fout.open(filename)) { return false; }
+		for (std::size_t i {}; i < this->size(); ++i)
 		{
-			fout << std::format("{}\t", row.count);
-			fout << std::format("{}\t", row.mode);
-			fout << std::format("{}\t", row.system_time);
-			fout << std::format("{}\t", row.mode_time);
-			fout << std::format("{: .5f}\t", row.pitch);
-			fout << std::format("{: .5f}\t", row.roll);
-			fout << std::format("{: .2f}\t", row.heading);
-			fout << std::format("{: .5f}\t", row.azimuth);
-			fout << std::format("{: .5f}\t", row.thdg);
-			fout << std::format("{: .5f}\t", row.latitude);
-			fout << std::format("{: .5f}\t", row.longtitude);
-			fout << std::format("{: .2f}\t", row.H);
-			fout << std::format("{: .5f}\t{: .5f}\t{: .5f}\t", row.Ve, row.Vn, row.Vu);
-			fout << std::format("{: .5f}\t{: .5f}\t{: .5f}\t", row.dAt_X, row.dAt_Y, row.dAt_Z);
-			fout << std::format("{: .5f}\t{: .5f}\t{: .5f}\t", row.dVt_X, row.dVt_Y, row.dVt_Z);
-			fout << std::format("{: .2f}\t{: .2f}\t{: .2f}\t", row.gyro_X, row.gyro_Y, row.gyro_Z);
-			fout << std::format("{: .5f}\t{: .5f}\t{: .5f}\t", row.acc_X, row.acc_Y, row.acc_Z);
-			fout << std::format("{: .2f}\t{: .2f}\t{: .2f}\t", row.U_cplc_X, row.U_cplc_Y, row.U_cplc_Z);
-			fout << std::format("{: .2f}\t{: .2f}\t{: .2f}\t", row.U_hfo_X, row.U_hfo_Y, row.U_hfo_Z);
-			fout << std::format("{: .1f}\t{: .1f}\t{: .1f}\t", row.F_out_X, row.F_out_Y, row.F_out_Z);
-			fout << std::format("{: .1f}\t{: .1f}\t{: .1f}\t", row.F_dith_X, row.F_dith_Y, row.F_dith_Z);
-			fout << std::format("{}\t{}\t{}\t", row.gyro_X_temperature, row.gyro_Y_temperature, row.gyro_Z_temperature);
-			fout << std::format("{}\t{}\t{}\t", row.acc_X_temperature, row.acc_Y_temperature, row.acc_Z_temperature);
-			fout << std::format("{}\t{}\t{}\t", row.dpb_X_temperature, row.dpb_Y_temperature, row.dpb_Z_temperature);
-			fout << std::format("{: .0f}\t{: .0f}\t{: .0f}\t", row.drift_X, row.drift_Y, row.drift_Z);
-			fout << std::format("{}\t", row.faults);
-			fout << std::format("{: .2f}\t{: .2f}\t{: .2f}\t{: .2f}\t{: .2f}\t{: .2f}\t", row.D12, row.D13, row.D21, row.D23, row.D31, row.D32);
-			fout << std::format("{: .5f}\t{: .5f}\t{: .5f}\t", row.Mg1, row.Mg2, row.Mg3);
-			fout << std::format("{: .5f}\t{: .5f}\t{: .5f}\t", row.Wo1, row.Wo2, row.Wo3);
-			fout << std::format("{: .5f}\t{: .5f}\t{: .5f}\t{: .5f}\t{: .5f}\t{: .5f}\t", row.E12, row.E13, row.E21, row.E23, row.E31, row.E32);
-			fout << std::format("{: .1f}\t{: .1f}\t{: .5f}\t", row.Ma1, row.Ma2, row.Ma3);
-			fout << std::format("{: .5f}\t{: .5f}\t{: .5f}\t", row.Ao1, row.Ao2, row.Ao3);
-			fout << std::format("{}\t", row.reserve);
-			fout << std::format("{}\t", row.crc8);
-			fout << std::format("{}\n", row.error);
+			append_txt(fout.buffer(), this->at(i));
+			fout.commit();
 		}
-		if (fout.bad()) { return false; }
-		fout.close();
-		return true;
+		return fout.close();
+	}
+
+	// save data as .arc file for long-term storage, saved back as .dat it gives the same file
+	template<>
+	bool file::save<extension::ARC>(const std::string_view filename)
+	{
+		ws::data::writer fout;
+		if (!fout.open(filename, true)) { return false; }
+		this->encode<extension::ARC>(fout.buffer());
+		fout.commit();
+		return fout.close();
+	}
+
+	const parse_error & file::get_error() const
+	{
+		return m_error;
 	}
 
-	const std::vector<row> & file::get_data() const
+	const integrity::report & file::get_integrity() const
+	{
+		return m_integrity;
+	}
+
+	const std::pmr::vector<row> & file::get_data() const
 	{
 		return m_data;
 	}
+
+	row file::at(std::size_t index) const
+	{
+		return m_storage == storage::COLUMNS ? m_columns.at(index) : m_data[index];
+	}
+
+	std::size_t file::size() const
+	{
+		return m_storage == storage::COLUMNS ? m_columns.size() : m_data.size();
+	}
+
+	const projection & file::get_projection() const
+	{
+		return m_projection;
+	}
+
+	bool file::dump(std::string & out) const
+	{
+		if (m_storage != storage::COLUMNS) { return false; }
+		m_columns.dump(out);
+		return true;
+	}
+
+	bool file::restore(std::span<const std::byte> bytes, std::size_t size, const integrity::report & report)
+	{
+		if (m_storage != storage::COLUMNS || !m_columns.restore(bytes, size)) { return false; }
+		m_integrity = report;
+		return true;
+	}
+
+	void file::reserve(std::size_t size)
+	{
+		m_storage == storage::COLUMNS ? m_columns.reserve(size) : m_data.reserve(size);
+	}
+
+	void file::push(const row & row)
+	{
+		m_storage == storage::COLUMNS ? m_columns.push_back(row) : m_data.push_back(row);
+	}
 }
@@ -6,77 +6,138 @@
 //
 
 #pragma once
+#include <span>
+#include <string>
 #include <vector>
+#include <memory_resource>
 #include <string_view>
+#include "row.h"
+#include "columns.h"
+#include "schema.h"
+#include "integrity.h"
 
-// File class is a basic building block for the program to start with. It uses 'row' struct which represents 
-// one single line of source data. Each row then put to the std::vector of rows. Size of the
-// m_data vector is the lenght of file. Enum class 'extension' represents format of files that
-// could be read or saved. It has two overloads of comparation operator and std::formatter specialization,
-// so it could be used as argument for std::format().
+// File class is a basic building block for the program to start with. It uses 'row' struct (see 'row.h') which
+// represents one single line of source data. Enum class 'storage' selects how rows are kept: ROWS puts each row
+// to the std::vector of rows, COLUMNS keeps one contiguous array per field (see 'columns.h'), so analysis
+// passes read only the fields they need. Size of the storage is the lenght of file. Enum class 'extension' represents format of files that
+// could be read or saved: raw .dat records, .txt tables or .arc archives, compressed column by column for long-term
+// storage (see 'archive.h'). It has two overloads of comparation operator, suffix() gives its file name suffix, and
+// std::formatter specialization, so it could be used as argument for std::format(). Enum class 'loader' selects how .dat file is read:
+// STREAM reads field by field with std::ifstream, MAPPED maps the whole file into memory (see 'mapping.h')
+// and decodes records straight from mapped bytes at fixed offsets (see 'record.h'). Both give the same rows
+// of a clean file; MAPPED also verifies the checksum of every record and reads only good records, found at
+// their real places if bytes were lost or inserted (see 'integrity.h'), what it found is kept in 'm_integrity'.
+// An .arc file is read only with MAPPED: blocks before the first stable row are passed over by the index of the archive,
+// a block with a broken checksum is skipped and its rows are counted in 'm_integrity'.
+// For .txt file STREAM reads values with operator >>, BUFFERED reads the file in large blocks and converts
+// values with std::from_chars; on malformed input it stores line and column of the value in 'parse_error'.
+// Projection (see 'schema.h') given to the constructor selects fields to load: other fields are skipped by
+// offset in .dat files and without conversion in .txt files, they stay zero and take no memory with
+// storage::COLUMNS. Field 'count' is always loaded, it is needed to find the first stable row. Files
+// loaded with a partial projection should not be saved. Rows of both storage modes are allocated from the memory
+// resource given to the constructor, e.g. an arena (see 'arena.h') reused by one thread for file after file. Loaders
+// reserve storage once from the size of the file, so rows are never moved while loading, and nothing is shrunk
+// afterwards: a file lives only as long as it is analyzed or converted.
 // 
 // Class properties:
-// - m_data: std::vector of raw data represented as a single row.
+// - m_storage: storage mode, set once in constructor;
+// - m_projection: fields to load, set once in constructor;
+// - m_data   : std::pmr::vector of raw data represented as a single row, used with storage::ROWS;
+// - m_columns: raw data stored column by column, used with storage::COLUMNS;
+// - m_error  : position of malformed value found by the last load<extension::TXT, loader::BUFFERED>();
+// - m_integrity: records skipped, repaired and bytes lost by the last load<extension::DAT, loader::MAPPED>(),
+//                or rows of broken blocks skipped by the last load<extension::ARC, loader::MAPPED>().
 // 
 // Class behaviors:
-// - load<extension>(): read .dat or .txt source file;
-// - save<extension>(): save .dat or .txt file;
-// - get_data()       : return a const reference to 'm_data' member.
+// - load<extension, loader>(): read .dat, .txt or .arc source file;
+// - save<extension>()        : save .dat, .txt or .arc file through a buffered writer (see 'writer.h'), works with both storage modes;
+// - encode<extension>()      : append the content of .dat, .txt or .arc file to given buffer;
+// - get_data()               : return a const reference to 'm_data' member (empty with storage::COLUMNS);
+// - get_error()              : return a const reference to 'm_error' member, line is zero if there was no error;
+// - get_integrity()          : return a const reference to 'm_integrity' member;
+// - column()                 : return all values of a single field (empty with storage::ROWS);
+// - at()                     : return a single row, works with both storage modes;
+// - size()                   : return number of loaded rows;
+// - get_projection()         : return a const reference to 'm_projection' member;
+// - dump()                   : append raw columns of loaded fields to given buffer, returns false with storage::ROWS;
+// - restore()                : replace loaded rows with columns dumped earlier by a file with the same projection
+//                              (see 'cache.h') and 'm_integrity' with what was found in that file, returns false
+//                              with storage::ROWS or if bytes do not match;
+// - reserve()                : reserve memory for given number of rows;
+// - push()                   : put a single row to the storage.
 
 namespace ws::data
 {
-	struct row
+	enum class extension
 	{
-		uint32_t count, mode;
-		float system_time, mode_time;
-		float thdg, roll, pitch;
-		float heading, azimuth;
-		float latitude, longtitude;
-		float H, Ve, Vn, Vu;
-		float dAt_X, dAt_Y, dAt_Z;
-		float dVt_X, dVt_Y, dVt_Z;
-		float gyro_X, gyro_Y, gyro_Z;
-		float acc_X, acc_Y, acc_Z;
-		float U_cplc_X, U_cplc_Y, U_cplc_Z;
-		float U_hfo_X, U_hfo_Y, U_hfo_Z;
-		float F_out_X, F_out_Y, F_out_Z;
-		float F_dith_X, F_dith_Y, F_dith_Z;
-		int gyro_X_temperature, gyro_Y_temperature, gyro_Z_temperature;
-		uint32_t acc_X_temperature, acc_Y_temperature, acc_Z_temperature;
-		uint32_t dpb_X_temperature, dpb_Y_temperature, dpb_Z_temperature;
-		float drift_X, drift_Y, drift_Z;
-		uint32_t faults;
-		float D12, D13, D21, D23, D31, D32;
-		float Mg1, Mg2, Mg3;
-		float Wo1, Wo2, Wo3;
-		float E12, E13, E21, E23, E31, E32;
-		float Ma1, Ma2, Ma3;
-		float Ao1, Ao2, Ao3;
-		uint32_t reserve, crc8, error;
+		DAT,
+		TXT,
+		ARC
 	};
 
-	enum class extension
+	enum class loader
 	{
-		DAT,
-		TXT
+		STREAM,
+		MAPPED,
+		BUFFERED
+	};
+
+	enum class storage
+	{
+		ROWS,
+		COLUMNS
+	};
+
+	// both line and column start from 1
+	struct parse_error
+	{
+		std::size_t line;
+		std::size_t column;
 	};
 
 	bool operator == (extension, extension);
 	bool operator == (const std::string_view, extension);
+	std::string_view suffix(extension);
 
 	class file
 	{
 	public:
-		file() = default;
+		explicit file(storage = storage::ROWS, const projection & = schema::all(),
+					  std::pmr::memory_resource * = std::pmr::get_default_resource());
 	public:
-		template <extension>
+		template <extension, loader = loader::STREAM>
 		bool load(const std::string_view);
 		template <extension>
 		bool save(const std::string_view);
-		const std::vector<row> & get_data() const;
+		template <extension>
+		void encode(std::string &) const;
+		const std::pmr::vector<row> & get_data() const;
+		const parse_error & get_error() const;
+		const integrity::report & get_integrity() const;
+		template <typename T>
+		std::span<const T> column(const T row:: *) const;
+		row at(std::size_t) const;
+		std::size_t size() const;
+		const projection & get_projection() const;
+		bool dump(std::string &) const;
+		bool restore(std::span<const std::byte>, std::size_t, const integrity::report & = {});
+	private:
+		void reserve(std::size_t);
+		void push(const row &);
 	private:
-		std::vector<row> m_data;
+		storage m_storage;
+		projection m_projection;
+		std::pmr::vector<row> m_data;
+		columns m_columns;
+		parse_error m_error {};
+		integrity::report m_integrity {};
 	};
+
+	template <typename T>
+	std::span<const T> file::column(const T row:: * member) const
+	{
+		return m_storage == storage::COLUMNS ? m_columns.column(member) : std::span<const T>();
+	}
 }
 
 template <>
@@ -85,8 +146,11 @@ struct std::formatter<ws::data::extension> : std::formatter<std::string_view>
 	template <typename T>
 	auto format(ws::data::extension extension, T & t)
 	{
-		return extension == ws::data::extension::DAT
-			? std::formatter<std::string_view>::format("DAT", t)
-			: std::formatter<std::string_view>::format("TXT", t);
+		switch (extension)
+		{
+		case ws::data::extension::DAT: return std::formatter<std::string_view>::format("DAT", t);
+		case ws::data::extension::TXT: return std::formatter<std::string_view>::format("TXT", t);
+		default: return std::formatter<std::string_view>::format("ARC", t);
+		}
 	}
 };
\ No newline at end of file
@@ -0,0 +1,138 @@
+//
+//  generator.cpp
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+#include <format>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include "schema.h"
+#include "synthetic.h"
+#include "thread_pool.h"
+
+// Makes a folder of synthetic .dat recordings (see 'synthetic.h') for load and throughput tests. Files are named
+// the way the unit names them, a time stamp followed by '_binout1.dat', one minute apart, and the true heading
+// goes round by 45° from file to file. File i is made with seed + i, so any single file could be made again.
+// Files are written in parallel, one task per file. Probabilities of faults are per record.
+//
+// Usage: BINS_generator <output folder> [--files n] [--length seconds] [--seed n] [--threads n]
+//                       [--drop p] [--crc p] [--spike p] [--garbage p] [--truncate]
+
+namespace
+{
+	void print(const std::string_view string)
+	{
+		fputs(std::string(string).c_str(), stdout);
+		fflush(stdout);
+	}
+
+	// the unit names files by the time it was switched on
+	std::string name(std::size_t index)
+	{
+		using namespace std::chrono;
+		const sys_seconds time {sys_days {year {2023} / 1 / 1} + minutes(index)};
+		const sys_days day {floor<days>(time)};
+		const year_month_day date {day};
+		const hh_mm_ss clock {time - day};
+		return std::format("{:04}{:02}{:02}{:02}{:02}{:02}_binout1.dat", static_cast<int>(date.year()), static_cast<unsigned>(date.month()),
+		                   static_cast<unsigned>(date.day()), clock.hours().count(), clock.minutes().count(), clock.seconds().count());
+	}
+}
+
+int main(int argc, char * argv[])
+{
+	if (argc < 2)
+	{
+		print("Usage: BINS_generator <output folder> [--files n] [--length seconds] [--seed n] [--threads n]\n"
+		      "                      [--drop p] [--crc p] [--spike p] [--garbage p] [--truncate]\n");
+		return 1;
+	}
+	const std::filesystem::path folder {argv[1]};
+	std::size_t files {12};
+	uint32_t threads {};
+	ws::data::synthetic::settings settings {};
+	for (int i {2}; i < argc; ++i)
+	{
+		const std::string option {argv[i]};
+		if (option == "--truncate")
+		{
+			settings.faults.truncate = true;
+			continue;
+		}
+		if (i + 1 == argc)
+		{
+			print(std::format("No value for \"{}\"\n", option));
+			return 1;
+		}
+		const std::string value {argv[++i]};
+		if (option == "--files") { files = std::stoull(value); }
+		else if (option == "--length") { settings.length = static_cast<uint32_t>(std::stoul(value)); }
+		else if (option == "--seed") { settings.seed = std::stoull(value); }
+		else if (option == "--threads") { threads = static_cast<uint32_t>(std::stoul(value)); }
+		else if (option == "--drop") { settings.faults.drop = std::stod(value); }
+		else if (option == "--crc") { settings.faults.crc = std::stod(value); }
+		else if (option == "--spike") { settings.faults.spike = std::stod(value); }
+		else if (option == "--garbage") { settings.faults.garbage = std::stod(value); }
+		else
+		{
+			print(std::format("Unknown option \"{}\"\n", option));
+			return 1;
+		}
+	}
+	std::error_code error;
+	std::filesystem::create_directories(folder, error);
+	if (error)
+	{
+		print(std::format("Could not create \"{}\"\n", folder.string()));
+		return 1;
+	}
+	print(std::format("{} files of {} records, {:.1f} MB, to \"{}\"\n", files, settings.length,
+	                  static_cast<double>(files) * settings.length * ws::data::schema::size / 1e6, folder.string()));
+
+	std::mutex mutex;
+	ws::data::synthetic::injected total {};
+	std::size_t failed {};
+	const auto start {std::chrono::steady_clock::now()};
+	{
+		ws::data::thread_pool pool {threads};
+		for (std::size_t i {}; i < files; ++i)
+		{
+			pool.submit([&, i]
+			{
+				ws::data::synthetic::settings file {settings};
+				file.seed = settings.seed + i;
+				file.heading = static_cast<float>(i * 45 % 360);
+				// the unit writes different error codes from run to run
+				constexpr uint32_t errors[] {1, 3, 8};
+				file.error = errors[i % 3];
+				ws::data::synthetic synthetic {file};
+				const bool saved {synthetic.save((folder / name(i)).string())};
+				const auto & injected {synthetic.get_injected()};
+				std::lock_guard lock {mutex};
+				failed += saved ? 0 : 1;
+				total.dropped += injected.dropped;
+				total.crc += injected.crc;
+				total.spikes += injected.spikes;
+				total.garbage += injected.garbage;
+			});
+		}
+		pool.wait();
+	}
+	const std::chrono::duration<double> elapsed {std::chrono::steady_clock::now() - start};
+	const double megabytes {static_cast<double>(files) * settings.length * ws::data::schema::size / 1e6};
+	print(std::format("Done in {:.2f} s, {:.0f} MB/s\n", elapsed.count(), megabytes / elapsed.count()));
+	print(std::format("Faults: {} dropped, {} bad checksums, {} gyro spikes, {} garbage inserts{}\n", total.dropped,
+	                  total.crc, total.spikes, total.garbage, settings.faults.truncate ? ", last records truncated" : ""));
+	if (failed > 0)
+	{
+		print(std::format("Could not write {} files\n", failed));
+		return 1;
+	}
+	return 0;
+}
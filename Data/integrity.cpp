@@ -0,0 +1,136 @@
+//
+//  integrity.cpp
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#include <cstring>
+#include "integrity.h"
+#include "record.h"
+#include "schema.h"
+
+namespace ws::data
+{
+	namespace
+	{
+		// the checksum covers all bytes before it
+		constexpr std::size_t crc8_offset {schema::find<&row::crc8>().offset};
+		static_assert(crc8_offset % 8 == 3, "bytes after the last whole word are folded one by one");
+
+		bool valid(const std::byte * data)
+		{
+			return crc8(data, crc8_offset) == static_cast<uint8_t>(data[crc8_offset]);
+		}
+
+		uint32_t count_of(const std::byte * data)
+		{
+			return record(data).get<&row::count>();
+		}
+
+		// counts are 2 bytes wide, so a step is found modulo 2^16 and a count that wrapped around still follows
+		bool follows(uint32_t count, uint32_t last)
+		{
+			const auto step {static_cast<uint16_t>(count - last)};
+			return step > 0 && step <= integrity::max_gap;
+		}
+	}
+
+	integrity::integrity(std::pmr::memory_resource * resource) : m_runs(resource) {}
+
+	bool integrity::check(std::span<const std::byte> bytes)
+	{
+		m_runs.clear();
+		m_report = {};
+		std::size_t position {};
+		// set once bytes were lost or inserted, later frames are not where whole records would put them
+		bool shifted {};
+		bool known {};
+		uint32_t last {};
+		while (position + schema::size <= bytes.size())
+		{
+			const std::size_t records {verify(bytes.data() + position, (bytes.size() - position) / schema::size)};
+			if (records)
+			{
+				m_runs.push_back({position, records});
+				m_report.records += records;
+				m_report.repaired += shifted ? records : 0;
+				position += records * schema::size;
+				last = count_of(bytes.data() + position - schema::size);
+				known = true;
+				continue;
+			}
+			// if nothing good is left, the rest is lost
+			const std::size_t next {this->resync(bytes, position, known, last)};
+			const std::size_t gap {next - position};
+			m_report.skipped += gap / schema::size;
+			m_report.garbage += gap % schema::size;
+			shifted = shifted || gap % schema::size != 0;
+			position = next;
+		}
+		m_report.truncated = bytes.size() - position;
+		return !m_report.skipped && !m_report.garbage && !m_report.truncated;
+	}
+
+	std::size_t integrity::verify(const std::byte * data, std::size_t records)
+	{
+		std::size_t i {};
+		// four records at once: their checksums do not depend on each other, so lookups of all four overlap
+		for (; i + 4 <= records; i += 4)
+		{
+			const std::byte * first {data + i * schema::size};
+			uint8_t crc[4] {};
+			for (std::size_t offset {}; offset + 8 <= crc8_offset; offset += 8)
+			{
+				for (std::size_t j {}; j < 4; ++j)
+				{
+					uint64_t word {};
+					std::memcpy(&word, first + j * schema::size + offset, sizeof(word));
+					crc[j] = crc8_fold(crc[j], word);
+				}
+			}
+			for (std::size_t j {}; j < 4; ++j)
+			{
+				const std::byte * frame {first + j * schema::size};
+				for (std::size_t offset {crc8_offset / 8 * 8}; offset < crc8_offset; ++offset)
+				{
+					crc[j] = crc8_table[0][crc[j] ^ static_cast<uint8_t>(frame[offset])];
+				}
+				if (crc[j] != static_cast<uint8_t>(frame[crc8_offset])) { return i + j; }
+			}
+		}
+		for (; i < records; ++i)
+		{
+			if (!valid(data + i * schema::size)) { return i; }
+		}
+		return records;
+	}
+
+	const std::pmr::vector<integrity::run> & integrity::get_runs() const
+	{
+		return m_runs;
+	}
+
+	const integrity::report & integrity::get_report() const
+	{
+		return m_report;
+	}
+
+	std::size_t integrity::resync(std::span<const std::byte> bytes, std::size_t position, bool known, uint32_t last) const
+	{
+		for (std::size_t next {position + 1}; next + schema::size <= bytes.size(); ++next)
+		{
+			const std::byte * frame {bytes.data() + next};
+			// 'count' is cheap to read, so most places are passed over before any checksum is computed
+			const uint32_t count {count_of(frame)};
+			if (known && !follows(count, last)) { continue; }
+			if (!valid(frame)) { continue; }
+			// a single checksum matches by chance once in 256 places, so a frame off the place of a whole record
+			// is taken only if the frame after it matches too
+			if ((known && (next - position) % schema::size == 0) || next + 2 * schema::size > bytes.size()) { return next; }
+			const std::byte * after {frame + schema::size};
+			if (valid(after) && follows(count_of(after), count)) { return next; }
+		}
+		return bytes.size();
+	}
+}
@@ -0,0 +1,75 @@
+//
+//  integrity.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <span>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+// Integrity class finds records of a .dat file that could be trusted. Every record ends with a checksum of
+// its other bytes (see crc8() in 'record.h'); checksums are verified for many records at once, four
+// records are folded side by side eight bytes at a time, so a clean file is checked at the speed it is read.
+// Records with valid checksums going one after another make a run. At a record that does not match, the
+// next frame is searched for byte by byte: a frame is accepted if its 'count' follows the last good one by
+// at most 'max_gap' and its checksum is valid; a frame off the place of a whole record must be followed by
+// one more such frame, since a checksum alone matches by chance once in 256 places. A broken record
+// of the right length makes a whole frame skipped; bytes lost or inserted on the way put all later frames
+// off their places, they are read from their real places and counted as repaired. Bytes left before the
+// next frame are counted as garbage, an incomplete record at the end as truncated.
+//
+// Class properties:
+// - m_runs  : runs of good records, offset of the first one in bytes and their number;
+// - m_report: what was found by the last check().
+//
+// Class behaviors:
+// - check()     : find all good records of given bytes, returns true if they are all whole good records;
+// - verify()    : return number of records with valid checksums one after another from the given address;
+// - get_runs()  : return a const reference to the 'm_runs' member;
+// - get_report(): return a const reference to the 'm_report' member;
+// - resync()    : return offset of the next good frame after the given one, or the size of bytes if there is none.
+
+namespace ws::data
+{
+	class integrity
+	{
+	public:
+		struct run
+		{
+			std::size_t offset;
+			std::size_t records;
+		};
+		struct report
+		{
+			// good records
+			std::size_t records;
+			// whole frames with checksums that do not match
+			std::size_t skipped;
+			// good records found at their real places after bytes were lost or inserted
+			std::size_t repaired;
+			// bytes out of frames
+			std::size_t garbage;
+			// bytes of an incomplete record at the end
+			std::size_t truncated;
+		};
+		// the largest step of 'count' between two good records, one hour of dropped records
+		static constexpr uint32_t max_gap {3600};
+	public:
+		explicit integrity(std::pmr::memory_resource * = std::pmr::get_default_resource());
+	public:
+		bool check(std::span<const std::byte>);
+		static std::size_t verify(const std::byte *, std::size_t);
+		const std::pmr::vector<run> & get_runs() const;
+		const report & get_report() const;
+	private:
+		std::size_t resync(std::span<const std::byte>, std::size_t, bool, uint32_t) const;
+	private:
+		std::pmr::vector<run> m_runs;
+		report m_report {};
+	};
+}
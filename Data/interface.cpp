@@ -6,8 +6,10 @@
 //
 
 #include <locale>
+#include <thread>
 #include <iostream>
 #include "interface.h"
+#include "profiler.h"
 
 // C++23 std::print() function to use with std::format
 constexpr void print(const std::string_view string, auto && ... args)
@@ -42,10 +44,10 @@ namespace ws::data
 		{
 			for (const auto & data : m_collection.get_data())
 			{
-				// data.second.first  - name of the added file
-				// data.second.second - 'estimate' struct (see 'collection.h')
-				print(std::format("{:-<74}\n", data.second.first));
-				print(std::format("{}", *data.second.second));
+				// data.name  - name of the added file
+				// data.value - 'estimate' struct (see 'collection.h')
+				print(std::format("{:-<74}\n", data.name));
+				print(std::format("{}", data.value));
 			}
 		}
 		this->get_logs();
@@ -65,7 +67,7 @@ namespace ws::data
 		if (!m_collection.empty())
 		{
 			print("Файлов добавлено: {}\n\n", m_collection.get_data().size());
-			// file.first - path given by user where added files are located
+			// file.path - path given by user where added files are located
 			// change global local here because path string could contain cyrillic characters
 			// and they won't display properly if utf8 locale is used (only Windows aware)
 		#if defined (_WIN32)
@@ -73,7 +75,7 @@ namespace ws::data
 		#endif
 			for (const auto & file : m_collection.get_data())
 			{
-				print("{}\n", file.first);
+				print("{}\n", file.path);
 			}
 			print("\n");
 			// switch locale back to utf8
@@ -132,15 +134,188 @@ namespace ws::data
 			  "4 или 'C' - конвертирование файлов из .dat в .txt.\n"
 			  "5 или 'H' - помощь.\n"
 			  "'A' - добавить все .dat или .txt файлы в папке, где расположен .exe файл программы.\n"
+			  "'L' - анализ .dat файла или канала (FIFO) во время записи, обновляется с каждой новой строкой;\n"
+			  "      завершается, когда канал закрыт, в файл 10 секунд ничего не записывалось или нажат \"enter\".\n"
+			  "'P' - профилирование: время этапов загрузки, анализа, конвертации, сохранения и вывода на экран,\n"
+			  "      объём прочитанных данных; при заданной переменной окружения BINS_PROFILE при выходе\n"
+			  "      записывается в .json файл по указанному в ней пути (если программа собрана с BINS_PROFILING).\n"
+			  "'T' - сводная статистика всех файлов: по румбам, по температуре, доля в допуске и распределение СКО,\n"
+			  "      сводку можно сохранить в .json файл.\n"
+			  "'N' - шумы гироскопов по вариации Аллана: случайное блуждание угла, нестабильность нуля и случайное\n"
+			  "      блуждание скорости каждого файла, таблицу можно сохранить в .txt файл.\n"
+			  "'D' - спектры гироскопов, акселерометров и частот подставки (метод Уэлча): частота пика, мощность\n"
+			  "      и мощность в равных полосах частот каждого файла, таблицу можно сохранить в .txt файл.\n"
 			  "'V' - выбор формата добавляемых файлов.\n"
+			  "'W' - отслеживание изменений в добавленных папках (только Linux): повторное добавление папки не обходит её заново.\n"
+			  "'K' - кэш разобранных файлов во временной папке: повторная загрузка тех же файлов не разбирает их заново.\n"
 			  "'X' - завершение работы программы.\n\n"
 		      "Чтобы добавить файлы, необходимо указать путь к папке или одиночному файлу и нажать \"enter\",\n"
-			  "после чего выполнится автоматический поиск .dat или .txt файлов (в зависимости от выбранного формата).\n"
+			  "после чего выполнится автоматический поиск .dat, .txt или .arc файлов (в зависимости от выбранного формата).\n"
+			  "Формат .arc - сжатый архив записей .dat для долгого хранения, сохраняет их без потерь.\n"
+			  "При повторном добавлении той же папки загружаются только новые и изменённые файлы.\n"
 			  "Анализ включает в себя: погрешности определения курса, крена, тангажа и СКО (стандартного отклонения)\n"
 			  "гироскопов X, Y и Z. Результат можно сохранить в .txt файл, который затем удобно открыть в \"MS Excel\"\n"
 			  "с указанием разделителя \"табуляция\".\n"
 			  "Чтобы выполнить преобразование из .dat в .txt, из меню \"конвертация\" укажите путь к папке или файлу и нажмите\n"
-			  "\"enter\". Программа выполнит автоматическую конвертацию найденных файлов и сохранит результат по тому же адресу.\n\n");
+			  "\"enter\". Программа выполнит автоматическую конвертацию найденных файлов и сохранит результат по тому же адресу.\n\n"
+			  "Без интерфейса, для скриптов: BINS_workstation <папка или файл>... --report <файл .txt или .json>\n"
+			  "[--summary <файл .json>] [--allan <файл .txt>] [--spectrum <файл .txt>] [--convert] [--archive] [--threads n]\n"
+			  "[--txt] [--arc] [--cache] [--quiet]; код завершения 0 - успешно, 1 - неверные аргументы, 2 - не все файлы загружены\n"
+			  "или конвертированы, 3 - не удалось записать отчёт.\n\n");
+		this->get_logs();
+	}
+
+	template <>
+	void interface::output<interface::menu::PROFILE>()
+	{
+		clear();
+		print(std::format("[{}]{:>12}{:>11}{:>16}{:>17}{:>13}\n\n",
+						  m_collection.get_extension(),
+						  "Анализ",
+						  "Файлы",
+						  "Cохранить",
+						  "Конвертация",
+						  "Помощь"));
+		print("{}\n\n", utility::apply("Профилирование", utility::text::BOLD));
+		if constexpr (profiler::enabled)
+		{
+			print("{}\n", profiler::instance().report());
+		}
+		else
+		{
+			print("Программа собрана без профилирования (параметр CMake BINS_PROFILING)\n\n");
+		}
+		this->get_logs();
+	}
+
+	template <>
+	void interface::output<interface::menu::SUMMARY>()
+	{
+		clear();
+		print(std::format("[{}]{:>12}{:>11}{:>16}{:>17}{:>13}\n\n",
+						  m_collection.get_extension(),
+						  "Анализ",
+						  "Файлы",
+						  "Cохранить",
+						  "Конвертация",
+						  "Помощь"));
+		print("{}\n\n", utility::apply("Сводная статистика", utility::text::BOLD));
+		if (m_collection.empty())
+		{
+			this->get_logs();
+			return;
+		}
+		// computed once per visit of the page, not again for every redraw or for saving it
+		if (!m_summary) { m_summary = m_collection.summarize(); }
+		const aggregate::report & report {*m_summary};
+		auto share {[](const aggregate::group & group)
+		{
+			return 100.0 * static_cast<double>(group.passed) / static_cast<double>(group.count);
+		}};
+		print(std::format("Файлов: {}, в допуске: {} ({:.1f}%)\n", report.total.count, report.total.passed, share(report.total)));
+		print(std::format("Превышен допуск: курс {}, крен {}, тангаж {}\n\n",
+						  report.total.failed[0], report.total.failed[1], report.total.failed[2]));
+		// errors in arc seconds, mean and the largest one
+		print(std::format("{:<8}{:>8}{:>12}{:>14}{:>10}{:>14}{:>10}\n", "Румб", "Файлов", "В допуске", "Курс, сред.", "макс.", "Крен, сред.", "макс."));
+		for (const auto & [rhumb, group] : report.rhumbs)
+		{
+			const statistics::summary thdg {group.errors[0].get()};
+			const statistics::summary roll {group.errors[1].get()};
+			print(std::format("{:<8}{:>8}{:>11.1f}%{:>13.1f}\"{:>9.1f}\"{:>13.1f}\"{:>9.1f}\"\n",
+							  std::format("{}°", aggregate::bearing(rhumb)), group.count, share(group), thdg.mean, thdg.max, roll.mean, roll.max));
+		}
+		print(std::format("\n{:<14}{:>8}{:>12}{:>10}{:>10}{:>10}\n", "Температура", "Файлов", "В допуске", "СКО X", "СКО Y", "СКО Z"));
+		for (const auto & [band, group] : report.bands)
+		{
+			print(std::format("{:<14}{:>8}{:>11.1f}%{:>10.4f}{:>10.4f}{:>10.4f}\n", std::format("{}..{}°C", band, band + aggregate::band_width),
+							  group.count, share(group), group.deviation[0].get().mean, group.deviation[1].get().mean,
+							  group.deviation[2].get().mean));
+		}
+		print("\nСКО гироскопов: среднее, стандартное отклонение, минимум, максимум и число файлов по {} равным интервалам\n", aggregate::bins);
+		for (std::size_t axis {}; axis < 3; ++axis)
+		{
+			const aggregate::distribution & distribution {report.deviation[axis]};
+			std::string histogram;
+			for (const std::size_t count : distribution.histogram) { histogram += std::format("{:>6}", count); }
+			print(std::format("{}{:>10.4f}{:>10.4f}{:>10.4f}{:>10.4f} |{}\n", "XYZ"[axis], distribution.summary.mean,
+							  distribution.summary.deviation, distribution.summary.min, distribution.summary.max, histogram));
+		}
+		print("\n");
+		this->get_logs();
+	}
+
+	template <>
+	void interface::output<interface::menu::NOISE>()
+	{
+		clear();
+		print(std::format("[{}]{:>12}{:>11}{:>16}{:>17}{:>13}\n\n",
+						  m_collection.get_extension(),
+						  "Анализ",
+						  "Файлы",
+						  "Cохранить",
+						  "Конвертация",
+						  "Помощь"));
+		print("{}\n\n", utility::apply("Шумы гироскопов (вариация Аллана)", utility::text::BOLD));
+		if (m_collection.empty())
+		{
+			this->get_logs();
+			return;
+		}
+		// random walk of angle, bias instability and rate random walk, zero if not found on the curve
+		print(std::format("{:<32}{:>4}{:>14}{:>14}{:>14}\n", "Файл", "Ось", "ARW", "Нестаб. нуля", "RRW"));
+		for (const auto & data : m_collection.get_data())
+		{
+			std::size_t axis {};
+			for (const allan::coefficients & coefficients : {data.value.allan_X, data.value.allan_Y, data.value.allan_Z})
+			{
+				print(std::format("{:<32}{:>4}{:>14.6g}{:>14.6g}{:>14.6g}\n", axis ? "" : data.name, "XYZ"[axis],
+								  coefficients.random_walk, coefficients.bias_instability, coefficients.rate_random_walk));
+				++axis;
+			}
+		}
+		print("\n");
+		this->get_logs();
+	}
+
+	template <>
+	void interface::output<interface::menu::SPECTRUM>()
+	{
+		clear();
+		print(std::format("[{}]{:>12}{:>11}{:>16}{:>17}{:>13}\n\n",
+						  m_collection.get_extension(),
+						  "Анализ",
+						  "Файлы",
+						  "Cохранить",
+						  "Конвертация",
+						  "Помощь"));
+		print("{}\n\n", utility::apply("Спектры (метод Уэлча)", utility::text::BOLD));
+		if (m_collection.empty())
+		{
+			this->get_logs();
+			return;
+		}
+		// power of the column and of equal bands from zero to the highest frequency
+		print(std::format("{:<10}{:>10}{:>12}", "Канал", "Пик, Гц", "Мощность"));
+		for (std::size_t band {1}; band <= spectrum::bands; ++band) { print(std::format("{:>10}", std::format("Полоса {}", band))); }
+		print("\n");
+		constexpr std::string_view sensors[] {"gyro", "acc", "F_dith"};
+		for (const auto & data : m_collection.get_data())
+		{
+			print(std::format("{:-<74}\n", data.name));
+			std::size_t sensor {};
+			for (const auto * axes : {&data.value.gyro_spectrum, &data.value.acc_spectrum, &data.value.dither_spectrum})
+			{
+				for (std::size_t axis {}; axis < 3; ++axis)
+				{
+					const spectrum::features & features {(*axes)[axis]};
+					print(std::format("{:<10}{:>10.4f}{:>12.5g}", std::format("{}_{}", sensors[sensor], "XYZ"[axis]), features.peak, features.power));
+					for (const float band : features.band) { print(std::format("{:>10.4g}", band)); }
+					print("\n");
+				}
+				++sensor;
+			}
+		}
+		print("\n");
 		this->get_logs();
 	}
 
@@ -150,7 +325,10 @@ namespace ws::data
 		m_output = std::mem_fn(&interface::output<menu::MAIN>);
 		while (!m_quit)
 		{
-			m_output(this);
+			{
+				WS_PROFILE(RENDER);
+				m_output(this);
+			}
 			this->get_input(input);
 			// std::filesystem::path could throw exception sometimes if incorrect string is given as source
 			try
@@ -163,7 +341,8 @@ namespace ws::data
 				}
 				else if (std::filesystem::is_directory(std::filesystem::path(input)))
 				{
-					m_collection.add_all(std::filesystem::path(input), m_logger);
+					this->drain([this, &input] { m_collection.add_all(std::filesystem::path(input), m_logger); });
+					m_summary.reset();
 				}
 				else if (std::filesystem::is_regular_file(std::filesystem::path(input)))
 				{
@@ -171,17 +350,17 @@ namespace ws::data
 				}
 				else
 				{
-					m_logger.log("Неправильный ввод\n");
+					m_logger.log("Неправильный ввод\n", logger::severity::WARNING);
 				}
 			}
 			catch (const std::invalid_argument &)
 			{
-				m_logger.log("Ошибка при добавлении файлов, перезапустите программу\n");
+				m_logger.log("Ошибка при добавлении файлов, перезапустите программу\n", logger::severity::FAILURE);
 				m_error_state = true;
 			}
 			catch (const std::system_error &)
 			{
-				m_logger.log("Ошибка при добавлении файлов, перезапустите программу\n");
+				m_logger.log("Ошибка при добавлении файлов, перезапустите программу\n", logger::severity::FAILURE);
 				m_error_state = true;
 			}
 		}
@@ -196,7 +375,8 @@ namespace ws::data
 			case 'a':
 			case 'A':
 			{
-				m_collection.add_all(std::filesystem::current_path(), m_logger);
+				this->drain([this] { m_collection.add_all(std::filesystem::current_path(), m_logger); });
+				m_summary.reset();
 				break;
 			}
 			// main menu
@@ -268,7 +448,7 @@ namespace ws::data
 					}
 					if (std::filesystem::is_directory(std::filesystem::path(input)))
 					{
-						m_collection.convert_all(std::filesystem::path(input), m_logger);
+						this->drain([this, &input] { m_collection.convert_all(std::filesystem::path(input), m_logger); });
 					}
 					if (std::filesystem::is_regular_file(std::filesystem::path(input)))
 					{
@@ -277,16 +457,123 @@ namespace ws::data
 				}
 				catch (const std::invalid_argument &)
 				{
-					m_logger.log("Ошибка при конвертации, перезапустите программу\n");
+					m_logger.log("Ошибка при конвертации, перезапустите программу\n", logger::severity::FAILURE);
 					m_error_state = true;
 				}
 				catch (const std::system_error &)
 				{
-					m_logger.log("Ошибка при конвертации, перезапустите программу\n");
+					m_logger.log("Ошибка при конвертации, перезапустите программу\n", logger::severity::FAILURE);
 					m_error_state = true;
 				}
 				break;
 			}
+			// analyze a recording that is still being written
+			case 'l':
+			case 'L':
+			{
+				m_logger.log("Введите путь к записываемому .dat файлу или каналу\n");
+				m_output(this);
+				this->get_input(input);
+				if (input.size() < 2)
+				{
+					this->execute(input);
+					break;
+				}
+				const std::filesystem::path path {input};
+				// the recording is followed on its own thread, so this one waits for "enter" to stop it
+				std::jthread watch {[this, &path](std::stop_token stop)
+				{
+					m_collection.follow(path, m_logger, [this, &path](const std::string & estimate)
+					{
+						this->clear();
+						print("Запись \"{}\"\n\n{}\nНажмите \"enter\", чтобы остановить анализ\n", path.filename().string(), estimate);
+					}, stop);
+					if (!stop.stop_requested()) { print("Анализ завершён, нажмите \"enter\"\n"); }
+				}};
+				std::getline(std::cin, input);
+				if (!std::cin) { std::cin.clear(); }
+				watch.request_stop();
+				watch.join();
+				m_output = std::mem_fn(&interface::output<menu::MAIN>);
+				break;
+			}
+			// time spent in every stage and counters of processed data
+			case 'p':
+			case 'P':
+			{
+				m_output = std::mem_fn(&interface::output<menu::PROFILE>);
+				break;
+			}
+			// statistics of all added files, could be saved to .json file
+			case 't':
+			case 'T':
+			{
+				m_output = std::mem_fn(&interface::output<menu::SUMMARY>);
+				m_summary.reset();
+				if (m_collection.empty())
+				{
+					m_logger.log("Нет добавленных файлов\n");
+					break;
+				}
+				m_logger.log("Введите имя файла (.json), чтобы сохранить сводку, или команду\n");
+				m_output(this);
+				this->get_input(input);
+				if (input.size() > 1)
+				{
+					m_collection.save_summary(input, *m_summary, m_logger);
+				}
+				else
+				{
+					this->execute(input);
+				}
+				break;
+			}
+			// noise terms of gyroscopes of all added files, could be saved to .txt file
+			case 'n':
+			case 'N':
+			{
+				m_output = std::mem_fn(&interface::output<menu::NOISE>);
+				if (m_collection.empty())
+				{
+					m_logger.log("Нет добавленных файлов\n");
+					break;
+				}
+				m_logger.log("Введите имя файла (.txt), чтобы сохранить таблицу, или команду\n");
+				m_output(this);
+				this->get_input(input);
+				if (input.size() > 1)
+				{
+					m_collection.save_allan(input, m_logger);
+				}
+				else
+				{
+					this->execute(input);
+				}
+				break;
+			}
+			// spectra of all added files, could be saved to .txt file
+			case 'd':
+			case 'D':
+			{
+				m_output = std::mem_fn(&interface::output<menu::SPECTRUM>);
+				if (m_collection.empty())
+				{
+					m_logger.log("Нет добавленных файлов\n");
+					break;
+				}
+				m_logger.log("Введите имя файла (.txt), чтобы сохранить таблицу, или команду\n");
+				m_output(this);
+				this->get_input(input);
+				if (input.size() > 1)
+				{
+					m_collection.save_spectrum(input, m_logger);
+				}
+				else
+				{
+					this->execute(input);
+				}
+				break;
+			}
 			// help menu
 			case 'h':
 			case 'H':
@@ -303,6 +590,34 @@ namespace ws::data
 				m_logger.log("Формат загружаемых файлов изменён\n");
 				break;
 			}
+			// watch added folders for changes
+			case 'w':
+			case 'W':
+			{
+				m_collection.set_watch(!m_collection.get_watch());
+				m_logger.log(m_collection.get_watch() ? "Отслеживание изменений включено\n" : "Отслеживание изменений выключено\n");
+				break;
+			}
+			// keep images of parsed files in the temporary folder
+			case 'k':
+			case 'K':
+			{
+				if (m_collection.get_cache().enabled())
+				{
+					// images already written stay in the folder for the next time
+					m_collection.set_cache(m_collection.get_cache().get_folder(), 0);
+					m_logger.log("Кэш разобранных файлов выключен\n");
+				}
+				else if (m_collection.set_cache(cache::default_folder(), cache::default_capacity))
+				{
+					m_logger.log(std::format("Кэш разобранных файлов включён: \"{}\"\n", m_collection.get_cache().get_folder().string()));
+				}
+				else
+				{
+					m_logger.log("Не удалось открыть папку кэша\n", logger::severity::WARNING);
+				}
+				break;
+			}
 			// quit the program
 			case 'x':
 			case 'X':
@@ -312,16 +627,28 @@ namespace ws::data
 			}
 			default:
 			{
-				m_logger.log("Незвестная команда\n");
+				m_logger.log("Незвестная команда\n", logger::severity::WARNING);
 			}
 		}
 	}
 
 	void interface::get_logs()
 	{
+		auto show {[](logger::severity severity, const std::string & message)
+		{
+			// failures stand out in red
+			print("{}\n", severity == logger::severity::FAILURE ? utility::apply(message, utility::text::RED) : message);
+		}};
+		for (const auto & [severity, message] : m_messages)
+		{
+			show(severity, message);
+		}
+		m_messages.clear();
 		while (!m_logger.empty())
 		{
-			print("{}\n", m_logger.extract());
+			logger::severity severity {};
+			const std::string message {m_logger.extract(severity)};
+			show(severity, message);
 		}
 		if (!m_error_state)
 		{
@@ -333,6 +660,12 @@ namespace ws::data
 		}
 	}
 
+	void interface::drain(const std::function<void()> & task)
+	{
+		// the screen is cleared before the next menu is drawn, so messages are kept until get_logs() prints them
+		m_logger.drain(task, [this](logger::severity severity, const std::string & message) { m_messages.emplace_back(severity, message); });
+	}
+
 	void interface::get_input(std::string & input)
 	{
 		std::getline(std::cin, input);
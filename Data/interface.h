@@ -6,6 +6,10 @@
 //
 
 #pragma once
+#include <vector>
+#include <string>
+#include <utility>
+#include <optional>
 #include <functional>
 #include "collection.h"
 
@@ -13,7 +17,7 @@
 #undef interface
 #endif
 
-// Console interface for the program. It consist of five menus, described as 'menu' enum class and template
+// Console interface for the program. It consist of nine menus, described as 'menu' enum class and template
 // component function 'output' to show it.
 // 
 // Class properties:
@@ -22,13 +26,16 @@
 //                  (needs to be resolved in the future);
 // - m_logger     : an instance of logger class (see 'logger.h') to show messages to user;
 // - m_collection : an instance of file_clollection class (see 'collection.h');
+// - m_messages   : messages taken out of 'm_logger' while a long command ran, not shown yet;
+// - m_summary    : statistics of all files shown by the summary menu, empty until it is opened or after files are added;
 // - m_output     : pointer to the tamplate 'output' fucntion to switch between menus.
 // 
 // Class behaviors:
 // - start()    : main program loop;
 // - output()   : show different menus of the program;
 // - execute()  : runs commands depending on user's input;
-// - get_logs() : reads any messages stored in 'm_logger';
+// - get_logs() : shows messages kept in 'm_messages' and any messages stored in 'm_logger';
+// - drain()    : runs a long command, e.g. adding a folder, while moving its messages from 'm_logger' to 'm_messages';
 // - get_input(): reads and demands proper input;
 // - clear()    : clears console.
 
@@ -46,13 +53,18 @@ namespace ws::data
 			FILELIST,
 			SAVE,
 			CONVERT,
-			HELP
+			HELP,
+			PROFILE,
+			SUMMARY,
+			NOISE,
+			SPECTRUM
 		};
 	private:
 		template <menu>
 		void output();
 		void execute(std::string &);
 		void get_logs();
+		void drain(const std::function<void()> &);
 		void get_input(std::string &);
 		void clear() const;
 	private:
@@ -60,6 +72,8 @@ namespace ws::data
 		bool m_error_state;
 		logger m_logger;
 		file_collection m_collection;
+		std::vector<std::pair<logger::severity, std::string>> m_messages;
+		std::optional<aggregate::report> m_summary;
 		std::function<void(interface *)> m_output;
 	};
 }
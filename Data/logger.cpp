@@ -5,36 +5,160 @@
 //  Created by Denis Fedorov on 02.02.2023.
 //
 
+#include <chrono>
+#include <format>
+#include <thread>
+#include <cstring>
+#include <exception>
+#include <algorithm>
+#include <string_view>
 #include "logger.h"
 
 namespace ws::data
 {
-	logger::logger()
+	namespace
 	{
+		constexpr std::size_t mask {logger::capacity - 1};
+		static_assert((logger::capacity & mask) == 0, "capacity must be a power of two");
+		static_assert(logger::reserved < logger::capacity, "failures could not take every slot");
+		// how long drain() sleeps once the ring is empty
+		constexpr std::chrono::milliseconds period {10};
+		// in the order of severities
+		constexpr std::string_view kinds[] {"сообщений", "предупреждений", "ошибок"};
+	}
+
+	logger::logger() : m_slots(std::make_unique<slot[]>(capacity)), m_tail(), m_head(), m_dropped(), m_reported()
+	{
+		// a slot is free for writing at position p when its sequence is p
+		for (std::size_t i {}; i < capacity; ++i)
+		{
+			m_slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
 		this->log("Добро пожаловать в программу анализа файлов! Нажмите 'H' для помощи\n");
 	}
 
-	void logger::log(std::string_view message)
+	void logger::log(std::string_view message, severity severity)
 	{
-		m_logs.push(std::move(message.data()));
+		std::size_t position {m_tail.load(std::memory_order_relaxed)};
+		slot * slot {};
+		while (true)
+		{
+			slot = &m_slots[position & mask];
+			const std::size_t sequence {slot->sequence.load(std::memory_order_acquire)};
+			const auto difference {static_cast<std::ptrdiff_t>(sequence - position)};
+			// the slot 'reserved' positions ahead still holds an unread message, so only failures may go on
+			const std::size_t ahead {position + reserved};
+			const bool crowded {static_cast<std::ptrdiff_t>(m_slots[ahead & mask].sequence.load(std::memory_order_acquire) - ahead) < 0};
+			if (difference < 0 || (crowded && severity != severity::FAILURE))
+			{
+				// the reader has not taken the message written here a full lap ago, so the ring is full
+				m_dropped[static_cast<std::size_t>(severity)].fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			if (difference == 0)
+			{
+				// the slot is free, claim it unless another writer was faster
+				if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) { break; }
+			}
+			else
+			{
+				position = m_tail.load(std::memory_order_relaxed);
+			}
+		}
+		// message is not guaranteed to be null terminated, so its size is kept; a cut never splits a UTF-8 character
+		std::size_t size {std::min(message.size(), length)};
+		if (size < message.size())
+		{
+			while (size > 0 && (static_cast<unsigned char>(message[size]) & 0xC0) == 0x80) { --size; }
+		}
+		std::memcpy(slot->text.data(), message.data(), size);
+		slot->size = static_cast<uint16_t>(size);
+		slot->level = severity;
+		slot->sequence.store(position + 1, std::memory_order_release);
 	}
 
 	std::string logger::extract()
 	{
-		if (!m_logs.empty())
+		severity severity {};
+		return this->extract(severity);
+	}
+
+	std::string logger::extract(severity & severity)
+	{
+		slot & slot {m_slots[m_head & mask]};
+		if (slot.sequence.load(std::memory_order_acquire) == m_head + 1)
 		{
-			std::string s {std::move(m_logs.front())};
-			m_logs.pop();
-			return s;
+			std::string message {slot.text.data(), slot.size};
+			severity = slot.level;
+			// free the slot for the writer that comes to it on the next lap
+			slot.sequence.store(m_head + capacity, std::memory_order_release);
+			++m_head;
+			return message;
 		}
-		else
+		for (std::size_t i {}; i < m_dropped.size(); ++i)
 		{
-			return "";
+			const std::size_t dropped {m_dropped[i].load(std::memory_order_relaxed)};
+			if (dropped > m_reported[i])
+			{
+				severity = static_cast<logger::severity>(i);
+				std::string message {std::format("Из-за переполнения журнала пропущено {}: {}\n", kinds[i], dropped - m_reported[i])};
+				m_reported[i] = dropped;
+				return message;
+			}
 		}
+		return "";
 	}
 
 	bool logger::empty() const
 	{
-		return m_logs.empty();
+		if (m_slots[m_head & mask].sequence.load(std::memory_order_acquire) == m_head + 1) { return false; }
+		for (std::size_t i {}; i < m_dropped.size(); ++i)
+		{
+			if (m_dropped[i].load(std::memory_order_relaxed) != m_reported[i]) { return false; }
+		}
+		return true;
+	}
+
+	std::size_t logger::dropped(severity severity) const
+	{
+		return m_dropped[static_cast<std::size_t>(severity)].load(std::memory_order_relaxed);
+	}
+
+	void logger::drain(const std::function<void()> & task, const std::function<void(severity, const std::string &)> & reader)
+	{
+		auto read {[this, &reader]
+		{
+			bool any {};
+			while (!this->empty())
+			{
+				severity severity {};
+				const std::string message {this->extract(severity)};
+				reader(severity, message);
+				any = true;
+			}
+			return any;
+		}};
+		std::atomic<bool> done {};
+		std::exception_ptr error;
+		std::jthread worker {[&task, &done, &error]
+		{
+			try
+			{
+				task();
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+			done.store(true, std::memory_order_release);
+		}};
+		while (!done.load(std::memory_order_acquire))
+		{
+			// busy writers are read again at once, idle ones are not polled more often than 'period'
+			if (!read()) { std::this_thread::sleep_for(period); }
+		}
+		worker.join();
+		read();
+		if (error) { std::rethrow_exception(error); }
 	}
 }
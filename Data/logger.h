@@ -6,30 +6,85 @@
 //
 
 #pragma once
-#include <queue>
+#include <array>
+#include <atomic>
+#include <memory>
 #include <string>
+#include <cstdint>
+#include <functional>
 #include <string_view>
 
-// Simple logger class based on std::queue to notify user about events happening around.
+// Logger class to notify user about events happening around. Any number of threads could log at once, while
+// one thread (the interface) extracts messages. Messages go through a bounded lock-free ring of slots
+// allocated once in constructor (Vyukov's queue): a writer claims the next slot with a compare-and-swap of
+// the tail and publishes it by its sequence number, the reader takes slots in order from the head, so neither
+// side ever waits for a lock and logging costs no heap allocation. A message longer than a slot is cut at
+// a character boundary. If the ring is full, the message is dropped and counted by its severity instead of
+// blocking the writer, the reader gets a message about the drops of every severity after the messages that made
+// it. The last 'reserved' free slots are taken by failures only, so a flood of information does not push them
+// out. A long operation should run under drain(), which empties the ring while the operation logs, so messages
+// are dropped only if they come faster than the reader takes them. The class is neither copyable nor movable.
+//
 // Class properties:
-// - m_logs: std::queue to store messages as std::string
+// - m_slots   : 'capacity' slots, each with a sequence number, severity and text of one message;
+// - m_tail    : position of the next slot to write, shared by writers;
+// - m_head    : position of the next slot to read, used by the reader only;
+// - m_dropped : number of messages of every severity dropped because the ring was full;
+// - m_reported: number of dropped messages of every severity the reader was told about.
 //
 // Class behaviors:
-// - log()    : add new message, the pointer to string is not const because std::move used later to move it to the queue;
-// - extract(): pop first message out of queue;
-// - empty()  : check if there are messages in the queue.
+// - log()    : add new message of given severity, safe to call from any thread;
+// - extract(): pop first message out of the queue, or an empty string if there is none; could also return
+//              its severity, only one thread at a time may call it;
+// - empty()  : check if there are messages in the queue;
+// - dropped(): return number of messages of given severity dropped so far;
+// - drain()  : run given task on another thread and give every message logged meanwhile to given reader on
+//              the calling thread, the last ones after the task finished; an exception of the task is thrown again.
 
 namespace ws::data
 {
 	class logger
 	{
+	public:
+		enum class severity : uint8_t
+		{
+			INFO,
+			WARNING,
+			// not ERROR, it is a macro in <Windows.h>
+			FAILURE
+		};
+		// power of two, so a position maps to a slot with a mask
+		static constexpr std::size_t capacity {2048};
+		// bytes of text in a slot
+		static constexpr std::size_t length {500};
+		// free slots only failures could take
+		static constexpr std::size_t reserved {64};
 	public:
 		logger();
+		logger(const logger &) = delete;
+		logger & operator = (const logger &) = delete;
 	public:
-		void log(std::string_view);
+		void log(std::string_view, severity = severity::INFO);
 		std::string extract();
+		std::string extract(severity &);
 		bool empty() const;
+		std::size_t dropped(severity) const;
+		void drain(const std::function<void()> &, const std::function<void(severity, const std::string &)> &);
+	private:
+		struct slot
+		{
+			std::atomic<std::size_t> sequence;
+			severity level;
+			uint16_t size;
+			std::array<char, length> text;
+		};
 	private:
-		std::queue<std::string> m_logs;
+		std::unique_ptr<slot[]> m_slots;
+		// writers and the reader work on different cache lines
+		alignas(64) std::atomic<std::size_t> m_tail;
+		alignas(64) std::size_t m_head;
+		// by severity
+		std::array<std::atomic<std::size_t>, 3> m_dropped;
+		std::array<std::size_t, 3> m_reported;
 	};
 }
@@ -8,9 +8,12 @@
 #if defined(_WIN32)
 #include <Windows.h>
 #endif
+#include <cstdlib>
+#include "batch.h"
 #include "interface.h"
+#include "profiler.h"
 
-int main()
+int main(int argc, char * argv[])
 {
 #if defined(_WIN32)
 //	auto console {GetConsoleWindow()};
@@ -25,7 +28,25 @@ int main()
 	SetConsoleCP(1251);
 	SetConsoleOutputCP(65001);
 #endif
-	ws::data::interface interface;
-	interface.start();
-	return 0;
+	int status {};
+	// with arguments the program runs without the console interface (see 'batch.h')
+	if (argc > 1)
+	{
+		ws::data::batch batch;
+		status = batch.run(argc, argv);
+	}
+	else
+	{
+		ws::data::interface interface;
+		interface.start();
+	}
+	// profile of the whole session, if asked for
+	if constexpr (ws::data::profiler::enabled)
+	{
+		if (const char * path {std::getenv("BINS_PROFILE")})
+		{
+			ws::data::profiler::instance().dump(path);
+		}
+	}
+	return status;
 }
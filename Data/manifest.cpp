@@ -0,0 +1,122 @@
+//
+//  manifest.cpp
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#include "manifest.h"
+
+namespace ws::data
+{
+	manifest::manifest(const std::filesystem::path & root, extension extension) : m_root(root), m_extension(extension)
+	{
+
+	}
+
+	manifest::changes manifest::scan(bool watch)
+	{
+		changes changes;
+		++m_generation;
+		if (watch && m_watcher.active())
+		{
+			std::vector<std::filesystem::path> paths;
+			if (m_watcher.poll(paths))
+			{
+				// a file written in several steps is reported several times, but changes only once
+				for (const auto & path : paths)
+				{
+					this->check(path, changes);
+				}
+				// files that failed to load last time are not reported unless they change again
+				const std::vector<std::string> pending {m_pending.begin(), m_pending.end()};
+				for (const auto & path : pending)
+				{
+					this->check(path, changes);
+				}
+				return changes;
+			}
+		}
+		// watch from before the walk, so nothing changed during the walk is missed by the next scan
+		if (!watch || !m_watcher.open(m_root))
+		{
+			m_watcher.close();
+		}
+		this->walk(changes);
+		return changes;
+	}
+
+	void manifest::commit(const std::filesystem::path & path)
+	{
+		m_pending.erase(path.string());
+	}
+
+	std::size_t manifest::size() const
+	{
+		return m_entries.size();
+	}
+
+	void manifest::walk(changes & changes)
+	{
+		for (std::filesystem::directory_entry entry : std::filesystem::recursive_directory_iterator(m_root))
+		{
+			if (entry.path().filename().extension().string() == m_extension)
+			{
+				std::error_code error;
+				const std::uintmax_t size {entry.file_size(error)};
+				if (error) { continue; }
+				const std::filesystem::file_time_type time {entry.last_write_time(error)};
+				if (error) { continue; }
+				if (this->update(entry.path(), size, time))
+				{
+					changes.changed.push_back(entry.path());
+				}
+			}
+		}
+		for (auto i {m_entries.begin()}; i != m_entries.end(); )
+		{
+			if (i->second.generation != m_generation)
+			{
+				changes.removed.push_back(i->first);
+				m_pending.erase(i->first);
+				i = m_entries.erase(i);
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+
+	void manifest::check(const std::filesystem::path & path, changes & changes)
+	{
+		if (path.filename().extension().string() != m_extension) { return; }
+		std::error_code error;
+		const std::uintmax_t size {std::filesystem::file_size(path, error)};
+		const std::filesystem::file_time_type time {error ? std::filesystem::file_time_type() : std::filesystem::last_write_time(path, error)};
+		if (error)
+		{
+			// the file is gone
+			if (m_entries.erase(path.string()))
+			{
+				m_pending.erase(path.string());
+				changes.removed.push_back(path.string());
+			}
+		}
+		else if (this->update(path, size, time))
+		{
+			changes.changed.push_back(path);
+		}
+	}
+
+	bool manifest::update(const std::filesystem::path & path, std::uintmax_t size, std::filesystem::file_time_type time)
+	{
+		const auto [i, inserted] {m_entries.try_emplace(path.string(), entry {size, time, m_generation})};
+		// a file reported twice by one scan is returned once
+		if (!inserted && i->second.generation == m_generation) { return false; }
+		const bool changed {inserted || i->second.size != size || i->second.time != time || m_pending.contains(i->first)};
+		i->second = entry {size, time, m_generation};
+		if (changed) { m_pending.insert(i->first); }
+		return changed;
+	}
+}
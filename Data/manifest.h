@@ -0,0 +1,78 @@
+//
+//  manifest.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+#include "file.h"
+#include "watcher.h"
+
+// Manifest class remembers size and modification time of every file with given extension found in a folder
+// tree, so a folder added again is not loaded again: scan() returns only files that are new or were changed
+// since the previous scan() and files that were removed. Estimates of the files are kept by 'file_collection'
+// (see 'collection.h') under the same paths. If watching is asked for and supported (see 'watcher.h'),
+// the tree is walked only once, later scans read the list of changed files from the watcher instead.
+// A file found by scan() stays pending until it is committed, i.e. loaded: a pending file is returned by every
+// scan() until then, whether it changed or not, so a file that failed to load is tried again next time.
+//
+// Class properties:
+// - m_root      : folder the manifest describes;
+// - m_extension : extension of files to look for;
+// - m_entries   : size and modification time of every known file by its path;
+// - m_pending   : paths of files returned by scan() and not committed yet;
+// - m_generation: number of the last scan, entries not seen by the last walk belong to removed files;
+// - m_watcher   : changes of the tree since the last scan, inactive unless watching was asked for.
+//
+// Class behaviors:
+// - scan()  : find new, changed, pending and removed files, remember their current state, watch the tree for
+//             the next scan if asked to, new and changed files are returned in the order they were found,
+//             pending ones the watcher did not report after them;
+// - commit(): mark given file returned by scan() as loaded;
+// - size()  : return number of known files.
+
+namespace ws::data
+{
+	class manifest
+	{
+	public:
+		struct changes
+		{
+			std::vector<std::filesystem::path> changed;
+			std::vector<std::string> removed;
+		};
+	public:
+		manifest(const std::filesystem::path &, extension);
+		manifest(const manifest &) = delete;
+		manifest & operator = (const manifest &) = delete;
+	public:
+		changes scan(bool);
+		void commit(const std::filesystem::path &);
+		std::size_t size() const;
+	private:
+		struct entry
+		{
+			std::uintmax_t size;
+			std::filesystem::file_time_type time;
+			uint64_t generation;
+		};
+	private:
+		void walk(changes &);
+		void check(const std::filesystem::path &, changes &);
+		bool update(const std::filesystem::path &, std::uintmax_t, std::filesystem::file_time_type);
+	private:
+		std::filesystem::path m_root;
+		extension m_extension;
+		std::unordered_map<std::string, entry> m_entries;
+		std::unordered_set<std::string> m_pending;
+		uint64_t m_generation {};
+		watcher m_watcher;
+	};
+}
@@ -0,0 +1,115 @@
+//
+//  mapping.cpp
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#include <string>
+#include <utility>
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "mapping.h"
+
+namespace ws::data
+{
+	mapping::mapping(mapping && other) noexcept : m_data(std::exchange(other.m_data, nullptr)),
+												  m_size(std::exchange(other.m_size, 0))
+	{
+
+	}
+
+	mapping & mapping::operator = (mapping && other) noexcept
+	{
+		if (this != &other)
+		{
+			this->close();
+			m_data = std::exchange(other.m_data, nullptr);
+			m_size = std::exchange(other.m_size, 0);
+		}
+		return *this;
+	}
+
+	mapping::~mapping()
+	{
+		this->close();
+	}
+
+	bool mapping::open(const std::string_view filename)
+	{
+		this->close();
+		// string_view is not guaranteed to be null terminated
+		const std::string name {filename};
+	#if defined(_WIN32)
+		HANDLE file {CreateFileA(name.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+								 OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr)};
+		if (file == INVALID_HANDLE_VALUE) { return false; }
+		LARGE_INTEGER size {};
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+		HANDLE handle {CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)};
+		// the view keeps its own reference to the file, so both handles could be closed right away
+		CloseHandle(file);
+		if (!handle) { return false; }
+		void * view {MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0)};
+		CloseHandle(handle);
+		if (!view) { return false; }
+		m_data = static_cast<const std::byte *>(view);
+		m_size = static_cast<std::size_t>(size.QuadPart);
+	#else
+		int handle {::open(name.c_str(), O_RDONLY)};
+		if (handle < 0) { return false; }
+		struct stat status {};
+		if (::fstat(handle, &status) != 0 || status.st_size == 0)
+		{
+			::close(handle);
+			return false;
+		}
+		void * view {::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, handle, 0)};
+		// the mapping keeps its own reference to the file, so descriptor could be closed right away
+		::close(handle);
+		if (view == MAP_FAILED) { return false; }
+		// records are always read front to back
+		::madvise(view, static_cast<std::size_t>(status.st_size), MADV_SEQUENTIAL);
+		m_data = static_cast<const std::byte *>(view);
+		m_size = static_cast<std::size_t>(status.st_size);
+	#endif
+		return true;
+	}
+
+	void mapping::close()
+	{
+		if (!m_data) { return; }
+	#if defined(_WIN32)
+		UnmapViewOfFile(m_data);
+	#else
+		::munmap(const_cast<std::byte *>(m_data), m_size);
+	#endif
+		m_data = nullptr;
+		m_size = 0;
+	}
+
+	const std::byte * mapping::data() const
+	{
+		return m_data;
+	}
+
+	std::size_t mapping::size() const
+	{
+		return m_size;
+	}
+
+	bool mapping::empty() const
+	{
+		return m_data == nullptr;
+	}
+}
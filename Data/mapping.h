@@ -0,0 +1,49 @@
+//
+//  mapping.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <cstddef>
+#include <string_view>
+
+// Mapping class is a thin read-only wrapper around the operating system memory mapping
+// (MapViewOfFile on Windows, mmap elsewhere). The whole file becomes a single contiguous
+// array of bytes, so records could be decoded in place without any intermediate stream buffer.
+// The class is movable but not copyable, mapping is released in destructor.
+//
+// Class properties:
+// - m_data  : pointer to the first mapped byte, nullptr if nothing is mapped;
+// - m_size  : size of the mapped file in bytes.
+//
+// Class behaviors:
+// - open()  : map the file at given path, returns false if file could not be opened or is empty;
+// - close() : unmap the file;
+// - data()  : return a pointer to the mapped bytes;
+// - size()  : return the size of the mapped file;
+// - empty() : check if anything is mapped.
+
+namespace ws::data
+{
+	class mapping
+	{
+	public:
+		mapping() = default;
+		mapping(const mapping &) = delete;
+		mapping(mapping &&) noexcept;
+		mapping & operator = (const mapping &) = delete;
+		mapping & operator = (mapping &&) noexcept;
+		~mapping();
+	public:
+		bool open(const std::string_view);
+		void close();
+		const std::byte * data() const;
+		std::size_t size() const;
+		bool empty() const;
+	private:
+		const std::byte * m_data {};
+		std::size_t m_size {};
+	};
+}
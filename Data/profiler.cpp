@@ -0,0 +1,156 @@
+//
+//  profiler.cpp
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#include <format>
+#include <algorithm>
+#include "profiler.h"
+#include "writer.h"
+
+namespace ws::data
+{
+	namespace
+	{
+		struct name
+		{
+			std::string_view key;
+			std::string_view title;
+		};
+
+		constexpr std::array<name, static_cast<std::size_t>(profiler::stage::COUNT)> stages
+		{{
+			{"walk", "Обход папок"},
+			{"parse", "Разбор файлов"},
+			{"cache", "Чтение кэша"},
+			{"analyze", "Анализ"},
+			{"allan", "Вариация Аллана"},
+			{"spectrum", "Спектральный анализ"},
+			{"format", "Форматирование"},
+			{"write", "Запись"},
+			{"save", "Сохранение анализа"},
+			{"aggregate", "Сводная статистика"},
+			{"render", "Вывод на экран"}
+		}};
+
+		constexpr std::array<name, static_cast<std::size_t>(profiler::counter::COUNT)> counters
+		{{
+			{"bytes_read", "Прочитано байт"},
+			{"rows_decoded", "Разобрано строк"},
+			{"files_loaded", "Загружено файлов"},
+			{"files_cached", "Файлов из кэша"},
+			{"files_skipped", "Файлов без изменений"},
+			{"files_failed", "Файлов с ошибками"},
+			{"records_skipped", "Пропущено записей"},
+			{"records_repaired", "Восстановлено записей"}
+		}};
+
+		// nearest rank: the smallest sample not less than given share of all samples
+		std::uint64_t percentile(std::vector<std::uint64_t> & values, double share)
+		{
+			const auto rank {static_cast<std::size_t>(share * static_cast<double>(values.size()) + 0.999999)};
+			const auto nth {values.begin() + static_cast<std::ptrdiff_t>(std::clamp<std::size_t>(rank, 1, values.size()) - 1)};
+			std::nth_element(values.begin(), nth, values.end());
+			return *nth;
+		}
+	}
+
+	profiler & profiler::instance()
+	{
+		static profiler profiler;
+		return profiler;
+	}
+
+	void profiler::record(stage stage, std::uint64_t nanoseconds)
+	{
+		samples & samples {m_stages[static_cast<std::size_t>(stage)]};
+		samples.calls.fetch_add(1, std::memory_order_relaxed);
+		samples.total.fetch_add(nanoseconds, std::memory_order_relaxed);
+		std::lock_guard<std::mutex> lock {samples.mutex};
+		samples.values.push_back(nanoseconds);
+	}
+
+	void profiler::add(counter counter, std::uint64_t value)
+	{
+		m_counters[static_cast<std::size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+	}
+
+	profiler::summary profiler::get(stage stage) const
+	{
+		const samples & samples {m_stages[static_cast<std::size_t>(stage)]};
+		summary summary {};
+		summary.calls = samples.calls.load(std::memory_order_relaxed);
+		summary.total = samples.total.load(std::memory_order_relaxed);
+		std::vector<std::uint64_t> values;
+		{
+			std::lock_guard<std::mutex> lock {samples.mutex};
+			values = samples.values;
+		}
+		if (values.empty()) { return summary; }
+		summary.max = *std::max_element(values.begin(), values.end());
+		summary.p99 = percentile(values, 0.99);
+		summary.p50 = percentile(values, 0.5);
+		return summary;
+	}
+
+	std::uint64_t profiler::get(counter counter) const
+	{
+		return m_counters[static_cast<std::size_t>(counter)].load(std::memory_order_relaxed);
+	}
+
+	void profiler::reset()
+	{
+		for (samples & samples : m_stages)
+		{
+			std::lock_guard<std::mutex> lock {samples.mutex};
+			samples.calls = 0;
+			samples.total = 0;
+			samples.values.clear();
+		}
+		for (auto & counter : m_counters)
+		{
+			counter = 0;
+		}
+	}
+
+	std::string profiler::report() const
+	{
+		std::string text {std::format("{:<20}{:>10}{:>14}{:>14}{:>14}{:>14}\n", "Этап", "Вызовов", "Всего, мс", "p50, мкс", "p99, мкс", "Макс., мкс")};
+		for (std::size_t i {}; i < stages.size(); ++i)
+		{
+			const summary summary {this->get(static_cast<stage>(i))};
+			text += std::format("{:<20}{:>10}{:>14.2f}{:>14.1f}{:>14.1f}{:>14.1f}\n", stages[i].title, summary.calls,
+								static_cast<double>(summary.total) / 1e6, static_cast<double>(summary.p50) / 1e3,
+								static_cast<double>(summary.p99) / 1e3, static_cast<double>(summary.max) / 1e3);
+		}
+		text += '\n';
+		for (std::size_t i {}; i < counters.size(); ++i)
+		{
+			text += std::format("{:<22}{:>14}\n", counters[i].title, this->get(static_cast<counter>(i)));
+		}
+		return text;
+	}
+
+	bool profiler::dump(const std::string_view filename) const
+	{
+		writer fout;
+		if (!fout.open(filename)) { return false; }
+		fout.print("{{\n  \"stages\": {{\n");
+		for (std::size_t i {}; i < stages.size(); ++i)
+		{
+			const summary summary {this->get(static_cast<stage>(i))};
+			fout.print("    \"{}\": {{\"calls\": {}, \"total_ns\": {}, \"p50_ns\": {}, \"p99_ns\": {}, \"max_ns\": {}}}{}\n",
+					   stages[i].key, summary.calls, summary.total, summary.p50, summary.p99, summary.max,
+					   i + 1 < stages.size() ? "," : "");
+		}
+		fout.print("  }},\n  \"counters\": {{\n");
+		for (std::size_t i {}; i < counters.size(); ++i)
+		{
+			fout.print("    \"{}\": {}{}\n", counters[i].key, this->get(static_cast<counter>(i)), i + 1 < counters.size() ? "," : "");
+		}
+		fout.print("  }}\n}}\n");
+		return fout.close();
+	}
+}
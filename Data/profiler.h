@@ -0,0 +1,138 @@
+//
+//  profiler.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+// Profiler class collects time spent in every stage of the hot paths (walking folders, parsing files, reading
+// the cache, analysis, Allan deviation and spectra, conversion, saving results, collection statistics and drawing the screen) and counters
+// of processed data.
+// Stages are timed by WS_PROFILE(stage) macro, it puts a scoped timer that measures the rest of the enclosing
+// block; counters are added by WS_COUNT(counter, value) macro. Every timed block is one sample, so a stage
+// timed once per file gives time per file, its median (p50) and 99th percentile (p99) are found on request.
+// Calls are safe from several threads at once: totals are atomic, samples are appended under a mutex once
+// per block, never per row.
+//
+// Profiling is compiled in only if WS_PROFILING is defined (CMake option BINS_PROFILING, off by default), else
+// both macros expand to nothing and hot paths carry no trace of it; 'enabled' tells which build it is.
+//
+// Class properties:
+// - m_stages  : calls, total and samples of nanoseconds of every stage;
+// - m_counters: value of every counter.
+//
+// Class behaviors:
+// - instance(): return the single profiler of the program;
+// - record()  : add a sample of given nanoseconds to the stage;
+// - add()     : add given value to the counter;
+// - get()     : return summary of the stage or value of the counter;
+// - reset()   : forget everything collected so far;
+// - report()  : return a table of all stages and counters for the console;
+// - dump()    : write all stages and counters to a .json file, returns false if file could not be written.
+
+namespace ws::data
+{
+	class profiler
+	{
+	public:
+		enum class stage : uint32_t
+		{
+			WALK,
+			PARSE,
+			CACHE,
+			ANALYZE,
+			ALLAN,
+			SPECTRUM,
+			FORMAT,
+			WRITE,
+			SAVE,
+			AGGREGATE,
+			RENDER,
+			COUNT
+		};
+		enum class counter : uint32_t
+		{
+			BYTES_READ,
+			ROWS_DECODED,
+			FILES_LOADED,
+			FILES_CACHED,
+			FILES_SKIPPED,
+			FILES_FAILED,
+			RECORDS_SKIPPED,
+			RECORDS_REPAIRED,
+			COUNT
+		};
+		struct summary
+		{
+			std::uint64_t calls;
+			std::uint64_t total;
+			std::uint64_t p50;
+			std::uint64_t p99;
+			std::uint64_t max;
+		};
+		// measures time from its construction to the end of the enclosing block
+		class timer
+		{
+		public:
+			explicit timer(stage stage) : m_stage(stage), m_begin(std::chrono::steady_clock::now()) {}
+			timer(const timer &) = delete;
+			timer & operator = (const timer &) = delete;
+			~timer()
+			{
+				const auto elapsed {std::chrono::steady_clock::now() - m_begin};
+				profiler::instance().record(m_stage, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+			}
+		private:
+			stage m_stage;
+			std::chrono::steady_clock::time_point m_begin;
+		};
+	public:
+	#if defined(WS_PROFILING)
+		static constexpr bool enabled {true};
+	#else
+		static constexpr bool enabled {false};
+	#endif
+	public:
+		static profiler & instance();
+		void record(stage, std::uint64_t);
+		void add(counter, std::uint64_t);
+		summary get(stage) const;
+		std::uint64_t get(counter) const;
+		void reset();
+		std::string report() const;
+		bool dump(const std::string_view) const;
+	private:
+		profiler() = default;
+	private:
+		struct samples
+		{
+			std::atomic<std::uint64_t> calls;
+			std::atomic<std::uint64_t> total;
+			mutable std::mutex mutex;
+			std::vector<std::uint64_t> values;
+		};
+	private:
+		std::array<samples, static_cast<std::size_t>(stage::COUNT)> m_stages {};
+		std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(counter::COUNT)> m_counters {};
+	};
+}
+
+#if defined(WS_PROFILING)
+#define WS_PROFILE_NAME(line) ws_profile_##line
+#define WS_PROFILE_LINE(line) WS_PROFILE_NAME(line)
+#define WS_PROFILE(name) const ws::data::profiler::timer WS_PROFILE_LINE(__LINE__) {ws::data::profiler::stage::name}
+#define WS_COUNT(name, value) ws::data::profiler::instance().add(ws::data::profiler::counter::name, static_cast<std::uint64_t>(value))
+#else
+#define WS_PROFILE(name)
+#define WS_COUNT(name, value)
+#endif
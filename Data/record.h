@@ -0,0 +1,240 @@
+//
+//  record.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <span>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "mapping.h"
+#include "schema.h"
+
+// Raw access to .dat records without decoding them into 'row' struct (see 'row.h'). Offsets of fields
+// inside a single 301 bytes long record are taken from the schema (see 'schema.h'). 'Record' is a
+// non-owning pointer to one record and reads a single field on demand or decodes the whole record.
+// 'Record_view' maps the whole file (see 'mapping.h') and gives read-only indexed access to its records,
+// so tools that need only a few fields never copy the rest. Records are found by their 'count' with seek(),
+// which reads 'count' of a few records, or of a logarithmic number of them if some record was dropped (see
+// below), so neither loaders nor analysis decode the beginning of a recording.
+//
+// Record behaviors:
+// - get<T>()  : read field of type T at given offset, 'width' bytes long (2 or 1 byte wide fields are
+//               zero extended), or field of given member of 'row', e.g. get<&row::gyro_X>();
+// - decode()  : read all fields of the record, or only fields of given projection, into given row;
+// - encode()  : write all fields of given row to 'schema::size' bytes at given address, 'crc8' is written as is;
+// - data()    : return a pointer to the first byte of the record.
+//
+// Namespace behaviors:
+// - crc8()    : return checksum of given bytes as the unit computes it for field 'crc8' of a record over
+//               all bytes before that field (polynomial 0x07, initial value 0), eight bytes at a time;
+// - crc8_fold(): fold the next eight bytes into the checksum, for kernels that check several records at once;
+// - seek()    : return index of the first of given number of records whose 'count' is not less than given
+//               value, read by given function, or the number of records if there is none. The unit adds one
+//               to 'count' every record, so the index is first guessed from the first count; if the guess misses,
+//               the index is found by binary search. Both check the same rule: the record found and the one
+//               before it bracket the value, and every pair of counts read leaves room for the records between
+//               them, as strictly increasing counts do. A count that breaks the rule (a broken or shifted record)
+//               or a last count less than the first one (the 2 bytes wide 'count' wrapped after 65535) means
+//               counts are not increasing throughout, then records are scanned one by one.
+//
+// Record_view properties:
+// - m_mapping : mapped .dat file.
+//
+// Record_view behaviors:
+// - open()    : map the .dat file, returns false if file could not be mapped;
+// - size()    : number of complete records in the file, incomplete tail is ignored;
+// - operator[]: return record with given index, index is not checked;
+// - seek()    : return index of the first record whose 'count' is not less than given value (see above);
+// - find()    : return index of the record with given 'count', size() if there is none;
+// - bytes()   : return all mapped bytes, the incomplete tail included.
+
+namespace ws::data
+{
+	class record
+	{
+	public:
+		explicit record(const std::byte * data) : m_data(data) {}
+	public:
+		template <typename T>
+		T get(std::size_t offset, std::size_t width = sizeof(T)) const
+		{
+			// records are not aligned, so copy bytes instead of casting the pointer
+			T value {};
+			std::memcpy(&value, m_data + offset, width);
+			return value;
+		}
+		template <auto member>
+		auto get() const
+		{
+			constexpr auto field {schema::find<member>()};
+			return this->get<typename std::remove_cvref_t<decltype(field)>::type>(field.offset, field.width);
+		}
+		void decode(row & row) const
+		{
+			schema::for_each([this, &row](const auto & field)
+			{
+				row.*field.member = this->get<typename std::remove_cvref_t<decltype(field)>::type>(field.offset, field.width);
+			});
+		}
+		void decode(row & row, const projection & projection) const
+		{
+			// a full projection needs no checks per field
+			if (projection.all())
+			{
+				this->decode(row);
+				return;
+			}
+			// fields out of projection are skipped, they are never read
+			schema::enumerate([this, &row, &projection](const auto & field, std::size_t i)
+			{
+				if (projection[i])
+				{
+					row.*field.member = this->get<typename std::remove_cvref_t<decltype(field)>::type>(field.offset, field.width);
+				}
+			});
+		}
+		static void encode(const row & row, std::byte * data)
+		{
+			schema::for_each([&row, data](const auto & field)
+			{
+				// little endian, so a narrow field keeps the low bytes of the value
+				const auto value {row.*field.member};
+				std::memcpy(data + field.offset, &value, field.width);
+			});
+		}
+		const std::byte * data() const { return m_data; }
+	private:
+		const std::byte * m_data;
+	};
+
+	// remainders of every byte value followed by 0 to 7 zero bytes, table[0] is the plain bytewise table, so
+	// eight bytes are folded at once with eight independent lookups instead of a chain of eight (slicing by 8)
+	inline constexpr std::array<std::array<uint8_t, 256>, 8> crc8_table {[]
+	{
+		std::array<std::array<uint8_t, 256>, 8> table {};
+		for (std::size_t i {}; i < 256; ++i)
+		{
+			uint8_t crc {static_cast<uint8_t>(i)};
+			for (int bit {}; bit < 8; ++bit)
+			{
+				crc = static_cast<uint8_t>((crc & 0x80) != 0 ? (crc << 1) ^ 0x07 : crc << 1);
+			}
+			table[0][i] = crc;
+		}
+		for (std::size_t k {1}; k < table.size(); ++k)
+		{
+			for (std::size_t i {}; i < 256; ++i)
+			{
+				table[k][i] = table[0][table[k - 1][i]];
+			}
+		}
+		return table;
+	}()};
+
+	// the checksum of the next eight bytes, the first of them is the lowest byte of 'word'
+	inline uint8_t crc8_fold(uint8_t crc, uint64_t word)
+	{
+		return static_cast<uint8_t>(crc8_table[7][static_cast<uint8_t>(word ^ crc)] ^ crc8_table[6][static_cast<uint8_t>(word >> 8)] ^
+									crc8_table[5][static_cast<uint8_t>(word >> 16)] ^ crc8_table[4][static_cast<uint8_t>(word >> 24)] ^
+									crc8_table[3][static_cast<uint8_t>(word >> 32)] ^ crc8_table[2][static_cast<uint8_t>(word >> 40)] ^
+									crc8_table[1][static_cast<uint8_t>(word >> 48)] ^ crc8_table[0][static_cast<uint8_t>(word >> 56)]);
+	}
+
+	inline uint8_t crc8(const std::byte * data, std::size_t size)
+	{
+		uint8_t crc {};
+		std::size_t i {};
+		for (; i + 8 <= size; i += 8)
+		{
+			// little endian, so the first byte is the lowest one
+			uint64_t word {};
+			std::memcpy(&word, data + i, sizeof(word));
+			crc = crc8_fold(crc, word);
+		}
+		for (; i < size; ++i)
+		{
+			crc = crc8_table[0][crc ^ static_cast<uint8_t>(data[i])];
+		}
+		return crc;
+	}
+
+	template <typename F>
+	std::size_t seek(std::size_t size, uint32_t count, const F & count_at)
+	{
+		if (!size) { return 0; }
+		const uint32_t first {count_at(0)};
+		if (first >= count) { return 0; }
+		auto scan {[size, count, &count_at]
+		{
+			for (std::size_t i {}; i < size; ++i)
+			{
+				if (count_at(i) >= count) { return i; }
+			}
+			return size;
+		}};
+		// counts only grow, by one at least, so the later of two records has room for every record between them
+		auto room {[](std::size_t low, uint32_t low_count, std::size_t high, uint32_t high_count)
+		{
+			return high_count >= low_count && high_count - low_count >= high - low;
+		}};
+		// no record was dropped before the one sought, so its index is known at once
+		const std::size_t guess {count - first};
+		if (guess < size)
+		{
+			const uint32_t value {count_at(guess)};
+			const uint32_t previous {count_at(guess - 1)};
+			if (value == count && previous < count && room(0, first, guess - 1, previous)) { return guess; }
+		}
+		// the first count is less and the last is not, so the record lies between them
+		std::size_t low {}, high {size - 1};
+		uint32_t low_count {first}, high_count {count_at(high)};
+		// the count wrapped to zero somewhere, so it is not sorted
+		if (high_count < first) { return scan(); }
+		bool monotonic {room(low, low_count, high, high_count)};
+		if (monotonic && high_count < count) { return size; }
+		while (monotonic && high - low > 1)
+		{
+			const std::size_t middle {low + (high - low) / 2};
+			const uint32_t value {count_at(middle)};
+			monotonic = room(low, low_count, middle, value) && room(middle, value, high, high_count);
+			if (value < count)
+			{
+				low = middle;
+				low_count = value;
+			}
+			else
+			{
+				high = middle;
+				high_count = value;
+			}
+		}
+		return monotonic ? high : scan();
+	}
+
+	class record_view
+	{
+	public:
+		record_view() = default;
+	public:
+		bool open(const std::string_view filename) { return m_mapping.open(filename); }
+		std::size_t size() const { return m_mapping.size() / schema::size; }
+		record operator [] (std::size_t index) const { return record(m_mapping.data() + index * schema::size); }
+		std::size_t seek(uint32_t count) const
+		{
+			return ws::data::seek(this->size(), count, [this](std::size_t index) { return (*this)[index].get<&row::count>(); });
+		}
+		std::size_t find(uint32_t count) const
+		{
+			const std::size_t index {this->seek(count)};
+			return index < this->size() && (*this)[index].get<&row::count>() == count ? index : this->size();
+		}
+		std::span<const std::byte> bytes() const { return std::span<const std::byte>(m_mapping.data(), m_mapping.size()); }
+	private:
+		mapping m_mapping;
+	};
+}
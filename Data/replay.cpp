@@ -0,0 +1,108 @@
+//
+//  replay.cpp
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <format>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+#include "record.h"
+
+// Stand-in for a BINS unit on the test bench: records of recorded .dat files are written again one by one
+// at the sample rate of the unit (1 Hz by default), so live analysis (see file_collection::follow()) could be
+// tried without the unit. Every record is flushed as soon as it is written. The output could be a file, it is
+// created anew, or a named pipe made with 'mkfifo', then writing waits until the pipe is opened for reading.
+// If the source is a folder, its .dat files are replayed one after another in name order, each to the file of
+// the same name in the output folder.
+//
+// Usage: BINS_replay <source .dat file or folder> <output file, pipe or folder> [records per second]
+
+namespace
+{
+	void print(const std::string_view string)
+	{
+		fputs(std::string(string).c_str(), stdout);
+		fflush(stdout);
+	}
+
+	bool replay(const std::filesystem::path & source, const std::filesystem::path & output, double rate)
+	{
+		ws::data::record_view view;
+		if (!view.open(source.string()))
+		{
+			print(std::format("Could not open \"{}\"\n", source.string()));
+			return false;
+		}
+		std::ofstream fout {output, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc};
+		if (!fout.is_open())
+		{
+			print(std::format("Could not open \"{}\"\n", output.string()));
+			return false;
+		}
+		print(std::format("\"{}\" -> \"{}\", {} records at {} Hz\n", source.filename().string(), output.string(), view.size(), rate));
+		const auto period {std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / rate))};
+		// every record is due at its own time from the start, so delays do not add up
+		const auto start {std::chrono::steady_clock::now()};
+		for (std::size_t i {}; i < view.size(); ++i)
+		{
+			std::this_thread::sleep_until(start + period * static_cast<long long>(i));
+			fout.write(reinterpret_cast<const char *>(view[i].data()), ws::data::schema::size);
+			fout.flush();
+			if (!fout)
+			{
+				print(std::format("Could not write \"{}\"\n", output.string()));
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char * argv[])
+{
+	if (argc < 3)
+	{
+		print("Usage: BINS_replay <source .dat file or folder> <output file, pipe or folder> [records per second]\n");
+		return 1;
+	}
+	const std::filesystem::path source {argv[1]};
+	const std::filesystem::path output {argv[2]};
+	const double rate {argc > 3 ? std::stod(argv[3]) : 1.0};
+	if (!(rate > 0.0))
+	{
+		print("Rate must be positive\n");
+		return 1;
+	}
+	if (!std::filesystem::is_directory(source))
+	{
+		return replay(source, output, rate) ? 0 : 1;
+	}
+	std::vector<std::filesystem::path> files;
+	for (const auto & entry : std::filesystem::directory_iterator(source))
+	{
+		if (entry.is_regular_file() && entry.path().extension() == ".dat")
+		{
+			files.push_back(entry.path());
+		}
+	}
+	std::sort(files.begin(), files.end());
+	if (files.empty())
+	{
+		print(std::format("No .dat files in \"{}\"\n", source.string()));
+		return 1;
+	}
+	std::filesystem::create_directories(output);
+	for (const auto & file : files)
+	{
+		if (!replay(file, output / file.filename(), rate)) { return 1; }
+	}
+	return 0;
+}
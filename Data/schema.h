@@ -0,0 +1,285 @@
+//
+//  schema.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <tuple>
+#include <bitset>
+#include <utility>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include "row.h"
+
+// Schema of a single .dat record, the only place where the record layout is written down. Every field
+// of the record is described once: its name, the member of 'row' (see 'row.h') it is stored to, its
+// offset and width on disk and its precision in .txt files. Fields are kept in a std::tuple in on-disk
+// order, so loops over them are unrolled at compile time and every offset is a constant. All decoders
+// and encoders of .dat and .txt files are built on for_each() and all_of().
+//
+// Field properties:
+// - name     : name of the field, same as the name of the member;
+// - member   : pointer to the member of 'row';
+// - offset   : offset of the field from the beginning of the record in bytes;
+// - width    : width of the field on disk in bytes, 2 and 1 byte wide fields are zero extended;
+// - precision: digits after the point in .txt files, -1 means the shortest exact form.
+//
+// Schema behaviors:
+// - for_each(): call given function with every field in on-disk order;
+// - enumerate(): same as for_each(), but the position of the field is passed as the second argument;
+// - all_of()  : same as for_each(), but stops at the first field the function returns false for,
+//               all_of_enumerated() passes the position too;
+// - find()    : return the field of given member of 'row', e.g. find<&row::count>();
+// - position(): return position of the field of given member in on-disk order;
+// - select()  : return projection of given members, used to load only the fields that are needed;
+// - all()     : return projection of all fields.
+
+namespace ws::data
+{
+	template <typename T>
+	struct field
+	{
+		using type = T;
+		std::string_view name;
+		T row:: * member;
+		std::size_t offset;
+		std::size_t width;
+		int precision;
+	};
+
+	namespace schema
+	{
+		// lenght of a single record in bytes
+		constexpr std::size_t size {301};
+
+		inline constexpr std::tuple fields
+		{
+			field<uint32_t> {"count", &row::count, 0, 2, -1},
+			field<uint32_t> {"mode", &row::mode, 2, 2, -1},
+			field<float> {"system_time", &row::system_time, 4, 4, -1},
+			field<float> {"mode_time", &row::mode_time, 8, 4, -1},
+			field<float> {"pitch", &row::pitch, 12, 4, 5},
+			field<float> {"roll", &row::roll, 16, 4, 5},
+			field<float> {"heading", &row::heading, 20, 4, 2},
+			field<float> {"azimuth", &row::azimuth, 24, 4, 5},
+			field<float> {"thdg", &row::thdg, 28, 4, 5},
+			field<float> {"latitude", &row::latitude, 32, 4, 5},
+			field<float> {"longtitude", &row::longtitude, 36, 4, 5},
+			field<float> {"H", &row::H, 40, 4, 2},
+			field<float> {"Ve", &row::Ve, 44, 4, 5},
+			field<float> {"Vn", &row::Vn, 48, 4, 5},
+			field<float> {"Vu", &row::Vu, 52, 4, 5},
+			field<float> {"dAt_X", &row::dAt_X, 56, 4, 5},
+			field<float> {"dAt_Y", &row::dAt_Y, 60, 4, 5},
+			field<float> {"dAt_Z", &row::dAt_Z, 64, 4, 5},
+			field<float> {"dVt_X", &row::dVt_X, 68, 4, 5},
+			field<float> {"dVt_Y", &row::dVt_Y, 72, 4, 5},
+			field<float> {"dVt_Z", &row::dVt_Z, 76, 4, 5},
+			field<float> {"gyro_X", &row::gyro_X, 80, 4, 2},
+			field<float> {"gyro_Y", &row::gyro_Y, 84, 4, 2},
+			field<float> {"gyro_Z", &row::gyro_Z, 88, 4, 2},
+			field<float> {"acc_X", &row::acc_X, 92, 4, 5},
+			field<float> {"acc_Y", &row::acc_Y, 96, 4, 5},
+			field<float> {"acc_Z", &row::acc_Z, 100, 4, 5},
+			field<float> {"U_cplc_X", &row::U_cplc_X, 104, 4, 2},
+			field<float> {"U_cplc_Y", &row::U_cplc_Y, 108, 4, 2},
+			field<float> {"U_cplc_Z", &row::U_cplc_Z, 112, 4, 2},
+			field<float> {"U_hfo_X", &row::U_hfo_X, 116, 4, 2},
+			field<float> {"U_hfo_Y", &row::U_hfo_Y, 120, 4, 2},
+			field<float> {"U_hfo_Z", &row::U_hfo_Z, 124, 4, 2},
+			field<float> {"F_out_X", &row::F_out_X, 128, 4, 1},
+			field<float> {"F_out_Y", &row::F_out_Y, 132, 4, 1},
+			field<float> {"F_out_Z", &row::F_out_Z, 136, 4, 1},
+			field<float> {"F_dith_X", &row::F_dith_X, 140, 4, 1},
+			field<float> {"F_dith_Y", &row::F_dith_Y, 144, 4, 1},
+			field<float> {"F_dith_Z", &row::F_dith_Z, 148, 4, 1},
+			field<int> {"gyro_X_temperature", &row::gyro_X_temperature, 152, 4, -1},
+			field<int> {"gyro_Y_temperature", &row::gyro_Y_temperature, 156, 4, -1},
+			field<int> {"gyro_Z_temperature", &row::gyro_Z_temperature, 160, 4, -1},
+			field<uint32_t> {"acc_X_temperature", &row::acc_X_temperature, 164, 4, -1},
+			field<uint32_t> {"acc_Y_temperature", &row::acc_Y_temperature, 168, 4, -1},
+			field<uint32_t> {"acc_Z_temperature", &row::acc_Z_temperature, 172, 4, -1},
+			field<uint32_t> {"dpb_X_temperature", &row::dpb_X_temperature, 176, 4, -1},
+			field<uint32_t> {"dpb_Y_temperature", &row::dpb_Y_temperature, 180, 4, -1},
+			field<uint32_t> {"dpb_Z_temperature", &row::dpb_Z_temperature, 184, 4, -1},
+			field<float> {"drift_X", &row::drift_X, 188, 4, 0},
+			field<float> {"drift_Y", &row::drift_Y, 192, 4, 0},
+			field<float> {"drift_Z", &row::drift_Z, 196, 4, 0},
+			field<uint32_t> {"faults", &row::faults, 200, 2, -1},
+			field<float> {"D12", &row::D12, 202, 4, 2},
+			field<float> {"D13", &row::D13, 206, 4, 2},
+			field<float> {"D21", &row::D21, 210, 4, 2},
+			field<float> {"D23", &row::D23, 214, 4, 2},
+			field<float> {"D31", &row::D31, 218, 4, 2},
+			field<float> {"D32", &row::D32, 222, 4, 2},
+			field<float> {"Mg1", &row::Mg1, 226, 4, 5},
+			field<float> {"Mg2", &row::Mg2, 230, 4, 5},
+			field<float> {"Mg3", &row::Mg3, 234, 4, 5},
+			field<float> {"Wo1", &row::Wo1, 238, 4, 5},
+			field<float> {"Wo2", &row::Wo2, 242, 4, 5},
+			field<float> {"Wo3", &row::Wo3, 246, 4, 5},
+			field<float> {"E12", &row::E12, 250, 4, 5},
+			field<float> {"E13", &row::E13, 254, 4, 5},
+			field<float> {"E21", &row::E21, 258, 4, 5},
+			field<float> {"E23", &row::E23, 262, 4, 5},
+			field<float> {"E31", &row::E31, 266, 4, 5},
+			field<float> {"E32", &row::E32, 270, 4, 5},
+			field<float> {"Ma1", &row::Ma1, 274, 4, 1},
+			field<float> {"Ma2", &row::Ma2, 278, 4, 1},
+			field<float> {"Ma3", &row::Ma3, 282, 4, 5},
+			field<float> {"Ao1", &row::Ao1, 286, 4, 5},
+			field<float> {"Ao2", &row::Ao2, 290, 4, 5},
+			field<float> {"Ao3", &row::Ao3, 294, 4, 5},
+			field<uint32_t> {"reserve", &row::reserve, 298, 1, -1},
+			field<uint32_t> {"crc8", &row::crc8, 299, 1, -1},
+			field<uint32_t> {"error", &row::error, 300, 1, -1}
+		};
+
+		// number of fields in a single record
+		constexpr std::size_t count {std::tuple_size_v<std::remove_const_t<decltype(fields)>>};
+
+		// every field is passed as std::get<I>(fields), a reference to a constant, so after the call is
+		// inlined its offset and width are known to the compiler
+		template <typename F, std::size_t... I>
+		constexpr void for_each(F && function, std::index_sequence<I...>)
+		{
+			(function(std::get<I>(fields)), ...);
+		}
+
+		template <typename F, std::size_t... I>
+		constexpr bool all_of(F && function, std::index_sequence<I...>)
+		{
+			return (function(std::get<I>(fields)) && ...);
+		}
+
+		// same as for_each(), but the position of the field is passed too, as std::integral_constant
+		template <typename F, std::size_t... I>
+		constexpr void enumerate(F && function, std::index_sequence<I...>)
+		{
+			(function(std::get<I>(fields), std::integral_constant<std::size_t, I> {}), ...);
+		}
+
+		template <typename F, std::size_t... I>
+		constexpr bool all_of_enumerated(F && function, std::index_sequence<I...>)
+		{
+			return (function(std::get<I>(fields), std::integral_constant<std::size_t, I> {}) && ...);
+		}
+
+		template <typename F>
+		constexpr void for_each(F && function)
+		{
+			for_each(function, std::make_index_sequence<count> {});
+		}
+
+		template <typename F>
+		constexpr void enumerate(F && function)
+		{
+			enumerate(function, std::make_index_sequence<count> {});
+		}
+
+		template <typename F>
+		constexpr bool all_of(F && function)
+		{
+			return all_of(function, std::make_index_sequence<count> {});
+		}
+
+		template <typename F>
+		constexpr bool all_of_enumerated(F && function)
+		{
+			return all_of_enumerated(function, std::make_index_sequence<count> {});
+		}
+
+		// field of given member of 'row'
+		template <auto member>
+		constexpr auto find()
+		{
+			using type = std::remove_cvref_t<decltype(std::declval<row>().*member)>;
+			field<type> result {};
+			for_each([&result](const auto & field)
+			{
+				if constexpr (std::is_same_v<decltype(field.member), type row:: *>)
+				{
+					if (field.member == member) { result = field; }
+				}
+			});
+			return result;
+		}
+
+		// position of the field of given member in on-disk order, 'count' if there is no such field
+		template <typename T>
+		constexpr std::size_t position(T row:: * member)
+		{
+			std::size_t result {count};
+			enumerate([&result, member](const auto & field, std::size_t i)
+			{
+				if constexpr (std::is_same_v<decltype(field.member), T row:: *>)
+				{
+					if (field.member == member) { result = i; }
+				}
+			});
+			return result;
+		}
+
+		// fields follow each other without gaps and every field fits into its member
+		constexpr bool contiguous()
+		{
+			std::size_t offset {};
+			bool result {true};
+			for_each([&offset, &result](const auto & field)
+			{
+				using type = typename std::remove_cvref_t<decltype(field)>::type;
+				result = result && field.offset == offset && field.width > 0 && field.width <= sizeof(type);
+				offset += field.width;
+			});
+			return result && offset == size;
+		}
+
+		// every member of 'row' is described exactly once
+		constexpr bool unique()
+		{
+			std::size_t bytes {};
+			bool result {true};
+			for_each([&bytes, &result](const auto & lhs)
+			{
+				bytes += sizeof(typename std::remove_cvref_t<decltype(lhs)>::type);
+				std::size_t same {};
+				for_each([&lhs, &same](const auto & rhs)
+				{
+					if constexpr (std::is_same_v<decltype(lhs.member), decltype(rhs.member)>)
+					{
+						same += lhs.member == rhs.member ? 1 : 0;
+					}
+				});
+				result = result && same == 1;
+			});
+			return result && bytes == sizeof(row);
+		}
+
+		static_assert(contiguous(), "fields of the record must add up to 301 bytes without gaps");
+		static_assert(unique(), "every member of the row must be read from exactly one field");
+	}
+
+	// set of fields to load, bit 'i' stands for the field at position 'i' in on-disk order
+	using projection = std::bitset<schema::count>;
+
+	namespace schema
+	{
+		// projection of given members only, e.g. select(&row::count, &row::gyro_X)
+		template <typename... T>
+		projection select(T row:: * ... members)
+		{
+			projection projection {};
+			(projection.set(position(members)), ...);
+			return projection;
+		}
+
+		// projection of all fields
+		inline projection all()
+		{
+			return projection {}.set();
+		}
+	}
+}
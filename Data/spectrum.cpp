@@ -0,0 +1,357 @@
+//
+//  spectrum.cpp
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#include <map>
+#include <bit>
+#include <cmath>
+#include <mutex>
+#include <memory>
+#include <numbers>
+#include <algorithm>
+#include "spectrum.h"
+#include "thread_pool.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define WS_SPECTRUM_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+// MSVC compiles intrinsics of any instruction set without extra flags
+#define WS_TARGET(name)
+#else
+// GCC and Clang need the instruction set enabled for a single function
+#define WS_TARGET(name) __attribute__((target(name)))
+#endif
+#endif
+
+namespace ws::data::spectrum
+{
+	namespace
+	{
+		// every block of '2 * half' samples: a = x[k], b = x[k + half] * w[k], x[k] = a + b, x[k + half] = a - b
+		void scalar(float * real, float * imaginary, std::size_t size, std::size_t half, const float * w_real, const float * w_imaginary)
+		{
+			for (std::size_t start {}; start < size; start += 2 * half)
+			{
+				float * a_real {real + start};
+				float * a_imaginary {imaginary + start};
+				float * b_real {a_real + half};
+				float * b_imaginary {a_imaginary + half};
+				for (std::size_t k {}; k < half; ++k)
+				{
+					const float t_real {b_real[k] * w_real[k] - b_imaginary[k] * w_imaginary[k]};
+					const float t_imaginary {b_real[k] * w_imaginary[k] + b_imaginary[k] * w_real[k]};
+					b_real[k] = a_real[k] - t_real;
+					b_imaginary[k] = a_imaginary[k] - t_imaginary;
+					a_real[k] += t_real;
+					a_imaginary[k] += t_imaginary;
+				}
+			}
+		}
+
+	#if defined(WS_SPECTRUM_X86)
+		WS_TARGET("sse2")
+		void sse(float * real, float * imaginary, std::size_t size, std::size_t half, const float * w_real, const float * w_imaginary)
+		{
+			for (std::size_t start {}; start < size; start += 2 * half)
+			{
+				float * a_real {real + start};
+				float * a_imaginary {imaginary + start};
+				float * b_real {a_real + half};
+				float * b_imaginary {a_imaginary + half};
+				for (std::size_t k {}; k < half; k += 4)
+				{
+					const __m128 wr {_mm_loadu_ps(w_real + k)};
+					const __m128 wi {_mm_loadu_ps(w_imaginary + k)};
+					const __m128 br {_mm_loadu_ps(b_real + k)};
+					const __m128 bi {_mm_loadu_ps(b_imaginary + k)};
+					const __m128 tr {_mm_sub_ps(_mm_mul_ps(br, wr), _mm_mul_ps(bi, wi))};
+					const __m128 ti {_mm_add_ps(_mm_mul_ps(br, wi), _mm_mul_ps(bi, wr))};
+					const __m128 ar {_mm_loadu_ps(a_real + k)};
+					const __m128 ai {_mm_loadu_ps(a_imaginary + k)};
+					_mm_storeu_ps(a_real + k, _mm_add_ps(ar, tr));
+					_mm_storeu_ps(a_imaginary + k, _mm_add_ps(ai, ti));
+					_mm_storeu_ps(b_real + k, _mm_sub_ps(ar, tr));
+					_mm_storeu_ps(b_imaginary + k, _mm_sub_ps(ai, ti));
+				}
+			}
+		}
+
+		WS_TARGET("avx2")
+		void avx2(float * real, float * imaginary, std::size_t size, std::size_t half, const float * w_real, const float * w_imaginary)
+		{
+			for (std::size_t start {}; start < size; start += 2 * half)
+			{
+				float * a_real {real + start};
+				float * a_imaginary {imaginary + start};
+				float * b_real {a_real + half};
+				float * b_imaginary {a_imaginary + half};
+				for (std::size_t k {}; k < half; k += 8)
+				{
+					const __m256 wr {_mm256_loadu_ps(w_real + k)};
+					const __m256 wi {_mm256_loadu_ps(w_imaginary + k)};
+					const __m256 br {_mm256_loadu_ps(b_real + k)};
+					const __m256 bi {_mm256_loadu_ps(b_imaginary + k)};
+					const __m256 tr {_mm256_sub_ps(_mm256_mul_ps(br, wr), _mm256_mul_ps(bi, wi))};
+					const __m256 ti {_mm256_add_ps(_mm256_mul_ps(br, wi), _mm256_mul_ps(bi, wr))};
+					const __m256 ar {_mm256_loadu_ps(a_real + k)};
+					const __m256 ai {_mm256_loadu_ps(a_imaginary + k)};
+					_mm256_storeu_ps(a_real + k, _mm256_add_ps(ar, tr));
+					_mm256_storeu_ps(a_imaginary + k, _mm256_add_ps(ai, ti));
+					_mm256_storeu_ps(b_real + k, _mm256_sub_ps(ar, tr));
+					_mm256_storeu_ps(b_imaginary + k, _mm256_sub_ps(ai, ti));
+				}
+			}
+		}
+	#endif
+
+		using kernel = void (*)(float *, float *, std::size_t, std::size_t, const float *, const float *);
+
+		// the widest kernel the stage fills
+		kernel select(statistics::instruction_set set, std::size_t half)
+		{
+		#if defined(WS_SPECTRUM_X86)
+			if (set == statistics::instruction_set::AVX2 && half >= 8) { return &avx2; }
+			if (set >= statistics::instruction_set::SSE && half >= 4) { return &sse; }
+		#endif
+			return &scalar;
+		}
+
+		// samples of a segment of a column, every segment starts half a segment after the previous one
+		struct layout
+		{
+			std::size_t length;
+			std::size_t segments;
+		};
+
+		layout cut(std::size_t samples)
+		{
+			if (samples < shortest) { return {}; }
+			const std::size_t length {std::min(segment, std::bit_floor(samples))};
+			return {length, (samples - length) / (length / 2) + 1};
+		}
+
+		// periodic Hann window of given length, computed once per program like the transforms
+		const std::vector<float> & hann(std::size_t length)
+		{
+			static std::mutex mutex;
+			static std::map<std::size_t, std::vector<float>> windows;
+			std::lock_guard<std::mutex> lock {mutex};
+			std::vector<float> & window {windows[length]};
+			if (window.empty())
+			{
+				window.resize(length);
+				for (std::size_t i {}; i < length; ++i)
+				{
+					window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * std::numbers::pi * static_cast<double>(i) / static_cast<double>(length)));
+				}
+			}
+			return window;
+		}
+
+		// squared magnitudes of segments [first, last) of a column summed bin by bin
+		std::vector<double> accumulate(std::span<const float> column, std::size_t length, std::size_t first, std::size_t last,
+									   statistics::instruction_set set)
+		{
+			const fft & fft {fft::get(length)};
+			const std::vector<float> & window {hann(length)};
+			auto load {[&column, &window, length](std::size_t index, float * into)
+			{
+				const float * data {column.data() + index * (length / 2)};
+				// a segment is at least 16 samples long and a power of two
+				double sums[4] {};
+				for (std::size_t i {}; i < length; i += 4)
+				{
+					for (std::size_t lane {}; lane < 4; ++lane) { sums[lane] += data[i + lane]; }
+				}
+				const auto shift {static_cast<float>((sums[0] + sums[1] + sums[2] + sums[3]) / static_cast<double>(length))};
+				for (std::size_t i {}; i < length; ++i) { into[i] = (data[i] - shift) * window[i]; }
+			}};
+			std::vector<double> sums(length / 2 + 1);
+			std::vector<float> real(length);
+			std::vector<float> imaginary(length);
+			for (std::size_t index {first}; index < last; index += 2)
+			{
+				// two real segments as one complex input: X1[k] = (Z[k] + conj(Z[n - k])) / 2, X2[k] = (Z[k] - conj(Z[n - k])) / 2i
+				const bool pair {index + 1 < last};
+				load(index, real.data());
+				if (pair) { load(index + 1, imaginary.data()); }
+				else { std::fill(imaginary.begin(), imaginary.end(), 0.0f); }
+				fft.transform(real.data(), imaginary.data(), set);
+				for (std::size_t k {}; k <= length / 2; ++k)
+				{
+					const std::size_t mirror {(length - k) & (length - 1)};
+					const float a {real[k]};
+					const float b {imaginary[k]};
+					const float c {real[mirror]};
+					const float d {imaginary[mirror]};
+					const float first {(a + c) * (a + c) + (b - d) * (b - d)};
+					const float second {pair ? (b + d) * (b + d) + (a - c) * (a - c) : 0.0f};
+					sums[k] += static_cast<double>(first + second) / 4.0;
+				}
+			}
+			return sums;
+		}
+
+		std::vector<density> compute(std::span<const std::span<const float>> columns, double period, uint32_t threads,
+									 statistics::instruction_set set)
+		{
+			// a task sums a chunk of segments of a column
+			struct task
+			{
+				std::size_t column;
+				std::size_t first;
+				std::size_t last;
+				std::vector<double> sums;
+			};
+			std::vector<task> tasks;
+			std::size_t longest {};
+			for (std::size_t i {}; i < columns.size(); ++i)
+			{
+				const layout layout {cut(columns[i].size())};
+				for (std::size_t first {}; first < layout.segments; first += chunk)
+				{
+					tasks.push_back(task {i, first, std::min(first + chunk, layout.segments), {}});
+				}
+				longest = std::max(longest, columns[i].size());
+			}
+			task_group group {threads, tasks.size(), longest >= parallel};
+			for (task & task : tasks)
+			{
+				group.submit([&task, &columns, set]
+				{
+					task.sums = accumulate(columns[task.column], cut(columns[task.column].size()).length, task.first, task.last, set);
+				});
+			}
+			group.wait();
+
+			std::vector<density> result(columns.size());
+			for (const task & task : tasks)
+			{
+				std::vector<double> & power {result[task.column].power};
+				if (power.empty()) { power.resize(task.sums.size()); }
+				for (std::size_t k {}; k < power.size(); ++k) { power[k] += task.sums[k]; }
+			}
+			for (std::size_t i {}; i < columns.size(); ++i)
+			{
+				const layout layout {cut(columns[i].size())};
+				density & density {result[i]};
+				density.segments = layout.segments;
+				if (!layout.segments) { continue; }
+				density.resolution = 1.0 / (period * static_cast<double>(layout.length));
+				// power of the window, so the density of the column does not depend on it
+				double window {};
+				for (const float value : hann(layout.length)) { window += static_cast<double>(value) * value; }
+				const double scale {period / (window * static_cast<double>(layout.segments))};
+				for (std::size_t k {}; k < density.power.size(); ++k)
+				{
+					// one-sided: negative frequencies are added to positive ones, zero and the highest have no pair
+					const bool paired {k > 0 && k < layout.length / 2};
+					density.power[k] *= scale * (paired ? 2.0 : 1.0);
+				}
+			}
+			return result;
+		}
+	}
+
+	fft::fft(std::size_t size) : m_size(size), m_reversed(size)
+	{
+		const auto bits {static_cast<uint32_t>(std::countr_zero(size))};
+		for (std::size_t i {}; i < size; ++i)
+		{
+			uint32_t reversed {};
+			for (uint32_t bit {}; bit < bits; ++bit)
+			{
+				reversed |= ((static_cast<uint32_t>(i) >> bit) & 1u) << (bits - 1 - bit);
+			}
+			m_reversed[i] = reversed;
+		}
+		m_real.reserve(size);
+		m_imaginary.reserve(size);
+		for (std::size_t half {1}; half < size; half *= 2)
+		{
+			for (std::size_t k {}; k < half; ++k)
+			{
+				const double angle {-std::numbers::pi * static_cast<double>(k) / static_cast<double>(half)};
+				m_real.push_back(static_cast<float>(std::cos(angle)));
+				m_imaginary.push_back(static_cast<float>(std::sin(angle)));
+			}
+		}
+	}
+
+	const fft & fft::get(std::size_t size)
+	{
+		// transforms are never changed once built, so only finding them needs the lock
+		static std::mutex mutex;
+		static std::map<std::size_t, std::unique_ptr<fft>> transforms;
+		std::lock_guard<std::mutex> lock {mutex};
+		std::unique_ptr<fft> & transform {transforms[size]};
+		if (!transform) { transform = std::make_unique<fft>(size); }
+		return *transform;
+	}
+
+	void fft::transform(float * real, float * imaginary, statistics::instruction_set set) const
+	{
+		for (std::size_t i {}; i < m_size; ++i)
+		{
+			const std::size_t j {m_reversed[i]};
+			if (i < j)
+			{
+				std::swap(real[i], real[j]);
+				std::swap(imaginary[i], imaginary[j]);
+			}
+		}
+		for (std::size_t half {1}; half < m_size; half *= 2)
+		{
+			select(set, half)(real, imaginary, m_size, half, m_real.data() + half - 1, m_imaginary.data() + half - 1);
+		}
+	}
+
+	std::size_t fft::size() const
+	{
+		return m_size;
+	}
+
+	density welch(std::span<const float> column, double period)
+	{
+		// processor does not change while program runs, so detect it only once
+		static const statistics::instruction_set set {statistics::detect()};
+		return std::move(compute(std::span<const std::span<const float>>(&column, 1), period, 1, set).front());
+	}
+
+	density welch(std::span<const float> column, double period, statistics::instruction_set set)
+	{
+		// never run instructions the processor does not have
+		return std::move(compute(std::span<const std::span<const float>>(&column, 1), period, 1, std::min(set, statistics::detect())).front());
+	}
+
+	std::vector<density> welch(std::span<const std::span<const float>> columns, double period, uint32_t threads)
+	{
+		static const statistics::instruction_set set {statistics::detect()};
+		return compute(columns, period, threads, set);
+	}
+
+	features describe(const density & density)
+	{
+		features result {};
+		if (density.power.size() < 2) { return result; }
+		// a constant column has no peak
+		const auto peak {std::max_element(density.power.begin() + 1, density.power.end())};
+		if (*peak > 0.0) { result.peak = static_cast<float>(static_cast<double>(peak - density.power.begin()) * density.resolution); }
+		// the highest frequency belongs to the last band
+		const std::size_t highest {density.power.size() - 1};
+		std::array<double, bands> band {};
+		double power {};
+		for (std::size_t k {}; k < density.power.size(); ++k)
+		{
+			band[std::min(k * bands / highest, bands - 1)] += density.power[k] * density.resolution;
+			power += density.power[k] * density.resolution;
+		}
+		result.power = static_cast<float>(power);
+		for (std::size_t i {}; i < bands; ++i) { result.band[i] = static_cast<float>(band[i]); }
+		return result;
+	}
+}
@@ -0,0 +1,104 @@
+//
+//  spectrum.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <span>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include "statistics.h"
+
+// Power spectral density of a single column of data (see 'columns.h'), e.g. of a gyroscope or a dither frequency,
+// by Welch's method: the column is cut into segments of 'segment' samples overlapping by half, the mean of every
+// segment is taken away, a segment is weighted by the Hann window and transformed, squared magnitudes of all
+// segments are averaged. The density is one-sided, in units of the column squared per Hz; its sum over all bins
+// times the resolution is the mean variance of a segment around its own mean. It is not the variance of the
+// column: drift and anything slower than a segment are taken away with the means of segments, and for a gyroscope
+// that could be most of it. Columns shorter than a segment get the longest power of two segment they hold,
+// columns shorter than 'shortest' samples get no density.
+//
+// Segments are transformed by class 'fft' - iterative radix-2 transform of a power of two size. Input is in two
+// arrays of real and imaginary parts, so a butterfly of several neighbouring pairs is a few vector instructions:
+// stages at least 8 pairs wide have an AVX2 version, at least 4 pairs wide an SSE version (see 'statistics.h'
+// for how the instruction set is chosen), narrower stages and other processors are scalar. Segments are real,
+// so two of them are transformed at once as the real and imaginary parts of a single input and split afterwards.
+// Twiddle factors and the bit-reversed order of a size are computed once per program and kept by get(), so is
+// the window of a segment length.
+//
+// Many columns are computed at once on a thread pool (see 'thread_pool.h'), segments of every column are cut into
+// chunks of 'chunk' segments, a task per chunk, and sums of chunks are added in their order, so the result does
+// not depend on the number of threads. Threads are started only for a column of at least 'parallel' samples.
+//
+// Features of a density kept in the results of a file:
+// - peak : frequency of the highest bin, the zero one not counted, in Hz, zero if the column is constant;
+// - power: in-band power of the density, the sum of all bins times the resolution, not comparable with the
+//          squared standard deviation of the column (see above);
+// - band : power of each of 'bands' equal bands from zero to the highest frequency.
+//
+// Class properties:
+// - m_size     : number of complex samples, a power of two;
+// - m_reversed : position of every sample after bit reversal;
+// - m_real, m_imaginary: twiddle factors exp(-iπk / half) of every stage one after another, stage of 'half'
+//                        pairs starts at 'half - 1'.
+//
+// Class behaviors:
+// - get()      : return the transform of given size, built once;
+// - transform(): transform given real and imaginary parts in place, with given instruction set;
+// - size()     : return 'm_size' member.
+//
+// Namespace behaviors:
+// - welch()   : return density of given column with given time between samples in seconds, forced to use given
+//               instruction set if it is given, or densities of given columns with given number of threads, zero
+//               means one per hardware thread;
+// - describe(): return features of given density.
+
+namespace ws::data::spectrum
+{
+	constexpr std::size_t segment {256};
+	constexpr std::size_t shortest {16};
+	constexpr std::size_t bands {4};
+	constexpr std::size_t chunk {1024};
+	constexpr std::size_t parallel {1 << 16};
+
+	struct density
+	{
+		// Hz between neighbouring bins
+		double resolution;
+		// bins from zero to the highest frequency, half of the segment and one more
+		std::vector<double> power;
+		std::size_t segments;
+	};
+
+	struct features
+	{
+		float peak;
+		float power;
+		std::array<float, bands> band;
+	};
+
+	class fft
+	{
+	public:
+		explicit fft(std::size_t);
+		fft(const fft &) = delete;
+		fft & operator = (const fft &) = delete;
+	public:
+		static const fft & get(std::size_t);
+		void transform(float *, float *, statistics::instruction_set) const;
+		std::size_t size() const;
+	private:
+		std::size_t m_size;
+		std::vector<uint32_t> m_reversed;
+		std::vector<float> m_real;
+		std::vector<float> m_imaginary;
+	};
+
+	density welch(std::span<const float>, double = 1.0);
+	density welch(std::span<const float>, double, statistics::instruction_set);
+	std::vector<density> welch(std::span<const std::span<const float>>, double = 1.0, uint32_t = 0);
+	features describe(const density &);
+}
@@ -0,0 +1,339 @@
+//
+//  statistics.cpp
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "statistics.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define WS_STATISTICS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+// MSVC compiles intrinsics of any instruction set without extra flags
+#define WS_TARGET(name)
+#else
+// GCC and Clang need the instruction set enabled for a single function
+#define WS_TARGET(name) __attribute__((target(name)))
+#endif
+#endif
+
+namespace ws::data::statistics
+{
+	namespace
+	{
+		// values of a block are accumulated in float, so block must be short enough to keep precision
+		constexpr std::size_t block_size {512};
+
+		// result of a single block: sums of differences from the first value of the block
+		struct block
+		{
+			std::size_t count;
+			float shift;
+			double s1;
+			double s2;
+			float min;
+			float max;
+		};
+
+		// merges blocks one by one with Chan's parallel formula:
+		// δ = mean_b - mean, M2 = M2_a + M2_b + δ² * n_a * n_b / (n_a + n_b)
+		class accumulator
+		{
+		public:
+			void merge(const block & block)
+			{
+				const auto n {static_cast<double>(block.count)};
+				const double block_mean {block.shift + block.s1 / n};
+				const double block_m2 {std::max(block.s2 - block.s1 * block.s1 / n, 0.0)};
+				m_sum += block.shift * n + block.s1;
+				m_min = std::min(m_min, static_cast<double>(block.min));
+				m_max = std::max(m_max, static_cast<double>(block.max));
+				if (!m_count)
+				{
+					m_mean = block_mean;
+					m_m2 = block_m2;
+				}
+				else
+				{
+					const auto count {static_cast<double>(m_count)};
+					const double delta {block_mean - m_mean};
+					m_mean += delta * n / (count + n);
+					m_m2 += block_m2 + delta * delta * count * n / (count + n);
+				}
+				m_count += block.count;
+			}
+
+			summary result() const
+			{
+				summary summary {};
+				summary.count = m_count;
+				summary.sum = m_sum;
+				summary.mean = m_mean;
+				summary.variance = m_count > 1 ? m_m2 / static_cast<double>(m_count - 1) : 0.0;
+				summary.deviation = std::sqrt(summary.variance);
+				summary.min = m_count ? m_min : 0.0;
+				summary.max = m_count ? m_max : 0.0;
+				return summary;
+			}
+		private:
+			std::size_t m_count {};
+			double m_sum {};
+			double m_mean {};
+			double m_m2 {};
+			double m_min {std::numeric_limits<double>::infinity()};
+			double m_max {-std::numeric_limits<double>::infinity()};
+		};
+
+		// adds values [first, size) of the block to the sums, used for the whole block by scalar
+		// kernel and for the tail of the block by vector kernels
+		void tail(const float * data, std::size_t first, std::size_t size, block & block)
+		{
+			float s1 {};
+			float s2 {};
+			for (std::size_t i {first}; i < size; ++i)
+			{
+				const float difference {data[i] - block.shift};
+				s1 += difference;
+				s2 += difference * difference;
+				block.min = std::min(block.min, data[i]);
+				block.max = std::max(block.max, data[i]);
+			}
+			block.s1 += s1;
+			block.s2 += s2;
+		}
+
+		block scalar(const float * data, std::size_t size)
+		{
+			block block {size, data[0], 0.0, 0.0, data[0], data[0]};
+			tail(data, 0, size, block);
+			return block;
+		}
+
+	#if defined(WS_STATISTICS_X86)
+		WS_TARGET("sse2")
+		block sse(const float * data, std::size_t size)
+		{
+			block block {size, data[0], 0.0, 0.0, data[0], data[0]};
+			const __m128 shift {_mm_set1_ps(data[0])};
+			__m128 s1 {_mm_setzero_ps()};
+			__m128 s2 {_mm_setzero_ps()};
+			__m128 min {shift};
+			__m128 max {shift};
+			std::size_t i {};
+			for (; i + 4 <= size; i += 4)
+			{
+				const __m128 value {_mm_loadu_ps(data + i)};
+				const __m128 difference {_mm_sub_ps(value, shift)};
+				s1 = _mm_add_ps(s1, difference);
+				s2 = _mm_add_ps(s2, _mm_mul_ps(difference, difference));
+				min = _mm_min_ps(min, value);
+				max = _mm_max_ps(max, value);
+			}
+			alignas(16) float lanes[4][4];
+			_mm_store_ps(lanes[0], s1);
+			_mm_store_ps(lanes[1], s2);
+			_mm_store_ps(lanes[2], min);
+			_mm_store_ps(lanes[3], max);
+			for (std::size_t lane {}; lane < 4; ++lane)
+			{
+				block.s1 += lanes[0][lane];
+				block.s2 += lanes[1][lane];
+				block.min = std::min(block.min, lanes[2][lane]);
+				block.max = std::max(block.max, lanes[3][lane]);
+			}
+			tail(data, i, size, block);
+			return block;
+		}
+
+		WS_TARGET("avx2")
+		block avx2(const float * data, std::size_t size)
+		{
+			block block {size, data[0], 0.0, 0.0, data[0], data[0]};
+			const __m256 shift {_mm256_set1_ps(data[0])};
+			__m256 s1 {_mm256_setzero_ps()};
+			__m256 s2 {_mm256_setzero_ps()};
+			__m256 min {shift};
+			__m256 max {shift};
+			std::size_t i {};
+			for (; i + 8 <= size; i += 8)
+			{
+				const __m256 value {_mm256_loadu_ps(data + i)};
+				const __m256 difference {_mm256_sub_ps(value, shift)};
+				s1 = _mm256_add_ps(s1, difference);
+				s2 = _mm256_add_ps(s2, _mm256_mul_ps(difference, difference));
+				min = _mm256_min_ps(min, value);
+				max = _mm256_max_ps(max, value);
+			}
+			alignas(32) float lanes[4][8];
+			_mm256_store_ps(lanes[0], s1);
+			_mm256_store_ps(lanes[1], s2);
+			_mm256_store_ps(lanes[2], min);
+			_mm256_store_ps(lanes[3], max);
+			for (std::size_t lane {}; lane < 8; ++lane)
+			{
+				block.s1 += lanes[0][lane];
+				block.s2 += lanes[1][lane];
+				block.min = std::min(block.min, lanes[2][lane]);
+				block.max = std::max(block.max, lanes[3][lane]);
+			}
+			tail(data, i, size, block);
+			return block;
+		}
+	#endif
+
+		using kernel = block (*)(const float *, std::size_t);
+
+		kernel select(instruction_set set)
+		{
+		#if defined(WS_STATISTICS_X86)
+			switch (set)
+			{
+				case instruction_set::AVX2: return &avx2;
+				case instruction_set::SSE: return &sse;
+				default: break;
+			}
+		#endif
+			return &scalar;
+		}
+
+		summary run(std::span<const float> data, kernel kernel)
+		{
+			accumulator accumulator;
+			for (std::size_t i {}; i < data.size(); i += block_size)
+			{
+				accumulator.merge(kernel(data.data() + i, std::min(block_size, data.size() - i)));
+			}
+			return accumulator.result();
+		}
+
+		template <typename T>
+		summary integral(std::span<const T> data)
+		{
+			// sum is exact, squares of differences from the first value are summed in double
+			summary summary {};
+			if (data.empty()) { return summary; }
+			const auto shift {static_cast<int64_t>(data.front())};
+			int64_t s1 {};
+			double s2 {};
+			T min {data.front()};
+			T max {data.front()};
+			for (auto value : data)
+			{
+				const int64_t difference {static_cast<int64_t>(value) - shift};
+				s1 += difference;
+				s2 += static_cast<double>(difference) * static_cast<double>(difference);
+				min = std::min(min, value);
+				max = std::max(max, value);
+			}
+			const auto n {static_cast<double>(data.size())};
+			summary.count = data.size();
+			summary.sum = static_cast<double>(shift * static_cast<int64_t>(data.size()) + s1);
+			summary.mean = summary.sum / n;
+			summary.variance = data.size() > 1 ? std::max(s2 - static_cast<double>(s1) * static_cast<double>(s1) / n, 0.0) / (n - 1.0) : 0.0;
+			summary.deviation = std::sqrt(summary.variance);
+			summary.min = static_cast<double>(min);
+			summary.max = static_cast<double>(max);
+			return summary;
+		}
+	}
+
+	summary summarize(std::span<const float> data)
+	{
+		// processor does not change while program runs, so choose the kernel only once
+		static const kernel kernel {select(detect())};
+		return run(data, kernel);
+	}
+
+	summary summarize(std::span<const float> data, instruction_set set)
+	{
+		// never run instructions the processor does not have
+		return run(data, select(std::min(set, detect())));
+	}
+
+	summary summarize(std::span<const int> data)
+	{
+		return integral(data);
+	}
+
+	summary summarize(std::span<const uint32_t> data)
+	{
+		return integral(data);
+	}
+
+	void running::push(double value)
+	{
+		++m_count;
+		m_sum += value;
+		const double delta {value - m_mean};
+		m_mean += delta / static_cast<double>(m_count);
+		m_squares += delta * (value - m_mean);
+		m_min = m_count == 1 ? value : std::min(m_min, value);
+		m_max = m_count == 1 ? value : std::max(m_max, value);
+	}
+
+	void running::merge(const running & other)
+	{
+		if (!other.m_count) { return; }
+		if (!m_count)
+		{
+			*this = other;
+			return;
+		}
+		const double count {static_cast<double>(m_count + other.m_count)};
+		const double delta {other.m_mean - m_mean};
+		m_squares += other.m_squares + delta * delta * static_cast<double>(m_count) * static_cast<double>(other.m_count) / count;
+		m_mean += delta * static_cast<double>(other.m_count) / count;
+		m_count += other.m_count;
+		m_sum += other.m_sum;
+		m_min = std::min(m_min, other.m_min);
+		m_max = std::max(m_max, other.m_max);
+	}
+
+	summary running::get() const
+	{
+		summary result {};
+		result.count = m_count;
+		result.sum = m_sum;
+		result.mean = m_mean;
+		result.min = m_min;
+		result.max = m_max;
+		// sample variance, same as summarize()
+		result.variance = m_count > 1 ? m_squares / static_cast<double>(m_count - 1) : 0.0;
+		result.deviation = std::sqrt(result.variance);
+		return result;
+	}
+
+	instruction_set detect()
+	{
+	#if defined(WS_STATISTICS_X86)
+	#if defined(_MSC_VER)
+		int info[4] {};
+		__cpuid(info, 0);
+		const int functions {info[0]};
+		__cpuid(info, 1);
+		const bool sse2 {(info[3] & (1 << 26)) != 0};
+		const bool avx {(info[2] & (1 << 28)) != 0 && (info[2] & (1 << 27)) != 0};
+		bool avx2 {};
+		if (avx && functions >= 7)
+		{
+			__cpuidex(info, 7, 0);
+			// operating system must save upper halves of ymm registers too
+			avx2 = (info[1] & (1 << 5)) != 0 && (_xgetbv(0) & 6) == 6;
+		}
+	#else
+		__builtin_cpu_init();
+		const bool sse2 {__builtin_cpu_supports("sse2") != 0};
+		const bool avx2 {__builtin_cpu_supports("avx2") != 0};
+	#endif
+		if (avx2) { return instruction_set::AVX2; }
+		if (sse2) { return instruction_set::SSE; }
+	#endif
+		return instruction_set::SCALAR;
+	}
+}
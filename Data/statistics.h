@@ -0,0 +1,78 @@
+//
+//  statistics.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <span>
+#include <cstdint>
+
+// Statistics kernels over a single column of data (see 'columns.h'). Struct 'summary' holds everything
+// analysis needs from one pass over the data: count, sum, mean, sample variance and standard deviation,
+// minimum and maximum. No temporary arrays are allocated.
+//
+// Floats are processed in blocks: inside a block every lane accumulates sum and sum of squares of
+// differences from the first value of the block (values of a column are close to each other, so these
+// sums stay small and precise in float), then blocks are merged in double with Chan's parallel formula.
+// The block loop has AVX2 and SSE versions, selected once at runtime by the processor features,
+// and a scalar fallback for other processors. Integer columns are summed exactly.
+//
+// Class 'running' gives the same 'summary' for values that come one by one, e.g. from a recording that is
+// still being written: mean and sum of squared differences from the mean are updated with Welford's method
+// in double, so nothing has to be kept and every update costs the same. Two of them are merged with Chan's
+// formula, so values could be split between threads and their partial results added up afterwards.
+//
+// Namespace behaviors:
+// - summarize(): return 'summary' of given column;
+// - detect()   : return the instruction set used by summarize() for floats on this processor.
+//
+// Running behaviors:
+// - push()     : add a single value;
+// - merge()    : add all values added to another one, the result does not depend on the order of values
+//                within each of them, only on the order of merges;
+// - get()      : return 'summary' of all values added so far.
+
+namespace ws::data::statistics
+{
+	struct summary
+	{
+		std::size_t count;
+		double sum;
+		double mean;
+		double variance;
+		double deviation;
+		double min;
+		double max;
+	};
+
+	enum class instruction_set
+	{
+		SCALAR,
+		SSE,
+		AVX2
+	};
+
+	class running
+	{
+	public:
+		void push(double);
+		void merge(const running &);
+		summary get() const;
+	private:
+		std::size_t m_count {};
+		double m_sum {};
+		double m_mean {};
+		double m_squares {};
+		double m_min {};
+		double m_max {};
+	};
+
+	summary summarize(std::span<const float>);
+	summary summarize(std::span<const int>);
+	summary summarize(std::span<const uint32_t>);
+	// same as summarize(), but forced to use given instruction set, used to compare implementations
+	summary summarize(std::span<const float>, instruction_set);
+	instruction_set detect();
+}
@@ -0,0 +1,315 @@
+//
+//  store.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <limits>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <string_view>
+
+// Result_store is a flat container of results of files, e.g. estimates (see 'collection.h'), keyed by path of the
+// file. Values are kept inline in a single std::vector, paths and names of all files are interned one after another
+// in a single std::string (a name that ends its path takes no space of its own), and an open addressing hash index
+// over the values finds a path for duplicate checks without a tree walk. Iteration goes in ascending order of paths,
+// the order is kept in a vector of indices that is extended while paths come in order and sorted again only when
+// iterated after an out of order insertion or an erase. Erased values are replaced by the last one, their strings
+// are dropped once garbage takes more than a half of the table. Paths, names and references given out are valid
+// until the store is changed; iteration may sort the order, so the store is not safe to share between threads.
+//
+// Class properties:
+// - m_items  : values with offsets of their path and name in 'm_strings' and the hash of the path;
+// - m_strings: characters of all paths and names;
+// - m_garbage: characters of erased paths and names still in 'm_strings';
+// - m_index  : slots of the hash index, each is an index in 'm_items' or 'vacant', size is a power of two;
+// - m_order  : indices in 'm_items' in ascending order of paths, valid if 'm_sorted' is set;
+// - m_sorted : 'm_order' is up to date.
+//
+// Class behaviors:
+// - contains()        : check if a value with given path is stored;
+// - find()            : return a pointer to the value with given path, nullptr if there is none;
+// - insert()          : add a value with given path and name, returns false and keeps the stored one if path is taken;
+// - insert_or_assign(): same as insert(), but replaces the stored value;
+// - erase()           : remove the value with given path, returns false if there was none;
+// - size()            : return number of stored values;
+// - empty()           : check if nothing is stored;
+// - clear()           : remove everything;
+// - reserve()         : allocate memory for given number of values;
+// - begin(), end()    : iterate over stored values in ascending order of paths, every item is an 'entry'.
+
+namespace ws::data
+{
+	template <typename T>
+	class result_store
+	{
+	public:
+		struct entry
+		{
+			std::string_view path;
+			std::string_view name;
+			const T & value;
+		};
+		class iterator
+		{
+		public:
+			iterator(const result_store * store, const uint32_t * position) : m_store(store), m_position(position) {}
+		public:
+			entry operator * () const
+			{
+				const item & item {m_store->m_items[*m_position]};
+				return {m_store->view(item.path, item.path_size), m_store->view(item.name, item.name_size), item.value};
+			}
+			iterator & operator ++ ()
+			{
+				++m_position;
+				return *this;
+			}
+			bool operator == (const iterator & other) const
+			{
+				return m_position == other.m_position;
+			}
+		private:
+			const result_store * m_store;
+			const uint32_t * m_position;
+		};
+	public:
+		bool contains(const std::string_view path) const
+		{
+			return this->find(path) != nullptr;
+		}
+
+		const T * find(const std::string_view path) const
+		{
+			if (m_index.empty()) { return nullptr; }
+			const uint32_t index {m_index[this->locate(path, std::hash<std::string_view> {}(path))]};
+			return index == vacant ? nullptr : &m_items[index].value;
+		}
+
+		bool insert(const std::string_view path, const std::string_view name, T value)
+		{
+			if (this->contains(path)) { return false; }
+			this->add(path, name, std::move(value));
+			return true;
+		}
+
+		void insert_or_assign(const std::string_view path, const std::string_view name, T value)
+		{
+			if (!m_index.empty())
+			{
+				const uint32_t index {m_index[this->locate(path, std::hash<std::string_view> {}(path))]};
+				if (index != vacant)
+				{
+					m_items[index].value = std::move(value);
+					return;
+				}
+			}
+			this->add(path, name, std::move(value));
+		}
+
+		bool erase(const std::string_view path)
+		{
+			if (m_index.empty()) { return false; }
+			std::size_t hole {this->locate(path, std::hash<std::string_view> {}(path))};
+			const uint32_t index {m_index[hole]};
+			if (index == vacant) { return false; }
+			// backward shift deletion: later slots of the same probe sequence move up, so no tombstones are needed
+			const std::size_t mask {m_index.size() - 1};
+			for (std::size_t next {(hole + 1) & mask}; m_index[next] != vacant; next = (next + 1) & mask)
+			{
+				const std::size_t home {m_items[m_index[next]].hash & mask};
+				if (((next - home) & mask) >= ((next - hole) & mask))
+				{
+					m_index[hole] = m_index[next];
+					hole = next;
+				}
+			}
+			m_index[hole] = vacant;
+			m_garbage += this->own(m_items[index]);
+			// the last value takes place of the erased one
+			const auto last {static_cast<uint32_t>(m_items.size() - 1)};
+			if (index != last)
+			{
+				const item & moved {m_items[last]};
+				m_index[this->locate(this->view(moved.path, moved.path_size), moved.hash)] = index;
+				m_items[index] = std::move(m_items[last]);
+			}
+			m_items.pop_back();
+			m_sorted = false;
+			if (m_garbage > m_strings.size() / 2) { this->compact(); }
+			return true;
+		}
+
+		std::size_t size() const
+		{
+			return m_items.size();
+		}
+
+		bool empty() const
+		{
+			return m_items.empty();
+		}
+
+		void clear()
+		{
+			m_items.clear();
+			m_strings.clear();
+			m_garbage = 0;
+			std::fill(m_index.begin(), m_index.end(), vacant);
+			m_order.clear();
+			m_sorted = true;
+		}
+
+		void reserve(std::size_t size)
+		{
+			m_items.reserve(size);
+			m_order.reserve(size);
+			if (size * 2 > m_index.size()) { this->rehash(size * 2); }
+		}
+
+		iterator begin() const
+		{
+			this->sort();
+			return iterator(this, m_order.data());
+		}
+
+		iterator end() const
+		{
+			this->sort();
+			return iterator(this, m_order.data() + m_order.size());
+		}
+	private:
+		struct item
+		{
+			uint32_t path;
+			uint32_t path_size;
+			uint32_t name;
+			uint32_t name_size;
+			std::size_t hash;
+			T value;
+		};
+		static constexpr uint32_t vacant {std::numeric_limits<uint32_t>::max()};
+	private:
+		std::string_view view(uint32_t offset, uint32_t size) const
+		{
+			return std::string_view(m_strings).substr(offset, size);
+		}
+
+		// characters of the item that no other item points to
+		std::size_t own(const item & item) const
+		{
+			return item.path_size + (item.name >= item.path && item.name < item.path + item.path_size ? 0 : item.name_size);
+		}
+
+		// slot of given path, or the empty slot where it should be put
+		std::size_t locate(const std::string_view path, std::size_t hash) const
+		{
+			const std::size_t mask {m_index.size() - 1};
+			std::size_t slot {hash & mask};
+			while (m_index[slot] != vacant)
+			{
+				const item & item {m_items[m_index[slot]]};
+				if (item.hash == hash && this->view(item.path, item.path_size) == path) { break; }
+				slot = (slot + 1) & mask;
+			}
+			return slot;
+		}
+
+		void add(const std::string_view path, const std::string_view name, T value)
+		{
+			// the index is never more than half full, so probe sequences stay short
+			if ((m_items.size() + 1) * 2 > m_index.size()) { this->rehash((m_items.size() + 1) * 2); }
+			const std::size_t hash {std::hash<std::string_view> {}(path)};
+			item item {static_cast<uint32_t>(m_strings.size()), static_cast<uint32_t>(path.size()), 0, static_cast<uint32_t>(name.size()), hash, std::move(value)};
+			m_strings += path;
+			if (path.ends_with(name))
+			{
+				item.name = item.path + static_cast<uint32_t>(path.size() - name.size());
+			}
+			else
+			{
+				item.name = static_cast<uint32_t>(m_strings.size());
+				m_strings += name;
+			}
+			const auto index {static_cast<uint32_t>(m_items.size())};
+			m_index[this->locate(path, hash)] = index;
+			// paths coming in ascending order keep the order valid
+			if (m_sorted && (m_order.empty() || this->view(m_items[m_order.back()].path, m_items[m_order.back()].path_size) < path))
+			{
+				m_order.push_back(index);
+			}
+			else
+			{
+				m_sorted = false;
+			}
+			m_items.push_back(std::move(item));
+		}
+
+		void rehash(std::size_t size)
+		{
+			std::size_t capacity {16};
+			while (capacity < size) { capacity *= 2; }
+			m_index.assign(capacity, vacant);
+			const std::size_t mask {capacity - 1};
+			for (std::size_t i {}; i < m_items.size(); ++i)
+			{
+				std::size_t slot {m_items[i].hash & mask};
+				while (m_index[slot] != vacant) { slot = (slot + 1) & mask; }
+				m_index[slot] = static_cast<uint32_t>(i);
+			}
+		}
+
+		void sort() const
+		{
+			if (m_sorted) { return; }
+			// paths are sorted next to their indices, so comparisons do not go through the items
+			std::vector<std::pair<std::string_view, uint32_t>> keys(m_items.size());
+			for (std::size_t i {}; i < m_items.size(); ++i)
+			{
+				keys[i] = {this->view(m_items[i].path, m_items[i].path_size), static_cast<uint32_t>(i)};
+			}
+			std::sort(keys.begin(), keys.end());
+			m_order.resize(keys.size());
+			std::transform(keys.begin(), keys.end(), m_order.begin(), [](const auto & key) { return key.second; });
+			m_sorted = true;
+		}
+
+		// drop characters of erased items
+		void compact()
+		{
+			std::string strings;
+			strings.reserve(m_strings.size() - m_garbage);
+			for (item & item : m_items)
+			{
+				const uint32_t path {static_cast<uint32_t>(strings.size())};
+				strings += this->view(item.path, item.path_size);
+				if (item.name >= item.path && item.name < item.path + item.path_size)
+				{
+					item.name = path + (item.name - item.path);
+				}
+				else
+				{
+					const uint32_t name {static_cast<uint32_t>(strings.size())};
+					strings += this->view(item.name, item.name_size);
+					item.name = name;
+				}
+				item.path = path;
+			}
+			m_strings = std::move(strings);
+			m_garbage = 0;
+		}
+	private:
+		std::vector<item> m_items;
+		std::string m_strings;
+		std::size_t m_garbage {};
+		std::vector<uint32_t> m_index;
+		mutable std::vector<uint32_t> m_order;
+		mutable bool m_sorted {true};
+	};
+}
@@ -0,0 +1,218 @@
+//
+//  synthetic.cpp
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#include <cmath>
+#include <numbers>
+#include "synthetic.h"
+#include "record.h"
+#include "writer.h"
+
+namespace ws::data
+{
+	namespace
+	{
+		// the unit aligns until 'count' reaches 600 and records before 60 are not stable yet
+		constexpr uint32_t starting_row {60};
+		constexpr uint32_t aligned_row {600};
+		// Earth rate in °/h as the gyros of the unit measure it at the bench latitude
+		constexpr float horizontal_rate {9.0f};
+		constexpr float vertical_rate {13.25f};
+		// gyros are quantized by the unit
+		constexpr float gyro_step {0.25f};
+		constexpr float gyro_noise {0.23f};
+		// the checksum covers all bytes before it
+		constexpr std::size_t crc8_offset {schema::find<&row::crc8>().offset};
+
+		float wrap(float degree)
+		{
+			degree = std::fmod(degree, 360.0f);
+			return degree < 0.0f ? degree + 360.0f : degree;
+		}
+	}
+
+	synthetic::synthetic(const settings & settings) : m_settings(settings), m_random(settings.seed) {}
+
+	bool synthetic::save(const std::string_view filename)
+	{
+		m_injected = {};
+		writer fout;
+		if (!fout.open(filename, true)) { return false; }
+		std::string & buffer {fout.buffer()};
+		const fault_rates & faults {m_settings.faults};
+
+		// values that stay the same for the whole recording, drawn once
+		const uint32_t first {41 + static_cast<uint32_t>(m_random() % 17)};
+		const float heading {m_settings.heading * std::numbers::pi_v<float> / 180.0f};
+		const float east {std::sin(heading)}, north {std::cos(heading)};
+		const float heading_error {this->noise(0.08f)};
+		const float swing {this->noise(0.4f)};
+		const float pitch {-0.16f + this->noise(0.03f)}, pitch_swing {this->noise(0.05f)};
+		const float roll {-0.03f + this->noise(0.03f)}, roll_swing {this->noise(0.05f)};
+		const float bias_X {this->noise(0.05f)}, bias_Y {this->noise(0.05f)}, bias_Z {this->noise(0.05f)};
+		const float gyro_temperature {2224.0f + this->noise(60.0f)};
+		const float acc_temperature {24430.0f + this->noise(60.0f)};
+		const float dpb_temperature {24780.0f + this->noise(60.0f)};
+		const float heating {0.05f + this->noise(0.01f)};
+		float thdg {};
+
+		row row {};
+		row.latitude = 55.56644f;
+		row.longtitude = 38.24414f;
+		row.F_dith_X = 377.8f;
+		row.F_dith_Y = 404.4f;
+		row.F_dith_Z = 387.7f;
+		row.dpb_Z_temperature = 400;
+		row.drift_X = row.drift_Y = row.drift_Z = 400.0f;
+		row.D23 = 0.10f;
+		row.D31 = 0.06f;
+		row.D32 = 0.05f;
+		row.Mg1 = 0.93258f;
+		row.Mg2 = 0.93233f;
+		row.Mg3 = 0.93196f;
+		row.Wo1 = -0.01846f;
+		row.Wo2 = -0.05190f;
+		row.Wo3 = 0.00983f;
+		row.E12 = -0.00047f;
+		row.E13 = -0.00004f;
+		row.E21 = -0.00091f;
+		row.E23 = -0.00036f;
+		row.E31 = 0.00034f;
+		row.E32 = -0.00028f;
+		row.Ma1 = 1.0f;
+		row.Ma2 = 1.0f;
+		row.Ma3 = 1.00004f;
+		row.Ao1 = 0.00056f;
+		row.Ao2 = 0.00199f;
+		row.Ao3 = 0.00477f;
+		row.error = m_settings.error;
+
+		for (uint32_t i {}; i < m_settings.length; ++i)
+		{
+			const uint32_t count {first + i};
+			const float time {static_cast<float>(count)};
+			row.count = count;
+			row.system_time = time;
+			row.mode = count < aligned_row ? 4 : 8;
+			row.mode_time = count < starting_row ? 0.0f : static_cast<float>(count - (count < aligned_row ? starting_row : aligned_row));
+			if (count < starting_row)
+			{
+				row.thdg = row.roll = row.pitch = 0.0f;
+				row.H = 125.0f;
+			}
+			else
+			{
+				const float t {static_cast<float>(count - starting_row)};
+				// alignment converges to the true heading with a small error and is fixed when it is over
+				if (count <= aligned_row)
+				{
+					thdg = m_settings.heading + heading_error + swing * std::exp(-t / 120.0f) * std::cos(t / 48.0f);
+				}
+				row.thdg = wrap(thdg + this->noise(0.002f));
+				row.pitch = pitch + pitch_swing * std::exp(-t / 150.0f) + this->noise(0.0005f);
+				row.roll = roll + roll_swing * std::exp(-t / 150.0f) + this->noise(0.0005f);
+				row.H = 124.8f + this->noise(0.3f);
+			}
+			if (row.mode == 8)
+			{
+				row.azimuth = (row.thdg > 180.0f ? row.thdg - 360.0f : row.thdg) + this->noise(0.003f);
+				row.Ve = this->noise(0.003f);
+				row.Vn = this->noise(0.003f);
+				row.Vu = this->noise(0.003f);
+			}
+			row.dAt_X = 8.68f * east + this->noise(0.25f);
+			row.dAt_Y = 8.68f * north + this->noise(0.25f);
+			row.dAt_Z = 12.336f + this->noise(0.25f);
+			row.dVt_X = 0.00645f + this->noise(0.001f);
+			row.dVt_Y = -0.02719f + this->noise(0.001f);
+			row.dVt_Z = 9.72988f + this->noise(0.001f);
+			row.gyro_X = std::round((horizontal_rate * east + bias_X + this->noise(gyro_noise)) / gyro_step) * gyro_step + 0.0f;
+			row.gyro_Y = std::round((horizontal_rate * north + bias_Y + this->noise(gyro_noise)) / gyro_step) * gyro_step + 0.0f;
+			row.gyro_Z = std::round((vertical_rate + bias_Z + this->noise(gyro_noise)) / gyro_step) * gyro_step + 0.0f;
+			row.acc_X = 0.00007f + this->noise(0.00002f);
+			row.acc_Y = 0.00050f + this->noise(0.00002f);
+			row.acc_Z = -0.27043f + this->noise(0.00002f);
+			row.U_cplc_X = -0.16f + this->noise(0.02f);
+			row.U_cplc_Y = -0.97f + this->noise(0.02f);
+			row.U_cplc_Z = -0.16f + this->noise(0.02f);
+			row.U_hfo_X = -8.71f + this->noise(0.02f);
+			row.U_hfo_Y = -8.53f + this->noise(0.02f);
+			row.U_hfo_Z = -7.38f + this->noise(0.02f);
+			row.F_out_X = 100.7f - 0.004f * time + this->noise(0.3f);
+			row.F_out_Y = 91.4f - 0.004f * time + this->noise(0.3f);
+			row.F_out_Z = 100.5f - 0.004f * time + this->noise(0.3f);
+			// temperatures are integers in hundredths of °C, all of them rise while the unit warms up
+			const float warming {heating * time};
+			row.gyro_X_temperature = static_cast<int>(std::round(gyro_temperature + warming + this->noise(0.5f)));
+			row.gyro_Y_temperature = static_cast<int>(std::round(gyro_temperature + 140.0f + warming + this->noise(0.5f)));
+			row.gyro_Z_temperature = static_cast<int>(std::round(gyro_temperature + 215.0f + warming + this->noise(0.5f)));
+			row.acc_X_temperature = static_cast<uint32_t>(std::round(acc_temperature + 3.0f * warming + this->noise(1.0f)));
+			row.acc_Y_temperature = static_cast<uint32_t>(std::round(acc_temperature - 90.0f + 3.0f * warming + this->noise(1.0f)));
+			row.acc_Z_temperature = static_cast<uint32_t>(std::round(acc_temperature - 75.0f + 3.0f * warming + this->noise(1.0f)));
+			row.dpb_X_temperature = row.dpb_Y_temperature = static_cast<uint32_t>(std::round(dpb_temperature + 11.0f * warming));
+			row.D12 = std::round(117.0f + this->noise(5.0f));
+			row.D13 = std::round(79.0f + this->noise(5.0f));
+			row.D21 = std::round(94.0f + this->noise(5.0f));
+
+			if (this->chance(faults.drop))
+			{
+				++m_injected.dropped;
+				continue;
+			}
+			if (this->chance(faults.spike))
+			{
+				// a single wild sample of one gyro, the checksum is still valid
+				float & gyro {m_random() % 3 == 0 ? row.gyro_X : m_random() % 2 == 0 ? row.gyro_Y : row.gyro_Z};
+				gyro += (m_random() % 2 == 0 ? 1.0f : -1.0f) * static_cast<float>(50 + m_random() % 450);
+				++m_injected.spikes;
+			}
+			if (this->chance(faults.garbage))
+			{
+				// bytes out of frame, so the records after them are read shifted
+				const std::size_t size {1 + m_random() % (schema::size - 1)};
+				for (std::size_t j {}; j < size; ++j)
+				{
+					buffer.push_back(static_cast<char>(m_random()));
+				}
+				++m_injected.garbage;
+			}
+			const std::size_t offset {buffer.size()};
+			buffer.resize(offset + schema::size);
+			std::byte * data {reinterpret_cast<std::byte *>(buffer.data() + offset)};
+			row.crc8 = 0;
+			record::encode(row, data);
+			data[crc8_offset] = static_cast<std::byte>(crc8(data, crc8_offset));
+			if (this->chance(faults.crc))
+			{
+				// one bit flipped on the way, the checksum does not match anymore
+				data[m_random() % (crc8_offset + 1)] ^= static_cast<std::byte>(1 << (m_random() % 8));
+				++m_injected.crc;
+			}
+			if (faults.truncate && i + 1 == m_settings.length)
+			{
+				buffer.resize(offset + 1 + m_random() % (schema::size - 1));
+				m_injected.truncated = true;
+			}
+			fout.commit();
+		}
+		return fout.close();
+	}
+
+	const synthetic::injected & synthetic::get_injected() const
+	{
+		return m_injected;
+	}
+
+	float synthetic::noise(float deviation)
+	{
+		return deviation * m_normal(m_random);
+	}
+
+	bool synthetic::chance(double probability)
+	{
+		return probability > 0.0 && std::generate_canonical<double, 53>(m_random) < probability;
+	}
+}
@@ -0,0 +1,83 @@
+//
+//  synthetic.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <random>
+#include <string>
+#include <cstdint>
+#include <string_view>
+#include "row.h"
+
+// Synthetic class makes .dat recordings that look like the ones the unit writes on the test bench, one 301
+// bytes long record per second (see 'record.h'). A recording starts a few records before 'count' reaches 60,
+// so loaders have unstable records to skip, aligns in mode 4 until 'count' reaches 600 and navigates in mode 8
+// after that. Heading converges to the given one plus a random alignment error, then stays fixed. Gyros measure
+// the Earth rate at the bench latitude plus bias and white noise, quantized the same way the unit does;
+// temperatures drift up linearly with noise; other fields keep values taken from real recordings with noise
+// where they are noisy. Every record has a valid checksum, unless faults are injected: with given probability
+// per record a record is dropped, gets a wrong checksum, gets a gyro spike or is preceded by garbage bytes;
+// the last record could be cut short. The same settings and seed always give the same bytes (within one build,
+// distributions of the standard library are not the same everywhere).
+//
+// Class properties:
+// - m_settings: length, heading, seed, error byte and faults of the recording;
+// - m_random  : random number generator seeded from the settings;
+// - m_normal  : standard normal distribution of the noise;
+// - m_injected: number of faults of every kind injected by the last save().
+//
+// Class behaviors:
+// - save()        : write the recording to the file, returns false if it could not be written;
+// - get_injected(): return a const reference to 'm_injected' member.
+
+namespace ws::data
+{
+	class synthetic
+	{
+	public:
+		// probabilities per record, zero means never
+		struct fault_rates
+		{
+			double drop;
+			double crc;
+			double spike;
+			double garbage;
+			bool truncate;
+		};
+		struct settings
+		{
+			// number of records, one per second
+			uint32_t length {3600};
+			// true heading in degrees
+			float heading {};
+			uint64_t seed {};
+			// value of the last byte of every record, the unit writes 1, 3 or 8
+			uint32_t error {1};
+			fault_rates faults {};
+		};
+		struct injected
+		{
+			std::size_t dropped;
+			std::size_t crc;
+			std::size_t spikes;
+			std::size_t garbage;
+			bool truncated;
+		};
+	public:
+		explicit synthetic(const settings &);
+	public:
+		bool save(const std::string_view);
+		const injected & get_injected() const;
+	private:
+		float noise(float);
+		bool chance(double);
+	private:
+		settings m_settings;
+		std::mt19937_64 m_random;
+		std::normal_distribution<float> m_normal;
+		injected m_injected {};
+	};
+}
@@ -0,0 +1,117 @@
+//
+//  tail.cpp
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#include <string>
+#include <cstring>
+#include <algorithm>
+#if defined(_WIN32)
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+#include "tail.h"
+#include "record.h"
+
+namespace ws::data
+{
+	tail::~tail()
+	{
+		this->close();
+	}
+
+	bool tail::open(const std::string_view filename)
+	{
+		this->close();
+		// string_view is not guaranteed to be null terminated
+		const std::string name {filename};
+	#if defined(_WIN32)
+		m_handle = _open(name.c_str(), _O_RDONLY | _O_BINARY);
+		return m_handle >= 0;
+	#else
+		// a pipe opened without O_NONBLOCK would wait here for a writer
+		m_handle = ::open(name.c_str(), O_RDONLY | O_NONBLOCK);
+		if (m_handle < 0) { return false; }
+		struct stat status {};
+		m_pipe = fstat(m_handle, &status) == 0 && S_ISFIFO(status.st_mode);
+		return true;
+	#endif
+	}
+
+	void tail::close()
+	{
+		if (m_handle >= 0)
+		{
+		#if defined(_WIN32)
+			_close(m_handle);
+		#else
+			::close(m_handle);
+		#endif
+		}
+		m_handle = -1;
+		m_filled = 0;
+		m_started = false;
+		m_pipe = false;
+		m_connected = false;
+		m_ended = false;
+	}
+
+	std::size_t tail::read(std::vector<row> & rows, const projection & projection)
+	{
+		if (m_handle < 0 || m_ended) { return 0; }
+		constexpr uint32_t starting_row {60};
+		std::array<std::byte, 1 << 16> buffer;
+		std::size_t count {};
+		while (true)
+		{
+		#if defined(_WIN32)
+			const int size {_read(m_handle, buffer.data(), static_cast<unsigned int>(buffer.size()))};
+		#else
+			const ssize_t size {::read(m_handle, buffer.data(), buffer.size())};
+			// the writer is connected but wrote nothing new
+			if (size < 0 && errno == EAGAIN)
+			{
+				m_connected = true;
+				break;
+			}
+		#endif
+			if (size < 0) { break; }
+			if (size == 0)
+			{
+				// end of a file only means nothing new was written yet, but end of a pipe that had a writer
+				// means the writer is gone
+				m_ended = m_pipe && m_connected;
+				break;
+			}
+			m_connected = true;
+			for (std::size_t offset {}; offset < static_cast<std::size_t>(size); )
+			{
+				const std::size_t part {std::min(m_record.size() - m_filled, static_cast<std::size_t>(size) - offset)};
+				std::memcpy(m_record.data() + m_filled, buffer.data() + offset, part);
+				m_filled += part;
+				offset += part;
+				if (m_filled < m_record.size()) { break; }
+				m_filled = 0;
+				const record record {m_record.data()};
+				m_started = m_started || record.get<&row::count>() >= starting_row;
+				if (!m_started) { continue; }
+				row & row {rows.emplace_back()};
+				record.decode(row, projection);
+				++count;
+			}
+		}
+		return count;
+	}
+
+	bool tail::ended() const
+	{
+		return m_ended;
+	}
+}
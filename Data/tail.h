@@ -0,0 +1,62 @@
+//
+//  tail.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <string_view>
+#include "row.h"
+#include "schema.h"
+
+// Tail class reads .dat records (see 'record.h') from a file that is still being written or from a named
+// pipe (FIFO, not on Windows), as they arrive. read() never waits: it decodes every complete record written
+// since the last call, a record written in part is kept until the rest of it arrives. Same as the .dat loaders
+// (see 'file.h') unstable records before 'count' reaches 60 are skipped. A file never ends by itself, it is up
+// to the caller to decide that nothing more will be written; a pipe ends when its writer closes it.
+// The class is not copyable, the file is closed in destructor.
+//
+// Class properties:
+// - m_handle   : file descriptor, -1 if nothing is open;
+// - m_record   : bytes of the record being read;
+// - m_filled   : number of bytes of 'm_record' read so far;
+// - m_started  : a record with 'count' of 60 or more was read;
+// - m_pipe     : the source is a named pipe;
+// - m_connected: a writer opened the pipe;
+// - m_ended    : the writer closed the pipe.
+//
+// Class behaviors:
+// - open() : open a file or a named pipe without waiting for a writer, returns false if it could not be opened;
+// - close(): close the source;
+// - read() : append all complete records read since the last call to given rows, only fields of given
+//            projection are decoded, returns the number of appended rows;
+// - ended(): check if the writer closed the pipe, always false for files.
+
+namespace ws::data
+{
+	class tail
+	{
+	public:
+		tail() = default;
+		tail(const tail &) = delete;
+		tail & operator = (const tail &) = delete;
+		~tail();
+	public:
+		bool open(const std::string_view);
+		void close();
+		std::size_t read(std::vector<row> &, const projection & = schema::all());
+		bool ended() const;
+	private:
+		int m_handle {-1};
+		std::array<std::byte, schema::size> m_record {};
+		std::size_t m_filled {};
+		bool m_started {};
+		bool m_pipe {};
+		bool m_connected {};
+		bool m_ended {};
+	};
+}
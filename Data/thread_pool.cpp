@@ -0,0 +1,151 @@
+//
+//  thread_pool.cpp
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#include <algorithm>
+#include "thread_pool.h"
+
+namespace ws::data
+{
+	namespace
+	{
+		// lets a worker find its own queue when it submits or asks for its index
+		thread_local const thread_pool * current_pool {};
+		thread_local std::size_t current_index {};
+	}
+
+	thread_pool::thread_pool(uint32_t threads) : m_queued(), m_pending(), m_next(), m_stop()
+	{
+		if (!threads)
+		{
+			threads = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+		m_queues.reserve(threads);
+		for (uint32_t i {}; i < threads; ++i)
+		{
+			m_queues.push_back(std::make_unique<queue>());
+		}
+		m_workers.reserve(threads);
+		for (uint32_t i {}; i < threads; ++i)
+		{
+			m_workers.emplace_back(&thread_pool::run, this, i);
+		}
+	}
+
+	thread_pool::~thread_pool()
+	{
+		{
+			std::lock_guard<std::mutex> lock {m_mutex};
+			m_stop = true;
+		}
+		m_wake.notify_all();
+		for (auto & worker : m_workers)
+		{
+			worker.join();
+		}
+	}
+
+	void thread_pool::submit(std::function<void()> task)
+	{
+		++m_pending;
+		// a worker puts new tasks to its own queue, any other thread spreads them over all queues
+		std::size_t target {current_pool == this ? current_index : m_next++ % m_queues.size()};
+		++m_queued;
+		{
+			std::lock_guard<std::mutex> lock {m_queues[target]->mutex};
+			m_queues[target]->tasks.push_back(std::move(task));
+		}
+		// taking the mutex makes sure a worker is either before its check or already asleep,
+		// so the notification could not be lost
+		{
+			std::lock_guard<std::mutex> lock {m_mutex};
+		}
+		m_wake.notify_one();
+	}
+
+	void thread_pool::wait()
+	{
+		std::unique_lock<std::mutex> lock {m_mutex};
+		m_done.wait(lock, [this] { return m_pending == 0; });
+	}
+
+	std::size_t thread_pool::size() const
+	{
+		return m_workers.size();
+	}
+
+	std::size_t thread_pool::index() const
+	{
+		return current_pool == this ? current_index : m_workers.size();
+	}
+
+	void thread_pool::run(std::size_t index)
+	{
+		current_pool = this;
+		current_index = index;
+		std::function<void()> task;
+		while (true)
+		{
+			if (this->pop(index, task))
+			{
+				task();
+				task = nullptr;
+				if (--m_pending == 0)
+				{
+					{
+						std::lock_guard<std::mutex> lock {m_mutex};
+					}
+					m_done.notify_all();
+				}
+				continue;
+			}
+			std::unique_lock<std::mutex> lock {m_mutex};
+			m_wake.wait(lock, [this] { return m_stop || m_queued > 0; });
+			if (m_stop && m_queued == 0) { return; }
+		}
+	}
+
+	bool thread_pool::pop(std::size_t index, std::function<void()> & task)
+	{
+		// own queue first, newest task is most likely still warm in cache
+		{
+			std::lock_guard<std::mutex> lock {m_queues[index]->mutex};
+			if (!m_queues[index]->tasks.empty())
+			{
+				task = std::move(m_queues[index]->tasks.back());
+				m_queues[index]->tasks.pop_back();
+				--m_queued;
+				return true;
+			}
+		}
+		// then steal the oldest task from other workers
+		for (std::size_t i {1}; i < m_queues.size(); ++i)
+		{
+			auto & victim {*m_queues[(index + i) % m_queues.size()]};
+			std::lock_guard<std::mutex> lock {victim.mutex};
+			if (!victim.tasks.empty())
+			{
+				task = std::move(victim.tasks.front());
+				victim.tasks.pop_front();
+				--m_queued;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	task_group::task_group(uint32_t threads, std::size_t tasks, bool large)
+	{
+		if (threads == 1 || tasks < 2 || !large) { return; }
+		const std::size_t hardware {std::max(std::thread::hardware_concurrency(), 1u)};
+		m_pool = std::make_unique<thread_pool>(static_cast<uint32_t>(std::min<std::size_t>(threads ? threads : hardware, tasks)));
+	}
+
+	void task_group::wait()
+	{
+		if (m_pool) { m_pool->wait(); }
+	}
+}
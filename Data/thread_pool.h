@@ -0,0 +1,104 @@
+//
+//  thread_pool.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <mutex>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <functional>
+#include <condition_variable>
+
+// Work stealing thread pool. Every worker has its own queue of tasks: a worker takes tasks from the back
+// of its own queue and, when it is empty, steals from the front of other queues, so a worker that got
+// only short tasks does not stay idle while others are busy with long ones. Tasks submitted from outside
+// are spread over the queues one by one. Tasks must not throw. Pool is neither copyable nor movable,
+// workers are joined in destructor.
+//
+// Class properties:
+// - m_queues : one queue of tasks per worker, each with its own mutex;
+// - m_workers: worker threads;
+// - m_queued : number of tasks waiting in queues;
+// - m_pending: number of tasks submitted but not finished yet;
+// - m_next   : queue to put the next task submitted from outside;
+// - m_stop   : set in destructor to let workers finish;
+// - m_mutex, m_wake, m_done: used to put idle workers to sleep and to wait for all tasks.
+//
+// Class behaviors:
+// - submit(): add a new task;
+// - wait()  : block until all submitted tasks are finished;
+// - size()  : return number of workers;
+// - index() : return index of the worker running the calling thread, or size() for any other thread.
+//
+// Task group class runs tasks of a single computation on a thread pool of its own, or on the calling thread if
+// threads would not help: one thread is asked for, there are not two tasks or the caller says the work is too
+// small. The pool has no more workers than tasks. Submitted tasks run at once on the calling thread if there is
+// no pool, so the same code serves both cases.
+//
+// Class properties:
+// - m_pool: workers of the group, none if tasks run on the calling thread.
+//
+// Class behaviors:
+// - submit(): run given task on the pool, or at once if there is none;
+// - wait()  : block until all submitted tasks are finished.
+
+namespace ws::data
+{
+	class thread_pool
+	{
+	public:
+		// zero means one worker per hardware thread
+		explicit thread_pool(uint32_t = 0);
+		thread_pool(const thread_pool &) = delete;
+		thread_pool & operator = (const thread_pool &) = delete;
+		~thread_pool();
+	public:
+		void submit(std::function<void()>);
+		void wait();
+		std::size_t size() const;
+		std::size_t index() const;
+	private:
+		struct queue
+		{
+			std::mutex mutex;
+			std::deque<std::function<void()>> tasks;
+		};
+	private:
+		void run(std::size_t);
+		bool pop(std::size_t, std::function<void()> &);
+	private:
+		std::vector<std::unique_ptr<queue>> m_queues;
+		std::vector<std::thread> m_workers;
+		std::atomic<std::size_t> m_queued;
+		std::atomic<std::size_t> m_pending;
+		std::atomic<std::size_t> m_next;
+		bool m_stop;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_done;
+	};
+
+	class task_group
+	{
+	public:
+		// number of threads as for 'thread_pool', number of tasks and whether the work is large enough for threads
+		task_group(uint32_t, std::size_t, bool = true);
+	public:
+		template <typename F>
+		void submit(F && task)
+		{
+			if (m_pool) { m_pool->submit(std::forward<F>(task)); }
+			else { task(); }
+		}
+		void wait();
+	private:
+		std::unique_ptr<thread_pool> m_pool;
+	};
+}
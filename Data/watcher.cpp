@@ -0,0 +1,116 @@
+//
+//  watcher.cpp
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#include <array>
+#include <cstring>
+#if defined(__linux__)
+#include <cerrno>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+#include "watcher.h"
+
+namespace ws::data
+{
+	watcher::~watcher()
+	{
+		this->close();
+	}
+
+	bool watcher::open(const std::filesystem::path & path)
+	{
+		this->close();
+	#if defined(__linux__)
+		m_handle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (m_handle < 0) { return false; }
+		// everything that changes content, size or modification time of a file or the set of files
+		constexpr uint32_t mask {IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_DELETE |
+								 IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF};
+		auto watch {[this, mask](const std::filesystem::path & directory)
+		{
+			const int descriptor {inotify_add_watch(m_handle, directory.c_str(), mask)};
+			if (descriptor < 0) { return false; }
+			m_directories.emplace(descriptor, directory);
+			return true;
+		}};
+		std::error_code error;
+		bool watched {watch(path)};
+		for (std::filesystem::recursive_directory_iterator i {path, error};
+			 watched && !error && i != std::filesystem::recursive_directory_iterator(); i.increment(error))
+		{
+			std::error_code status;
+			if (i->is_directory(status)) { watched = watch(i->path()); }
+		}
+		// a tree watched only in part would miss changes, so it is not watched at all
+		if (!watched || error)
+		{
+			this->close();
+			return false;
+		}
+		return true;
+	#else
+		static_cast<void>(path);
+		return false;
+	#endif
+	}
+
+	void watcher::close()
+	{
+	#if defined(__linux__)
+		if (m_handle >= 0) { ::close(m_handle); }
+	#endif
+		m_handle = -1;
+		m_directories.clear();
+	}
+
+	bool watcher::active() const
+	{
+		return m_handle >= 0;
+	}
+
+	bool watcher::poll(std::vector<std::filesystem::path> & changed)
+	{
+		if (!this->active()) { return false; }
+		bool complete {true};
+	#if defined(__linux__)
+		alignas(inotify_event) std::array<char, 1 << 16> buffer;
+		while (true)
+		{
+			const ssize_t size {read(m_handle, buffer.data(), buffer.size())};
+			if (size <= 0)
+			{
+				// no more events
+				if (size < 0 && errno == EAGAIN) { break; }
+				return false;
+			}
+			for (ssize_t offset {}; offset < size; )
+			{
+				inotify_event event {};
+				std::memcpy(&event, buffer.data() + offset, sizeof(event));
+				const char * name {buffer.data() + offset + sizeof(event)};
+				offset += static_cast<ssize_t>(sizeof(event) + event.len);
+				// folders created, removed or moved change the set of watches, only a new walk finds out how
+				if ((event.mask & (IN_Q_OVERFLOW | IN_ISDIR | IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) != 0)
+				{
+					complete = false;
+					continue;
+				}
+				const auto directory {m_directories.find(event.wd)};
+				if (directory == m_directories.end() || event.len == 0)
+				{
+					complete = false;
+					continue;
+				}
+				changed.push_back(directory->second / name);
+			}
+		}
+	#else
+		static_cast<void>(changed);
+	#endif
+		return complete;
+	}
+}
@@ -0,0 +1,48 @@
+//
+//  watcher.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <vector>
+#include <filesystem>
+#include <unordered_map>
+
+// Watcher class tells which files of a folder tree changed since it was asked last time, without walking the
+// tree. It is a thin wrapper around inotify with one watch per folder, thus it works on Linux only, elsewhere
+// open() always fails and caller has to walk the tree itself. Events are read without blocking. Some changes
+// cannot be described as a list of files: a folder created, removed or moved, or the event queue overflowed;
+// then poll() reports that events were lost, caller has to walk the tree and open() the watcher again.
+// The class is not copyable, inotify instance is released in destructor.
+//
+// Class properties:
+// - m_handle     : inotify instance, -1 if nothing is watched;
+// - m_directories: watched folders by their watch descriptors.
+//
+// Class behaviors:
+// - open()  : watch given folder and all folders inside it, returns false if watching is not supported or failed;
+// - close() : stop watching;
+// - active(): check if anything is watched;
+// - poll()  : append paths of files changed since the last call, returns false if some events were lost.
+
+namespace ws::data
+{
+	class watcher
+	{
+	public:
+		watcher() = default;
+		watcher(const watcher &) = delete;
+		watcher & operator = (const watcher &) = delete;
+		~watcher();
+	public:
+		bool open(const std::filesystem::path &);
+		void close();
+		bool active() const;
+		bool poll(std::vector<std::filesystem::path> &);
+	private:
+		int m_handle {-1};
+		std::unordered_map<int, std::filesystem::path> m_directories;
+	};
+}
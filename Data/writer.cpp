@@ -0,0 +1,67 @@
+//
+//  writer.cpp
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#include "writer.h"
+
+namespace ws::data
+{
+	namespace
+	{
+		// room for one more row over the capacity, so appending a row never reallocates the buffer
+		constexpr std::size_t headroom {1 << 16};
+	}
+
+	writer::writer(std::size_t capacity) : m_capacity(capacity)
+	{
+		m_buffer.reserve(m_capacity + headroom);
+	}
+
+	writer::~writer()
+	{
+		this->close();
+	}
+
+	bool writer::open(const std::string_view filename, bool binary)
+	{
+		m_file.open(std::string(filename), binary ? std::ios_base::out | std::ios_base::binary : std::ios_base::out);
+		return m_file.is_open();
+	}
+
+	void writer::write(std::string_view bytes)
+	{
+		m_buffer.append(bytes);
+		this->commit();
+	}
+
+	std::string & writer::buffer()
+	{
+		return m_buffer;
+	}
+
+	void writer::commit()
+	{
+		if (m_buffer.size() >= m_capacity)
+		{
+			this->flush();
+		}
+	}
+
+	bool writer::close()
+	{
+		if (!m_file.is_open()) { return false; }
+		this->flush();
+		m_file.close();
+		return !m_file.fail();
+	}
+
+	void writer::flush()
+	{
+		m_file.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+		// clear() keeps capacity, so the buffer is allocated only once
+		m_buffer.clear();
+	}
+}
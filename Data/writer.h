@@ -0,0 +1,63 @@
+//
+//  writer.h
+//  BINS_workstation
+//
+//  Created by Denis Fedorov on 02.02.2023.
+//
+
+#pragma once
+#include <format>
+#include <string>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+
+// Writer class is a buffered output file. Text is formatted with std::format_to() straight into one large
+// buffer allocated once, the buffer goes to the file in big blocks when it is full. Thus writing a row
+// costs neither temporary std::string objects nor heap allocations nor a stream call per value.
+//
+// Class properties:
+// - m_file    : output file;
+// - m_buffer  : formatted but not yet written text;
+// - m_capacity: size of the buffer, it is written to the file once it grows over this size.
+//
+// Class behaviors:
+// - open()  : open the file, text or binary, returns false if file could not be opened;
+// - print() : format given values to the buffer, same as std::format();
+// - write() : append raw bytes to the buffer;
+// - buffer(): return the buffer to append to it directly, commit() must be called afterwards;
+// - commit(): write the buffer to the file if it is full;
+// - close() : write the rest of the buffer and close the file, returns false if writing failed.
+
+namespace ws::data
+{
+	class writer
+	{
+	public:
+		explicit writer(std::size_t = 1 << 20);
+		writer(const writer &) = delete;
+		writer & operator = (const writer &) = delete;
+		~writer();
+	public:
+		bool open(const std::string_view, bool = false);
+		template <typename... Args>
+		void print(std::format_string<Args...>, Args && ...);
+		void write(std::string_view);
+		std::string & buffer();
+		void commit();
+		bool close();
+	private:
+		void flush();
+	private:
+		std::ofstream m_file;
+		std::string m_buffer;
+		std::size_t m_capacity;
+	};
+
+	template <typename... Args>
+	void writer::print(std::format_string<Args...> format, Args && ... args)
+	{
+		std::format_to(std::back_inserter(m_buffer), format, std::forward<Args>(args)...);
+		this->commit();
+	}
+}